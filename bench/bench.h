@@ -0,0 +1,64 @@
+// lemuen/bench/bench.h - shared timing and reporting for benchmark programs
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Summary of one benchmark case (times are per operation)
+typedef struct {
+    const char *name;
+    int samples;
+    double min_ns;
+    double median_ns;
+    double p99_ns;
+    double ops_per_sec;         // From the median
+} bench_result_t;
+
+// Monotonic clock in nanoseconds
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static inline int bench_compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Sort @samples (ns per operation) and summarize them
+static inline bench_result_t bench_summarize(const char *name, double *samples, int count) {
+    bench_result_t result = { name, count, 0, 0, 0, 0 };
+    if (count <= 0) return result;
+
+    qsort(samples, count, sizeof(double), bench_compare_double);
+    result.min_ns = samples[0];
+    result.median_ns = samples[count / 2];
+    result.p99_ns = samples[(int)((count - 1) * 0.99)];
+    result.ops_per_sec = result.median_ns > 0 ? 1e9 / result.median_ns : 0;
+    return result;
+}
+
+// Print one result as a table row
+static inline void bench_print(const bench_result_t *r) {
+    printf("  %-28s min %10.1f ns  median %10.1f ns  p99 %10.1f ns  %12.0f ops/s\n",
+           r->name, r->min_ns, r->median_ns, r->p99_ns, r->ops_per_sec);
+}
+
+// Write results as a JSON document
+static inline void bench_write_json(FILE *out, const char *suite,
+                                    const bench_result_t *results, int count) {
+    fprintf(out, "{\n  \"suite\": \"%s\",\n  \"results\": [\n", suite);
+    for (int i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"samples\": %d, \"min_ns\": %.1f, "
+                     "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"ops_per_sec\": %.1f}%s\n",
+                r->name, r->samples, r->min_ns, r->median_ns, r->p99_ns,
+                r->ops_per_sec, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+#endif // BENCH_H
@@ -0,0 +1,111 @@
+// lemuen/bench/bench_glob.c - pathname expansion over a large directory and a tree
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <glob.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+#include "bench.h"
+#include "pathglob.h"
+
+#define DEFAULT_FILES 200000
+#define TREE_DIRS 40            // Per level, two levels deep
+#define TREE_FILES 25           // Per leaf directory
+#define ROUNDS 5
+
+static const char *patterns[] = {
+    "spool/*", "spool/*.log", "spool/job_1234?.*", "spool/job_[0-4]*7.tmp",
+    "tree/**/*.c", "tree/d_1*/**/x_2?.h", "tree/**/",
+};
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+// Helper: create an empty file
+static int touch(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) return -1;
+    close(fd);
+    return 0;
+}
+
+// Helper: build the spool directory and the source-like tree
+static int populate(int files) {
+    char path[256];
+    if (mkdir("spool", 0755) != 0 || mkdir("tree", 0755) != 0) return -1;
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "spool/job_%d.%s", i, i % 3 ? "log" : "tmp");
+        if (touch(path) != 0) return -1;
+    }
+    for (int a = 0; a < TREE_DIRS; a++) {
+        snprintf(path, sizeof(path), "tree/d_%d", a);
+        if (mkdir(path, 0755) != 0) return -1;
+        for (int b = 0; b < TREE_DIRS; b++) {
+            snprintf(path, sizeof(path), "tree/d_%d/e_%d", a, b);
+            if (mkdir(path, 0755) != 0) return -1;
+            for (int f = 0; f < TREE_FILES; f++) {
+                snprintf(path, sizeof(path), "tree/d_%d/e_%d/x_%d.%s", a, b, f, f % 2 ? "c" : "h");
+                if (touch(path) != 0) return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int files = argc > 1 ? atoi(argv[1]) : DEFAULT_FILES;
+    char dir[] = "/tmp/lemuen_glob_bench.XXXXXX";
+    if (files <= 0) files = DEFAULT_FILES;
+
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        perror(dir);
+        return 1;
+    }
+    double start = bench_now_ns();
+    if (populate(files) != 0) {
+        perror("populate");
+        return 1;
+    }
+    printf("setup   %d spool files, %d tree files  %8.1f ms\n", files,
+           TREE_DIRS * TREE_DIRS * TREE_FILES, (bench_now_ns() - start) / 1e6);
+
+    int mismatch = 0;
+    for (int p = 0; p < COUNT(patterns); p++) {
+        double ours[ROUNDS], libc[ROUNDS];
+        size_t count = 0, libc_count = 0;
+        for (int i = 0; i < ROUNDS; i++) {
+            arena_t *arena = arena_create(0);
+            char **matches;
+            double t = bench_now_ns();
+            count = pathglob_expand(arena, patterns[p], &matches);
+            ours[i] = bench_now_ns() - t;
+            arena_destroy(arena);
+
+            // glob(3) has no **; it reads it as *, so only compare timings
+            glob_t g;
+            t = bench_now_ns();
+            libc_count = glob(patterns[p], 0, NULL, &g) == 0 ? g.gl_pathc : 0;
+            libc[i] = bench_now_ns() - t;
+            globfree(&g);
+        }
+        bench_result_t r = bench_summarize(patterns[p], ours, ROUNDS);
+        bench_result_t l = bench_summarize(patterns[p], libc, ROUNDS);
+        printf("glob    %-24s %7zu matches  median %8.2f ms   glob(3) %7zu  %8.2f ms\n",
+               patterns[p], count, r.median_ns / 1e6, libc_count, l.median_ns / 1e6);
+        if (!strstr(patterns[p], "**") && count != libc_count) mismatch = 1;
+    }
+
+    if (chdir("/") == 0) {
+        char command[64];
+        snprintf(command, sizeof(command), "rm -rf %s", dir);
+        if (system(command) != 0) fprintf(stderr, "could not remove %s\n", dir);
+    }
+    if (mismatch) {
+        fprintf(stderr, "match counts differ from glob(3)\n");
+        return 1;
+    }
+    return 0;
+}
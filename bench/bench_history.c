@@ -0,0 +1,132 @@
+// lemuen/bench/bench_history.c - history store: concurrent appends and load time
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "histindex.h"
+#include "histstore.h"
+
+#define DEFAULT_ENTRIES 1000000
+#define DEFAULT_WRITERS 4
+#define SEARCH_ROUNDS 200
+#define SEARCH_RESULTS 16
+
+static const char *verbs[] = {
+    "make -C", "git log --oneline", "vim", "grep -rn TODO", "cd", "ls -la", "cat",
+    "ssh build@host", "docker run --rm -it", "python3 -m pytest", "cargo build -p", "less",
+};
+static const char *patterns[] = { "ls", "git", "pytest", "module_42", "TODO src/module_7", "nothing-like-this" };
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+// Helper: a command line from a skewed mix, so some lines repeat often and
+// most are rare, as in real histories
+static void make_line(char *line, size_t size, unsigned *seed) {
+    unsigned r = rand_r(seed);
+    double x = (double)(r % 10000) / 10000.0;
+    int arg = (int)(x * x * x * 20000);
+    snprintf(line, size, "%s src/module_%d/file_%d.c", verbs[r % COUNT(verbs)], arg % 500, arg);
+}
+
+// Helper: append @count entries (runs in a child)
+static int append_entries(const char *path, int writer, int count) {
+    char line[128];
+    unsigned seed = (unsigned)writer + 1;
+    if (histstore_open(path) != 0) {
+        perror(path);
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        make_line(line, sizeof(line), &seed);
+        if (histstore_append(line, 1700000000 + i, i % 3, "/home/user/project") != 0) {
+            perror("histstore_append");
+            return 1;
+        }
+    }
+    histstore_close();
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int entries = argc > 1 ? atoi(argv[1]) : DEFAULT_ENTRIES;
+    int writers = argc > 2 ? atoi(argv[2]) : DEFAULT_WRITERS;
+    char path[] = "/tmp/lemuen_history_bench.XXXXXX";
+
+    if (entries <= 0) entries = DEFAULT_ENTRIES;
+    if (writers <= 0) writers = DEFAULT_WRITERS;
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    // Several shells appending to one file at once
+    double start = bench_now_ns();
+    for (int w = 0; w < writers; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(append_entries(path, w, entries / writers));
+        }
+    }
+    int failed = 0, status;
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+    }
+    double append_ns = bench_now_ns() - start;
+    int expected = entries / writers * writers;
+    printf("append  %d entries from %d writers  %8.1f ms  %6.2f us/entry\n",
+           expected, writers, append_ns / 1e6, append_ns / expected / 1e3);
+
+    // Start-up cost: map and index the whole file
+    start = bench_now_ns();
+    int opened = histstore_open(path);
+    double open_ns = bench_now_ns() - start;
+    size_t count = histstore_count();
+    printf("open    %zu entries  %8.2f ms\n", count, open_ns / 1e6);
+
+    // Every record must have survived the concurrent writers intact
+    start = bench_now_ns();
+    size_t intact = 0;
+    hist_entry_t entry;
+    for (size_t i = 0; i < count; i++) {
+        if (histstore_get(i, &entry) == 0 && strstr(entry.line, " src/module_") &&
+            strcmp(entry.cwd, "/home/user/project") == 0) {
+            intact++;
+        }
+    }
+    double scan_ns = bench_now_ns() - start;
+    printf("scan    %zu intact entries  %8.2f ms\n", intact, scan_ns / 1e6);
+
+    // Search index: built on first use, then one query per keystroke
+    start = bench_now_ns();
+    histindex_update(SIZE_MAX);
+    printf("index   %zu entries  %8.2f ms\n", count, (bench_now_ns() - start) / 1e6);
+    for (int p = 0; p < COUNT(patterns); p++) {
+        size_t results[SEARCH_RESULTS];
+        double times[SEARCH_ROUNDS];
+        int found = 0;
+        for (int i = 0; i < SEARCH_ROUNDS; i++) {
+            double t = bench_now_ns();
+            found = histindex_search(patterns[p], results, SEARCH_RESULTS);
+            times[i] = bench_now_ns() - t;
+        }
+        bench_result_t r = bench_summarize(patterns[p], times, SEARCH_ROUNDS);
+        printf("search  %-20s %2d hits  median %8.1f us  p99 %8.1f us\n",
+               patterns[p], found, r.median_ns / 1e3, r.p99_ns / 1e3);
+    }
+    histindex_destroy();
+
+    histstore_close();
+    unlink(path);
+    if (failed || opened != 0 || count != (size_t)expected || intact != count) {
+        fprintf(stderr, "history store lost or damaged entries\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+// lemuen/bench/bench_lexer.c - tokenizer throughput on long command lines
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "arena.h"
+#include "lexer.h"
+#include "lexscan.h"
+#include "utils.h"
+
+#define DEFAULT_ROUNDS 15
+
+// Helper: build a generated-script style line of about @size bytes:
+// long argument lists, quoted JSON and a pipeline tail
+static char *make_line(size_t size) {
+    static const char *pieces[] = {
+        "--output=/var/tmp/build/artifact_%zu.json ",
+        "'{\"id\": %zu, \"name\": \"item\", \"tags\": [\"a\", \"b\"], \"ok\": true}' ",
+        "\"$HOME/projects/src/module_%zu/file.c\" ",
+        "-DFEATURE_%zu=1 ",
+        "path/to/some/deeply/nested/directory/file_%zu.txt ",
+    };
+    char *line = malloc(size + 256);
+    if (!line) return NULL;
+
+    size_t len = (size_t)sprintf(line, "printf %%s ");
+    for (size_t i = 0; len < size; i++) {
+        len += (size_t)sprintf(line + len, pieces[i % 5], i);
+    }
+    strcpy(line + len, "| wc -c");
+    return line;
+}
+
+// The pre-lexer approach: strstr for && and ||, strtok_r on |, strstr/strchr
+// for redirections in every segment, then split_string on blanks
+static size_t legacy_scan(const char *line) {
+    char *buffer = strdup(line);
+    size_t words = 0;
+
+    if (strstr(buffer, "&&") || strstr(buffer, "||")) {
+        free(buffer);
+        return 0;
+    }
+    char *saveptr = NULL;
+    for (char *segment = strtok_r(buffer, "|", &saveptr); segment;
+         segment = strtok_r(NULL, "|", &saveptr)) {
+        char *redir = strstr(segment, ">>");
+        if (!redir) redir = strchr(segment, '>');
+        if (redir) *redir = '\0';
+        redir = strchr(segment, '<');
+        if (redir) *redir = '\0';
+
+        int count;
+        char **args = split_string(segment, " \t", &count);
+        words += count;
+        free(args);
+    }
+    free(buffer);
+    return words;
+}
+
+// Helper: run the lexer over a line; returns the token count and, when
+// @checksum is not NULL, a checksum of the token stream
+static size_t lexer_scan(arena_t *arena, const char *line, unsigned long *checksum) {
+    lexer_t lexer;
+    token_t token;
+    size_t count = 0;
+    unsigned long sum = 0;
+
+    lexer_init(&lexer, arena, line);
+    while (lexer_next(&lexer, &token) == 0 && token.type != TOK_END) {
+        count++;
+        if (!checksum) continue;
+        sum = sum * 31 + token.type;
+        for (const char *p = token.word; p && *p; p++) sum = sum * 31 + (unsigned char)*p;
+    }
+    arena_reset(arena);
+    if (checksum) *checksum = sum;
+    return count;
+}
+
+// Helper: report one timed case
+static void report(const char *name, size_t bytes, double *samples, int rounds) {
+    qsort(samples, rounds, sizeof(double), bench_compare_double);
+    double median = samples[rounds / 2];
+    printf("  %-8s median %10.1f us  min %10.1f us  %8.1f MB/s\n",
+           name, median / 1e3, samples[0] / 1e3, bytes / (median / 1e9) / 1e6);
+}
+
+// Helper: check every kernel finds the same offsets on random input
+static int verify_kernels(void) {
+    static const char alphabet[] = "abc $|&;<>'\"\\\t\n\001xyz{}\xc3\xa9";
+    char buf[300];
+    lexscan_impl_t impls[] = { LEXSCAN_SCALAR, LEXSCAN_SSE2, LEXSCAN_AVX2 };
+
+    srand(42);
+    for (int round = 0; round < 20000; round++) {
+        size_t len = (size_t)(rand() % 300);
+        int density = 1 + rand() % 64;
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = rand() % density ? 'a' + rand() % 26
+                                      : alphabet[rand() % (sizeof(alphabet) - 1)];
+        }
+        size_t expect_u = 0, expect_d = 0, expect_q = 0;
+        for (size_t k = 0; k < 3; k++) {
+            if (lexscan_set_impl(impls[k]) != 0) continue;
+            size_t u = lexscan_unquoted(buf, len), d = lexscan_dquoted(buf, len);
+            size_t q = lexscan_squoted(buf, len);
+            if (k == 0) {
+                expect_u = u;
+                expect_d = d;
+                expect_q = q;
+            } else if (u != expect_u || d != expect_d || q != expect_q) {
+                fprintf(stderr, "kernel %s disagrees with scalar\n", lexscan_impl_name(impls[k]));
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : DEFAULT_ROUNDS;
+    static const size_t sizes[] = { 1 << 10, 64 << 10, 1 << 20 };
+    lexscan_impl_t kernels[] = { LEXSCAN_SCALAR, LEXSCAN_SSE2, LEXSCAN_AVX2 };
+    arena_t *arena = arena_create(0);
+
+    if (rounds <= 0) rounds = DEFAULT_ROUNDS;
+    if (verify_kernels() != 0) return 1;
+    printf("kernels agree on 20000 random buffers\n");
+
+    double *samples = malloc(rounds * sizeof(double));
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        char *line = make_line(sizes[s]);
+        size_t bytes = strlen(line);
+        int inner = (int)((4 << 20) / bytes) + 1;   // ~4 MB per sample
+        printf("line %zu bytes\n", bytes);
+
+        for (int r = 0; r < rounds; r++) {
+            double start = bench_now_ns();
+            for (int i = 0; i < inner; i++) legacy_scan(line);
+            samples[r] = (bench_now_ns() - start) / inner;
+        }
+        report("strtok", bytes, samples, rounds);
+
+        unsigned long first_sum = 0;
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            if (lexscan_set_impl(kernels[k]) != 0) {
+                printf("  %-8s (not supported by this CPU)\n", lexscan_impl_name(kernels[k]));
+                continue;
+            }
+            unsigned long sum;
+            lexer_scan(arena, line, &sum);
+            if (k == 0) first_sum = sum;
+            else if (sum != first_sum) {
+                fprintf(stderr, "%s produced different tokens\n", lexscan_impl_name(kernels[k]));
+                return 1;
+            }
+            for (int r = 0; r < rounds; r++) {
+                double start = bench_now_ns();
+                for (int i = 0; i < inner; i++) lexer_scan(arena, line, NULL);
+                samples[r] = (bench_now_ns() - start) / inner;
+            }
+            report(lexscan_impl_name(kernels[k]), bytes, samples, rounds);
+        }
+        free(line);
+    }
+
+    free(samples);
+    arena_destroy(arena);
+    return 0;
+}
@@ -0,0 +1,68 @@
+// lemuen/bench/bench_spawn.c - launch latency: posix_spawn vs fork+exec
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "launch.h"
+
+#define DEFAULT_ITERATIONS 2000
+
+// Helper: time launch+wait of /bin/true with one backend
+static void run_case(launch_backend_t backend, size_t ballast_mb, int iterations) {
+    char *argv[] = { "true", NULL };
+    double *samples = malloc(iterations * sizeof(double));
+    if (!samples) return;
+
+    launch_set_backend(backend);
+    for (int i = 0; i < iterations; i++) {
+        double start = bench_now_ns();
+        pid_t pid = launch_process("/bin/true", argv, NULL);
+        if (pid == -1) {
+            perror("launch_process");
+            free(samples);
+            return;
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        samples[i] = bench_now_ns() - start;
+    }
+
+    qsort(samples, iterations, sizeof(double), bench_compare_double);
+    printf("%-6s  rss+%4zu MB  median %8.1f us  p99 %8.1f us  min %8.1f us\n",
+           launch_backend_name(backend), ballast_mb,
+           samples[iterations / 2] / 1e3,
+           samples[(int)(iterations * 0.99)] / 1e3,
+           samples[0] / 1e3);
+    free(samples);
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    static const size_t ballast_sizes[] = { 0, 64, 512 };
+    char *ballast = NULL;
+
+    if (iterations <= 0) iterations = DEFAULT_ITERATIONS;
+
+    // Grow the resident set step by step; fork cost scales with it, spawn's does not
+    for (size_t i = 0; i < sizeof(ballast_sizes) / sizeof(ballast_sizes[0]); i++) {
+        size_t mb = ballast_sizes[i];
+        if (mb > 0) {
+            free(ballast);
+            ballast = malloc(mb << 20);
+            if (!ballast) {
+                fprintf(stderr, "cannot allocate %zu MB ballast\n", mb);
+                break;
+            }
+            memset(ballast, 1, mb << 20);
+        }
+        run_case(LAUNCH_SPAWN, mb, iterations);
+        run_case(LAUNCH_FORK, mb, iterations);
+    }
+
+    free(ballast);
+    return 0;
+}
@@ -0,0 +1,360 @@
+// lemuen/bench/bench_suite.c - microbenchmarks for the shell's hot paths
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "arena.h"
+#include "builtins.h"
+#include "cmdhash.h"
+#include "complete.h"
+#include "executor.h"
+#include "launch.h"
+#include "lexer.h"
+#include "parser.h"
+#include "utils.h"
+
+#define DEFAULT_SAMPLES 200
+#define MIN_SAMPLE_NS   20000.0    // Batch operations until a sample takes this long
+#define ECHO_MANY_ARGS  1000
+
+typedef void (*bench_op_t)(void);
+
+// Shared state for the cases
+static arena_t *arena;
+static command_t echo_cmd, echo_many_cmd, cd_cmd, external_cmd, timeout_cmd, append_cmd;
+static command_t test_cmd, printf_cmd, herestring_cmd;
+static const char *timeout_path;   // coreutils timeout, if installed
+
+// Fixed corpora
+static const char *parse_corpus[] = {
+    "ls -la /tmp",
+    "echo $HOME ${USER} done",
+    "cat file.txt | grep -v foo | sort | uniq -c > out.txt",
+    "make -j8 && ./run --flag='x y' || echo \"failed: $?\"; echo done &",
+    "printf '%s\\n' \"$HOME/a\" \"$HOME/b\" 2> err.log | tee log.txt >> all.log",
+};
+static const char *expand_corpus[] = {
+    "plain-word-without-variables",
+    "$HOME",
+    "${HOME}/src/${USER}/project",
+    "prefix-$HOME-$PATH-$SHELL-suffix",
+    "status=$? missing=$NO_SUCH_VARIABLE_SET",
+};
+static const char *builtin_names[] = { "cd", "ls", "echo", "grep", "export", "make", "hash", "cat" };
+static char long_line[4096];
+
+// Lexer words holding $(pwd), $(/bin/pwd), $(pwd; :) and $((1 + 2 * 3))
+static char subst_builtin[64], subst_spawn[64], subst_fork[64], subst_arith[64];
+
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static void op_parse(void) {
+    for (int i = 0; i < COUNT(parse_corpus); i++) {
+        int err;
+        parse_line(arena, parse_corpus[i], &err);
+    }
+    arena_reset(arena);
+}
+
+static void op_parse_long(void) {
+    int err;
+    parse_line(arena, long_line, &err);
+    arena_reset(arena);
+}
+
+static void op_expand(void) {
+    for (int i = 0; i < COUNT(expand_corpus); i++) {
+        expand_env_var_in_string(arena, expand_corpus[i]);
+    }
+    arena_reset(arena);
+}
+
+// Helper: expand a word holding a command substitution
+static void expand_subst(const char *word) {
+    expand_env_var_in_string(arena, word);
+    arena_reset(arena);
+}
+
+static void op_subst_builtin(void) {
+    expand_subst(subst_builtin);
+}
+
+static void op_subst_spawn(void) {
+    expand_subst(subst_spawn);
+}
+
+static void op_subst_fork(void) {
+    expand_subst(subst_fork);
+}
+
+static void op_subst_arith(void) {
+    expand_subst(subst_arith);
+}
+
+static void op_find_hashed(void) {
+    find_command("ls");
+}
+
+static void op_find_unhashed(void) {
+    cmdhash_remove("ls");
+    find_command("ls");
+}
+
+static void op_find_missing(void) {
+    find_command("no-such-command-anywhere");
+}
+
+static void op_is_builtin(void) {
+    static command_t cmd;
+    static char *args[2];
+    for (int i = 0; i < COUNT(builtin_names); i++) {
+        args[0] = (char *)builtin_names[i];
+        cmd.args = args;
+        cmd.argc = 1;
+        is_builtin(&cmd);
+    }
+}
+
+static void op_run_echo(void) {
+    run_builtin(&echo_cmd);
+}
+
+static void op_run_echo_many(void) {
+    run_builtin(&echo_many_cmd);
+}
+
+static void op_run_test(void) {
+    run_builtin(&test_cmd);
+}
+
+static void op_run_printf(void) {
+    run_builtin(&printf_cmd);
+}
+
+static void op_run_cd(void) {
+    run_builtin(&cd_cmd);
+}
+
+// echo >> file through the executor: redirected in the shell itself
+static void op_append_in_shell(void) {
+    execute_single_command(&append_cmd, arena);
+}
+
+// read x <<< word: a sealed memfd on stdin for the length of the builtin
+static void op_herestring(void) {
+    execute_single_command(&herestring_cmd, arena);
+}
+
+// The same command in a forked child, as builtins with redirections used to run
+static void op_append_forked(void) {
+    execute_with_redirection(&append_cmd);
+}
+
+static void op_spawn_wait(void) {
+    int status;
+    pid_t pid = launch_process("/bin/true", external_cmd.args, NULL);
+    if (pid > 0) waitpid(pid, &status, 0);
+}
+
+static void op_timeout_builtin(void) {
+    run_builtin(&timeout_cmd);
+}
+
+// The same limit through an extra timeout process (skipped if not installed)
+static void op_timeout_wrapper(void) {
+    int status;
+    if (!timeout_path) return;
+    pid_t pid = launch_process(timeout_path, timeout_cmd.args, NULL);
+    if (pid > 0) waitpid(pid, &status, 0);
+}
+
+// Helper: complete the last word of @line and free the matches
+static void complete_last_word(const char *line) {
+    int end = (int)strlen(line);
+    int start = end;
+    while (start > 0 && line[start - 1] != ' ') start--;
+    char **matches = complete_word(line, start, end);
+    for (int i = 0; matches && matches[i]; i++) free(matches[i]);
+    free(matches);
+}
+
+static void op_complete_command(void) {
+    complete_last_word("g");
+}
+
+static void op_complete_path(void) {
+    complete_last_word("ls /usr/lib/x");
+}
+
+// One benchmark case; @per_op divides a call into that many operations
+typedef struct {
+    const char *name;
+    bench_op_t op;
+    int per_op;
+} bench_case_t;
+
+static const bench_case_t cases[] = {
+    { "parse_line (5-line corpus)",  op_parse,         5 },
+    { "parse_line (4 KB line)",      op_parse_long,    1 },
+    { "expand_env_var_in_string",    op_expand,        5 },
+    { "$(pwd) (in the shell)",       op_subst_builtin, 1 },
+    { "$(/bin/pwd) (spawned)",       op_subst_spawn,   1 },
+    { "$(pwd; :) (subshell)",        op_subst_fork,    1 },
+    { "$((1 + 2 * 3))",              op_subst_arith,   1 },
+    { "find_command (hashed)",       op_find_hashed,   1 },
+    { "find_command (index)",        op_find_unhashed, 1 },
+    { "find_command (missing)",      op_find_missing,  1 },
+    { "is_builtin",                  op_is_builtin,    8 },
+    { "run_builtin echo",            op_run_echo,      1 },
+    { "run_builtin echo (1000 args)", op_run_echo_many, 1 },
+    { "run_builtin cd .",            op_run_cd,        1 },
+    { "run_builtin [ -f /etc/passwd ]", op_run_test,   1 },
+    { "run_builtin printf '%s=%5d'", op_run_printf,    1 },
+    { "echo x >> /dev/null (shell)", op_append_in_shell, 1 },
+    { "echo x >> /dev/null (fork)",  op_append_forked, 1 },
+    { "read x <<< word (shell)",     op_herestring,    1 },
+    { "spawn+wait /bin/true",        op_spawn_wait,    1 },
+    { "timeout 5 true (builtin)",    op_timeout_builtin, 1 },
+    { "timeout 5 true (coreutils)",  op_timeout_wrapper, 1 },
+    { "complete_word command 'g'",   op_complete_command, 1 },
+    { "complete_word path /usr/lib/x", op_complete_path, 1 },
+};
+
+// Helper: time one case; each sample runs enough calls to last MIN_SAMPLE_NS
+static bench_result_t run_case(const bench_case_t *c, int samples) {
+    double *times = malloc(samples * sizeof(double));
+    int batch = 1;
+
+    c->op();  // Warm up caches and lazily built tables
+    for (;;) {
+        double start = bench_now_ns();
+        for (int i = 0; i < batch; i++) c->op();
+        if (bench_now_ns() - start >= MIN_SAMPLE_NS || batch >= (1 << 20)) break;
+        batch *= 2;
+    }
+
+    for (int s = 0; s < samples; s++) {
+        double start = bench_now_ns();
+        for (int i = 0; i < batch; i++) c->op();
+        times[s] = (bench_now_ns() - start) / ((double)batch * c->per_op);
+    }
+
+    bench_result_t result = bench_summarize(c->name, times, samples);
+    free(times);
+    return result;
+}
+
+// Helper: spell $(@text) the way the lexer leaves it in a word
+static void make_subst(char *word, size_t size, const char *text) {
+    snprintf(word, size, "%c%c%s%c%c", LEX_CTLESC, LEX_CMDSUB_OPEN, text,
+             LEX_CTLESC, LEX_CMDSUB_CLOSE);
+}
+
+// Helper: build the fixed inputs
+static void setup(void) {
+    static char *echo_args[] = { "echo", "hello", "world", NULL };
+    static char *cd_args[] = { "cd", ".", NULL };
+    static char *true_args[] = { "true", NULL };
+    static char *timeout_args[] = { "timeout", "5", "/bin/true", NULL };
+    static char *append_args[] = { "echo", "x", NULL };
+    static char *test_args[] = { "[", "-f", "/etc/passwd", "]", NULL };
+    static char *printf_args[] = { "printf", "%s=%5d\\n", "key", "42", "other", "7", NULL };
+    static char *read_args[] = { "read", "x", NULL };
+    static redirect_t append_redirect = { REDIR_APPEND, 1, "/dev/null", 0, NULL, NULL };
+    static redirect_t herestring_redirect = { REDIR_HERESTRING, 0, "hello world", 0, NULL, NULL };
+
+    arena = arena_create(0);
+    echo_cmd.args = echo_args;
+    echo_cmd.argc = 3;
+    static char *echo_many_args[ECHO_MANY_ARGS + 2];
+    echo_many_args[0] = "echo";
+    for (int i = 1; i <= ECHO_MANY_ARGS; i++) echo_many_args[i] = "argument";
+    echo_many_cmd.args = echo_many_args;
+    echo_many_cmd.argc = ECHO_MANY_ARGS + 1;
+    cd_cmd.args = cd_args;
+    cd_cmd.argc = 2;
+    external_cmd.args = true_args;
+    external_cmd.argc = 1;
+    timeout_cmd.args = timeout_args;
+    timeout_cmd.argc = 3;
+    test_cmd.args = test_args;
+    test_cmd.argc = 4;
+    printf_cmd.args = printf_args;
+    printf_cmd.argc = 6;
+    append_cmd.args = append_args;
+    append_cmd.argc = 2;
+    append_cmd.redirects = &append_redirect;
+    herestring_cmd.args = read_args;
+    herestring_cmd.argc = 2;
+    herestring_cmd.redirects = &herestring_redirect;
+    make_subst(subst_builtin, sizeof(subst_builtin), "pwd");
+    make_subst(subst_spawn, sizeof(subst_spawn), "/bin/pwd");
+    make_subst(subst_fork, sizeof(subst_fork), "pwd; :");
+    make_subst(subst_arith, sizeof(subst_arith), "(1 + 2 * 3)");
+    timeout_path = find_command("timeout");  // Also builds the PATH index
+    complete_init();
+    if (timeout_path) timeout_path = strdup(timeout_path);
+
+    size_t len = 0;
+    len += (size_t)snprintf(long_line, sizeof(long_line), "gcc -O2");
+    for (int i = 0; len + 64 < sizeof(long_line); i++) {
+        len += (size_t)snprintf(long_line + len, sizeof(long_line) - len,
+                                " -DOPT_%d=\"$HOME/x\" src/file_%d.c", i, i);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int samples = DEFAULT_SAMPLES;
+    const char *json_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--samples N] [--json FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (samples <= 0) samples = DEFAULT_SAMPLES;
+
+    setup();
+
+    // Builtins write to stdout; keep the report readable
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+    bench_result_t results[COUNT(cases)];
+    for (int i = 0; i < COUNT(cases); i++) {
+        dup2(devnull, STDOUT_FILENO);
+        results[i] = run_case(&cases[i], samples);
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+        bench_print(&results[i]);
+        fflush(stdout);
+    }
+    close(devnull);
+    close(saved_stdout);
+
+    if (json_path) {
+        FILE *out = fopen(json_path, "w");
+        if (!out) {
+            perror(json_path);
+            return 1;
+        }
+        bench_write_json(out, "lemuen", results, COUNT(cases));
+        fclose(out);
+        printf("results written to %s\n", json_path);
+    }
+
+    cleanup_find_command_cache();
+    arena_destroy(arena);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator for data that lives exactly as long as one input line.
+// Allocations are never freed individually; arena_reset releases them all.
+typedef struct arena arena_t;
+
+// Create an arena whose chunks hold at least @chunk_size bytes (0 = default)
+arena_t *arena_create(size_t chunk_size);
+
+// Allocate @size bytes aligned for any type. Never returns NULL (exits on OOM).
+void *arena_alloc(arena_t *arena, size_t size);
+
+// Zero-filled arena_alloc
+void *arena_calloc(arena_t *arena, size_t count, size_t size);
+
+// Resize an allocation; grows in place when it is the most recent one
+void *arena_realloc(arena_t *arena, void *ptr, size_t old_size, size_t new_size);
+
+// Copy a string / the first @len bytes of a string into the arena
+char *arena_strdup(arena_t *arena, const char *str);
+char *arena_strndup(arena_t *arena, const char *str, size_t len);
+
+// String built up in an arena; the most recent allocation grows in place
+typedef struct {
+    arena_t *arena;
+    char *data;                 // NUL-terminated contents
+    size_t len;
+    size_t cap;
+} arena_str_t;
+
+// Start an empty string
+void arena_str_init(arena_str_t *str, arena_t *arena);
+
+// Append @len bytes / one byte
+void arena_str_append(arena_str_t *str, const char *text, size_t len);
+void arena_str_putc(arena_str_t *str, char c);
+
+// Release every allocation at once; chunks are kept for the next line
+void arena_reset(arena_t *arena);
+
+// Largest number of bytes ever in use between two resets
+size_t arena_high_water(const arena_t *arena);
+
+// Free the arena and all of its chunks
+void arena_destroy(arena_t *arena);
+
+#endif // ARENA_H
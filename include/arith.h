@@ -0,0 +1,13 @@
+#ifndef ARITH_H
+#define ARITH_H
+
+// Arithmetic expansion $((expr)) on 64-bit integers, with C's operators
+// and precedence: unary + - ! ~, * / %, + -, << >>, < <= > >=, == !=,
+// &, ^, |, &&, || and ?:. Numbers are decimal, 0x hex or 0 octal; a bare
+// name is a variable whose value is read as a number (0 if unset or empty).
+
+// Evaluate @expr into *@value. Returns 0, or -1 after printing an error
+// (syntax error, division by zero, a variable that is not a number).
+int arith_eval(const char *expr, long long *value);
+
+#endif // ARITH_H
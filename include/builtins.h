@@ -6,16 +6,24 @@
 // Builtin command function type
 typedef int (*builtin_func_t)(command_t *cmd);
 
+// Builtin flags
+#define BUILTIN_PURE 0x01       // Only writes output: changes no shell state, starts no processes
+
 // Builtin command structure
 typedef struct {
     const char *name;
     builtin_func_t func;
     const char *help;
+    int flags;
 } builtin_t;
 
 // Check if command is a builtin
 int is_builtin(command_t *cmd);
 
+// Check if command is a BUILTIN_PURE builtin, which $(...) can run in the
+// shell instead of a subshell
+int is_pure_builtin(command_t *cmd);
+
 // Run builtin command
 int run_builtin(command_t *cmd);
 
@@ -0,0 +1,45 @@
+#ifndef CMDHASH_H
+#define CMDHASH_H
+
+#include <stddef.h>
+
+// Hashed command location: command name -> resolved path
+typedef struct cmdhash_entry {
+    char *name;                 // Command name as typed
+    char *path;                 // Resolved executable path
+    unsigned long hits;         // Lookups answered by this entry
+    struct cmdhash_entry *next; // Next entry in the same bucket
+} cmdhash_entry_t;
+
+// Lookup counters
+typedef struct {
+    unsigned long hits;         // Lookups answered from the table
+    unsigned long misses;       // Lookups that had to search PATH
+    size_t entries;             // Current number of entries
+} cmdhash_stats_t;
+
+// Look up a command; returns its path (owned by the table) or NULL
+const char *cmdhash_lookup(const char *name);
+
+// Add or replace an entry; returns the stored path
+const char *cmdhash_insert(const char *name, const char *path);
+
+// Remove one entry (e.g. after exec reported ENOENT)
+void cmdhash_remove(const char *name);
+
+// Remove all entries (e.g. after PATH changed)
+void cmdhash_clear(void);
+
+// Record a lookup that missed the table
+void cmdhash_count_miss(void);
+
+// Get lookup counters
+cmdhash_stats_t cmdhash_get_stats(void);
+
+// Print the table in `hash` builtin format
+void cmdhash_print(void);
+
+// Free the table
+void cmdhash_destroy(void);
+
+#endif // CMDHASH_H
@@ -0,0 +1,25 @@
+#ifndef CMDSUBST_H
+#define CMDSUBST_H
+
+#include <stddef.h>
+#include "arena.h"
+
+// Command substitution: run the text of a $(...) and return its output
+// with trailing newlines removed (NUL bytes are dropped), allocated from
+// @arena; *@len receives its length. $((expr)) is arithmetic. Pure
+// builtins, bare assignments and $(< file) run in the shell, a single
+// other command is spawned directly, and anything else runs in a forked
+// subshell.
+char *cmdsubst_run(arena_t *arena, const char *text, size_t *len);
+
+// Take the exit status of the last command substitution that ran since
+// the previous call (a command made only of assignments returns it).
+// Returns 1 and sets *@status if there was one, 0 otherwise.
+int cmdsubst_take_status(int *status);
+
+// Check whether an expansion error (such as division by zero in $((...)))
+// happened since the previous call; the command being expanded must not
+// run. Returns 1 if so, 0 otherwise.
+int cmdsubst_take_error(void);
+
+#endif // CMDSUBST_H
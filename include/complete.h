@@ -0,0 +1,16 @@
+#ifndef COMPLETE_H
+#define COMPLETE_H
+
+// Install the completion engine in readline. Command names come from a
+// prefix trie kept in step with the PATH index and the builtin table.
+void complete_init(void);
+
+// Completions for the word at [@start, @end) of @line, in readline's
+// format: a malloc'd NULL-terminated array whose first element is the
+// longest common prefix of the others. Returns NULL when nothing matches.
+char **complete_word(const char *line, int start, int end);
+
+// Free the trie and cached directory listing
+void complete_destroy(void);
+
+#endif // COMPLETE_H
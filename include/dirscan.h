@@ -0,0 +1,16 @@
+#ifndef DIRSCAN_H
+#define DIRSCAN_H
+
+#include <stddef.h>
+
+// Called for each directory entry; return non-zero to stop the scan
+typedef int (*dirscan_func_t)(const char *name, size_t len, unsigned char type, void *ctx);
+
+// Read every entry of an open directory with batched getdents64 calls.
+// "." and ".." are skipped. Returns 0 on success, -1 with errno set on error.
+int dirscan_fd(int dirfd, dirscan_func_t func, void *ctx);
+
+// Open a directory by path and scan it
+int dirscan_path(const char *path, dirscan_func_t func, void *ctx);
+
+#endif // DIRSCAN_H
@@ -1,22 +1,62 @@
 #ifndef EXECUTOR_H
 #define EXECUTOR_H
 
+#include "jobs.h"
 #include "parser.h"
 
-// Execute a command
-int execute_command(command_t *cmd);
+// Lowest descriptor used for copies of descriptors a redirection replaced
+#define REDIRECT_SAVE_MIN_FD 10
 
-// Execute a single command (without chaining/logical operators)
-int execute_single_command(command_t *cmd);
+// One descriptor replaced by a redirection applied in the shell
+typedef struct {
+    int target;                 // Descriptor the redirection rebound
+    int saved;                  // Close-on-exec copy of the old file, or -1 if it was closed
+} redirect_save_t;
+
+// Redirections applied around a builtin, undone in reverse order
+typedef struct {
+    redirect_save_t *saves;
+    int count;
+} redirect_frame_t;
+
+// Apply @cmd's redirections to the shell; 0 on success, -1 on error
+int redirect_frame_push(command_t *cmd, redirect_frame_t *frame);
+
+// Restore the descriptors saved by redirect_frame_push
+void redirect_frame_pop(redirect_frame_t *frame);
+
+// Execute a parsed command line
+int execute_sequence(sequence_t *seq);
+
+// Execute one and-or list (pipelines joined by && and ||)
+int execute_and_or(and_or_t *list, arena_t *arena);
+
+// Execute a single command (one pipeline stage)
+int execute_single_command(command_t *cmd, arena_t *arena);
+
+// Execute a pipeline (stages linked through next_pipe)
+int execute_pipeline(command_t *cmd, int background, arena_t *arena);
+
+// Exit status of the last foreground command ($?)
+int get_last_status(void);
+
+// Per-stage exit statuses of the last foreground command ($PIPESTATUS)
+const int *get_pipestatus(int *count);
 
 // Execute command with redirection
 int execute_with_redirection(command_t *cmd);
 
 // Execute command in background
-int execute_background(command_t *cmd);
+int execute_background(command_t *cmd, arena_t *arena);
+
+// Start a command without waiting; it is collected through the job table
+job_t *execute_async(command_t *cmd, int out_fd, pid_t pgid, int *status);
 
-// Find command in PATH
-char *find_command(const char *command);
+// Refresh the split PATH cache and directory index if PATH changed
+int sync_path_cache(void);
+
+// Find command in PATH (result owned by the command hash table)
+const char *find_command(const char *command);
 
 // Check if file is executable
 int is_executable(const char *path);
@@ -24,21 +64,6 @@ int is_executable(const char *path);
 // Execute external command
 int execute_external(command_t *cmd);
 
-// Handle command chaining
-int execute_command_chain(command_t **commands, int count);
-
-// Handle logical operators (&&, ||)
-int execute_logical_chain(command_t **commands, int count);
-
-// Execute command with logical operator
-int execute_with_logical(command_t *cmd);
-
-// Wait for background processes
-void wait_for_background_processes(void);
-
-// Signal handling for child processes
-void setup_child_signal_handlers(void);
-
 void cleanup_find_command_cache(void);
 
 #endif // EXECUTOR_H
@@ -0,0 +1,22 @@
+#ifndef HISTINDEX_H
+#define HISTINDEX_H
+
+#include <stddef.h>
+
+// Search index over the history store. Identical lines share one slot that
+// counts its uses; each distinct line is indexed by its trigrams.
+
+// Index up to @max entries added to the store since the last call (starts
+// again after the store was compacted or cleared). Returns 1 while
+// entries are left to index, else 0.
+int histindex_update(size_t max);
+
+// Find lines containing @pattern, best first by recency and frequency.
+// Fills @entries with the store index of each line's latest use.
+// Returns the number of matches stored (at most @max).
+int histindex_search(const char *pattern, size_t *entries, int max);
+
+// Free the index
+void histindex_destroy(void);
+
+#endif // HISTINDEX_H
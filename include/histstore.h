@@ -0,0 +1,46 @@
+#ifndef HISTSTORE_H
+#define HISTSTORE_H
+
+#include <stddef.h>
+#include <time.h>
+
+// One history entry. Strings point into the mapped file and stay valid
+// until the next histstore call that may remap it (append, refresh, clear).
+typedef struct {
+    time_t time;            // When the command was entered
+    int status;             // Its exit status
+    const char *cwd;        // Working directory it ran in
+    const char *line;       // Command line
+} hist_entry_t;
+
+// Open (creating if needed) the history file at @path and index it.
+// Returns 0, or -1 if the file cannot be used (history is then memory-only).
+int histstore_open(const char *path);
+
+// Default file: $HISTFILE, else ~/.lemuen_history (static buffer)
+const char *histstore_default_path(void);
+
+// Number of entries, oldest first
+size_t histstore_count(void);
+
+// Fetch entry @index (0 = oldest). Returns 0, or -1 if out of range.
+int histstore_get(size_t index, hist_entry_t *entry);
+
+// Append one record with a single O_APPEND write. Compacts the file once
+// it passes its size limit. Returns 0, or -1 on error.
+int histstore_append(const char *line, time_t when, int status, const char *cwd);
+
+// Index records appended by other shells since the last call
+void histstore_refresh(void);
+
+// Changes whenever entries are renumbered (file compacted, cleared or
+// reopened), so indexes built over entry numbers know to start again
+unsigned long histstore_generation(void);
+
+// Remove every entry (for all shells sharing the file)
+int histstore_clear(void);
+
+// Unmap and close the file
+void histstore_close(void);
+
+#endif // HISTSTORE_H
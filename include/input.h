@@ -0,0 +1,25 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+
+// Buffered line reader for non-interactive input (scripts, -c, pipes)
+typedef struct input_reader input_reader_t;
+
+// Read lines from a descriptor. Regular files are mmap'ed; anything else is
+// read in large blocks. With @shared set (the descriptor is the shell's
+// stdin), the file offset is kept just past the current line so commands
+// reading stdin continue where the shell stopped.
+input_reader_t *input_open_fd(int fd, int shared);
+
+// Read lines from a string (for -c)
+input_reader_t *input_open_string(const char *str);
+
+// Get the next line without its newline; NULL at end of input.
+// The line stays valid until the next call.
+char *input_next_line(input_reader_t *reader, size_t *len);
+
+// Free the reader (does not close the descriptor)
+void input_close(input_reader_t *reader);
+
+#endif // INPUT_H
@@ -0,0 +1,118 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <sys/types.h>
+#include <time.h>
+
+// Job states
+typedef enum {
+    JOB_RUNNING = 0,
+    JOB_STOPPED,
+    JOB_DONE
+} job_state_t;
+
+// Job flags
+#define JOB_BACKGROUND 0x01     // Started with & (reported by jobs / notify)
+#define JOB_INTERNAL   0x02     // Started by the shell itself; never listed
+
+// One process of a job
+typedef struct {
+    pid_t pid;                  // -1 if the stage never started
+    int status;                 // Shell exit status once done
+    job_state_t state;
+} job_proc_t;
+
+// A pipeline (or background subshell) in one process group
+typedef struct job {
+    int id;                     // Job number (%n)
+    pid_t pgid;
+    char *command;              // Text shown by `jobs`
+    job_proc_t *procs;          // One per pipeline stage
+    int proc_count;
+    int running;                // Procs neither done nor stopped
+    int stopped;                // Procs currently stopped
+    int flags;
+    unsigned long seq;          // Order of last start/stop, for %+ and %-
+    int notified;               // State change already reported
+} job_t;
+
+// Install the SIGCHLD self-pipe handler
+void jobs_init(void);
+
+// Forget every job (in a forked subshell, whose table is not its own)
+void jobs_forget_all(void);
+
+// Register started processes as a job. @pids[i] <= 0 marks a stage that
+// failed to start; its status is taken from @statuses (may be NULL).
+job_t *jobs_add(pid_t pgid, const pid_t *pids, const int *statuses, int count,
+                const char *command, int flags);
+
+// O(1) lookups
+job_t *jobs_find_id(int id);
+job_t *jobs_find_pid(pid_t pid);
+
+// Resolve %n, %%, %+, %-, %prefix or a pid; NULL (after an error) if none
+job_t *jobs_parse_spec(const char *spec, const char *builtin);
+
+// Current (%+) job, or NULL
+job_t *jobs_current(void);
+
+// Wait until the job finishes or stops. Fills @statuses (proc_count
+// entries, may be NULL). Returns the last stage's status, or 128+SIGTSTP
+// when the job stopped (it then stays in the table).
+int jobs_wait(job_t *job, int *statuses);
+
+// Block until any listed job is done; returns it, or NULL if none is left
+job_t *jobs_wait_any(void);
+
+// Wait for every running job and drop the finished ones
+void jobs_wait_all(void);
+
+// Run a stopped or background job in the foreground / background
+int jobs_foreground(job_t *job, int owns_terminal);
+int jobs_background(job_t *job);
+
+// Collect finished children without blocking (drains the self-pipe)
+void jobs_reap(void);
+
+// Wait at most @timeout for the job to finish or stop (pidfd + timerfd,
+// sigtimedwait fallback). Returns 1 if it did, 0 on timeout; the job is
+// still collected with jobs_wait.
+int jobs_wait_until(job_t *job, const struct timespec *timeout);
+
+// Block until any child changes state; -1 if there are no children
+int jobs_wait_event(void);
+
+// Whether any job finished or stopped since the last jobs_notify
+int jobs_have_changes(void);
+
+// Print state changes of background jobs and drop finished ones
+void jobs_notify(void);
+
+// Hook told about pidfds of background processes: (fd, 1) after one is
+// opened, (fd, 0) before it is closed
+typedef void (*jobs_watch_fn)(int fd, int watch);
+void jobs_set_watch(jobs_watch_fn hook);
+
+// Print the table in `jobs` format (@mode: 0, 'l' or 'p')
+void jobs_print(int mode);
+
+// Remove a job from the table and free it
+void jobs_remove(job_t *job);
+
+// Listed job after @job in id order (NULL: the first); NULL at the end
+job_t *jobs_next(job_t *job);
+
+// Number of listed (non-internal) jobs
+int jobs_count(void);
+
+// Pid of the last background job ($!), or 0
+pid_t jobs_last_background_pid(void);
+
+// Read end of the SIGCHLD self-pipe, or -1
+int jobs_signal_fd(void);
+
+// Free the table
+void jobs_destroy(void);
+
+#endif // JOBS_H
@@ -0,0 +1,44 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <sys/types.h>
+
+// Process launch backends
+typedef enum {
+    LAUNCH_SPAWN = 0,   // posix_spawn (vfork-style, no page table copy)
+    LAUNCH_FORK         // Classic fork + execv
+} launch_backend_t;
+
+// File descriptor rebinding applied in the child before exec
+typedef struct {
+    int fd;             // Descriptor open in the parent
+    int target;         // Descriptor number it becomes in the child
+} launch_dup_t;
+
+// Launch options for a single process
+typedef struct {
+    const launch_dup_t *dups;   // Rebindings, applied in order
+    int dup_count;              // Number of rebindings
+    pid_t pgid;                 // -1: inherit, 0: new group, >0: join group
+    char *const *envp;          // Environment, or NULL for environ
+} launch_opts_t;
+
+// Select the backend used by launch_process
+void launch_set_backend(launch_backend_t backend);
+
+// Get the active backend
+launch_backend_t launch_get_backend(void);
+
+// Select backend by name ("spawn" or "fork"), returns 0 on success
+int launch_set_backend_by_name(const char *name);
+
+// Get the name of a backend
+const char *launch_backend_name(launch_backend_t backend);
+
+// Start an executable; returns child pid, or -1 with errno set
+pid_t launch_process(const char *path, char *const argv[], const launch_opts_t *opts);
+
+// Signal handling for child processes
+void setup_child_signal_handlers(void);
+
+#endif // LAUNCH_H
@@ -0,0 +1,74 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stddef.h>
+#include "arena.h"
+
+// Marks the next byte of a word as quoted in the source (like bash's CTLESC).
+// Expansion copies the marked byte literally and drops the marker.
+#define LEX_CTLESC '\001'
+
+// A command substitution $(...) is kept in its word as LEX_CTLESC
+// LEX_CMDSUB_OPEN, the command text with each LEX_CTLESC doubled, then
+// LEX_CTLESC LEX_CMDSUB_CLOSE. The lexer never marks these two bytes
+// otherwise, so the pairs cannot be mistaken for quoted text.
+#define LEX_CMDSUB_OPEN '('
+#define LEX_CMDSUB_CLOSE ')'
+
+// Bytes that make a word need expansion / quote removal
+#define LEX_SPECIAL_BYTES "$\001"
+
+// Token types
+typedef enum {
+    TOK_END = 0,        // End of line (or start of a comment)
+    TOK_WORD,           // Word, after quote removal
+    TOK_PIPE,           // |
+    TOK_OR,             // ||
+    TOK_AND,            // &&
+    TOK_SEMICOLON,      // ;
+    TOK_BACKGROUND,     // &
+    TOK_LESS,           // <
+    TOK_GREAT,          // >
+    TOK_DGREAT,         // >>
+    TOK_ERR_GREAT,      // 2>
+    TOK_ALL_GREAT,      // &>
+    TOK_DLESS,          // <<
+    TOK_DLESSDASH,      // <<-
+    TOK_TLESS           // <<<
+} token_type_t;
+
+// One token of a command line
+typedef struct {
+    token_type_t type;
+    size_t offset;              // Byte offset of the token in the line
+    char *word;                 // TOK_WORD text (arena), NULL otherwise
+    int assignment;             // TOK_WORD spelled NAME=... with NAME unquoted
+    int quoted;                 // TOK_WORD had quotes or backslashes in it
+} token_t;
+
+// Lexer state: a cursor over one line
+typedef struct {
+    const char *input;
+    size_t length;              // strlen(input)
+    size_t pos;
+    arena_t *arena;             // Receives word text
+} lexer_t;
+
+// Start lexing @input; word text is allocated from @arena
+void lexer_init(lexer_t *lexer, arena_t *arena, const char *input);
+
+// Read the next token. Returns 0, or -1 after printing a syntax error
+// (unterminated quote or $(...)).
+int lexer_next(lexer_t *lexer, token_t *token);
+
+// Convert the body of a here-document with an unquoted delimiter (or the
+// text of a $((...))) into a word, as if it were inside double quotes
+// without the quotes: $ and $(...) stay active, a backslash only escapes
+// $ ` \ and newline, and nothing is globbed. Returns NULL after printing
+// a syntax error.
+char *lexer_heredoc_word(arena_t *arena, const char *text);
+
+// Source spelling of a token type, for error messages ("newline" for TOK_END)
+const char *token_type_name(token_type_t type);
+
+#endif // LEXER_H
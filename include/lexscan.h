@@ -0,0 +1,31 @@
+#ifndef LEXSCAN_H
+#define LEXSCAN_H
+
+#include <stddef.h>
+
+// Classification kernels used by the lexer to skip plain runs of bytes
+typedef enum {
+    LEXSCAN_AUTO = 0,   // Best kernel the CPU supports
+    LEXSCAN_SCALAR,     // Portable table lookup, one byte at a time
+    LEXSCAN_SSE2,       // 16 bytes per step (x86)
+    LEXSCAN_AVX2        // 32 bytes per step (x86)
+} lexscan_impl_t;
+
+// Offset of the first byte in [s, s + len) that ends an unquoted run:
+// blanks, | & ; < > ' " \ NUL and the quote marker. Returns @len if none.
+size_t lexscan_unquoted(const char *s, size_t len);
+
+// Offset of the first " \ NUL or quote marker (inside double quotes)
+size_t lexscan_dquoted(const char *s, size_t len);
+
+// Offset of the first ' $ NUL or quote marker (inside single quotes)
+size_t lexscan_squoted(const char *s, size_t len);
+
+// Select a kernel (for benchmarks). Returns -1 if the CPU lacks it.
+int lexscan_set_impl(lexscan_impl_t impl);
+
+// Kernel in use, and its name
+lexscan_impl_t lexscan_get_impl(void);
+const char *lexscan_impl_name(lexscan_impl_t impl);
+
+#endif // LEXSCAN_H
@@ -0,0 +1,27 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Shell options settable with `set -o name` / `set +o name`
+typedef enum {
+    OPT_PIPEFAIL = 0,   // Pipeline status is the rightmost non-zero stage
+    OPT_LASTPIPE,       // Without job control, a builtin last stage runs in the shell
+    OPT_COUNT
+} shell_option_id_t;
+
+// Get the value of a shell option
+int shell_option(shell_option_id_t id);
+
+// Set a shell option by id
+void shell_option_set(shell_option_id_t id, int value);
+
+// Set a shell option by name, returns 0 on success, -1 if unknown
+int shell_option_set_by_name(const char *name, int value);
+
+// Print all options and their values
+void shell_options_print(void);
+
+// Whether the shell reads commands from a terminal (set once at startup)
+int shell_is_interactive(void);
+void shell_set_interactive(int interactive);
+
+#endif // OPTIONS_H
@@ -0,0 +1,31 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stddef.h>
+
+// Output buffer shared by the builtins. Bytes are collected in memory and
+// written to stdout when the builtin returns, when the buffer fills, or at
+// the end of each line while stdout is a terminal.
+
+// Append @len bytes of @data
+void outbuf_write(const char *data, size_t len);
+
+// Append a string (no newline is added)
+void outbuf_puts(const char *str);
+
+// Append formatted text
+void outbuf_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Write out everything buffered. Returns 0, or -1 with errno set if a
+// write failed since the last flush (the bytes are dropped).
+int outbuf_flush(void);
+
+// Stdout was rebound: check again whether it is a terminal
+void outbuf_retarget(void);
+
+// Collect output in memory instead of writing it (for $(...) run in the
+// shell) until outbuf_capture_end, which returns the bytes and their count
+void outbuf_capture_begin(void);
+const char *outbuf_capture_end(size_t *len);
+
+#endif // OUTBUF_H
@@ -0,0 +1,20 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Options of the parallel builtin
+typedef struct {
+    int workers;        // Children running at once (0: online CPUs)
+    int keep_order;     // Buffer each job's output and print in input order
+} parallel_opts_t;
+
+// Default worker count: online CPUs (at least 1)
+int parallel_default_workers(void);
+
+// Run @template once per input with {} replaced by the input (appended as
+// the last argument when the template has no {}), at most opts->workers at
+// a time. Returns 0 if every job succeeded, else the number of failed jobs
+// (at most 101).
+int parallel_run(char *const *template, int template_count,
+                 char *const *inputs, int input_count, const parallel_opts_t *opts);
+
+#endif // PARALLEL_H
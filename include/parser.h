@@ -2,6 +2,7 @@
 #define PARSER_H
 
 #include <stddef.h>
+#include "arena.h"
 
 // Logical operator types
 typedef enum {
@@ -10,39 +11,79 @@ typedef enum {
     LOGIC_OR        // ||
 } logic_operator_t;
 
-// Command structure to hold parsed command
+// Redirection types
+typedef enum {
+    REDIR_INPUT = 0,    // [n]< file
+    REDIR_OUTPUT,       // [n]> file
+    REDIR_APPEND,       // [n]>> file
+    REDIR_OUTPUT_ALL,   // &> file (stdout and stderr)
+    REDIR_HEREDOC,      // << word, <<- word (here-document)
+    REDIR_HERESTRING    // <<< word
+} redirect_type_t;
+
+// Here-document flags
+#define HEREDOC_STRIP_TABS 0x01 // <<-: leading tabs are removed from each line
+#define HEREDOC_EXPAND     0x02 // Unquoted delimiter: $VAR and $(...) are expanded
+
+// Redirection list entry, applied in order
+typedef struct redirect {
+    redirect_type_t type;
+    int fd;                     // Descriptor being redirected (1 for &>)
+    char *target;               // File name; a here-document's body (its
+                                // delimiter until the body is read)
+    int flags;                  // HEREDOC_* flags
+    struct redirect *next;
+    struct redirect *next_heredoc;  // Next here-document still waiting for its body
+} redirect_t;
+
+// Simple command structure (one pipeline stage)
 typedef struct command {
-    char **args;           // Array of arguments
-    int argc;              // Number of arguments
-    char *input_redirect;  // Input redirection file
-    char *output_redirect; // Output redirection file
-    int append_output;     // Whether to append (>>) or overwrite (>)
-    char *next_command;    // For command chaining (;)
-    int background;        // Whether to run in background (&)
-    logic_operator_t logic_op;  // Logical operator (&&, ||)
-    char *next_logic_command;   // Next command after logical operator
+    char **assigns;             // Leading NAME=value words
+    int assign_count;           // Number of assignments
+    char **args;                // Array of arguments
+    int argc;                   // Number of arguments
+    redirect_t *redirects;      // Redirection list
     struct command *next_pipe;  // Next command in pipeline (|)
 } command_t;
 
-// Parse a command line string into command_t structure
-command_t *parse_command(const char *line);
+// Pipeline: one element of an and-or list
+typedef struct pipeline {
+    command_t *commands;        // First stage; later stages via next_pipe
+    int stage_count;            // Number of stages
+    logic_operator_t next_op;   // Operator joining the next pipeline (&&, ||)
+    struct pipeline *next;      // Next pipeline in the and-or list
+} pipeline_t;
 
-// Free command_t structure
-void free_command(command_t *cmd);
+// And-or list: one element of a sequence
+typedef struct and_or {
+    pipeline_t *pipelines;      // Pipelines joined by && / ||
+    int background;             // Terminated by & instead of ;
+    struct and_or *next;        // Next list in the sequence
+} and_or_t;
 
-// Check if command is empty or only whitespace
-int is_empty_command(const char *line);
-
-// Parse command chaining (;)
-command_t **parse_command_chain(const char *line, int *count);
+// Parsed command line: and-or lists separated by ; or &
+typedef struct sequence {
+    and_or_t *lists;
+    arena_t *arena;             // Arena holding the tree (and its expansions)
+    redirect_t *heredocs;       // Here-documents whose bodies follow the line
+    arena_str_t heredoc_body;   // Body of the first of them, read so far
+} sequence_t;
 
-// Free command chain array
-void free_command_chain(command_t **commands, int count);
+// Parse a command line into a tree, allocating from @arena. Tokens come from
+// the lexer one at a time, so the line is scanned once.
+// Returns NULL for an empty line or a syntax error (then *syntax_error is set).
+// The tree stays valid until @arena is reset.
+sequence_t *parse_line(arena_t *arena, const char *line, int *syntax_error);
 
-// Parse logical operators (&&, ||)
-command_t **parse_logical_chain(const char *line, int *count);
+// Here-document bodies are read from the lines after the command line:
+// while parse_heredoc_pending is true, pass the next line (without its
+// newline) to parse_heredoc_line, or NULL at end of input, which ends every
+// open here-document with a warning. parse_heredoc_line returns 0, or -1
+// after a syntax error in an expanding body.
+int parse_heredoc_pending(const sequence_t *seq);
+int parse_heredoc_line(sequence_t *seq, const char *line);
 
-// Free logical chain array
-void free_logical_chain(command_t **commands, int count);
+// Check if command is empty or only whitespace
+int is_empty_command(const char *line);
 
 #endif // PARSER_H
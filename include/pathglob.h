@@ -0,0 +1,19 @@
+#ifndef PATHGLOB_H
+#define PATHGLOB_H
+
+#include <stddef.h>
+#include "arena.h"
+
+// Pathname expansion. Patterns use *, ?, [...] (with ! or ^ to negate,
+// ranges and [:class:] names) and ** as a whole segment for any number of
+// directories; a backslash makes the next byte literal.
+
+// Check whether @pattern has an unescaped *, ? or [
+int pathglob_has_magic(const char *pattern);
+
+// Expand @pattern against the filesystem. The sorted matches and the
+// array holding them are allocated from @arena. Returns the number of
+// matches (0 when nothing matches or the pattern has no magic).
+size_t pathglob_expand(arena_t *arena, const char *pattern, char ***matches);
+
+#endif // PATHGLOB_H
@@ -0,0 +1,37 @@
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include <stddef.h>
+
+// Build the index from PATH directories (in search order).
+// Duplicate directories are dropped; missing ones are indexed once they
+// appear.
+void pathindex_build(char **paths, int count);
+
+// Read every directory of the current PATH again (hash -r)
+void pathindex_rebuild(void);
+
+// Check whether an index has been built
+int pathindex_ready(void);
+
+// Apply pending inotify events (cheap when nothing changed)
+void pathindex_sync(void);
+
+// Resolve a command name through the index.
+// Returns: 1 and the path in @buf when found, 0 when not in PATH,
+//          -1 when no index is available.
+int pathindex_lookup(const char *name, char *buf, size_t size);
+
+// Change notifications for the set of command names: (name, 1) when a
+// name appears, (name, 0) when it disappears, (NULL, 0) when the index is
+// dropped. Setting a hook replays every current name.
+typedef void (*pathindex_watch_fn)(const char *name, int present);
+void pathindex_set_watch(pathindex_watch_fn hook);
+
+// inotify descriptor, or -1 when not watching
+int pathindex_fd(void);
+
+// Free the index and drop all watches
+void pathindex_destroy(void);
+
+#endif // PATHINDEX_H
@@ -0,0 +1,10 @@
+#ifndef PRINTFMT_H
+#define PRINTFMT_H
+
+// printf builtin: format @args[1..@argc) with the format @args[0] into the
+// builtin output buffer, reusing the format while arguments remain.
+// Returns 0, or 1 if an argument was not a valid number or the format was
+// invalid.
+int printfmt_run(char *const *args, int argc);
+
+#endif // PRINTFMT_H
@@ -0,0 +1,16 @@
+#ifndef READCMD_H
+#define READCMD_H
+
+// Options of the read builtin
+typedef struct {
+    int raw;                    // -r: a backslash is an ordinary byte
+    char delim;                 // -d: line terminator ('\n' by default)
+    const char *prompt;         // -p: shown on stderr when stdin is a terminal
+} read_opts_t;
+
+// Read one line from stdin and split it on $IFS into the variables
+// @names[0..@count), the last one taking the rest of the line (REPLY when
+// @count is 0). Returns 0, 1 at end of input, or 2 on an error.
+int readcmd_run(char *const *names, int count, const read_opts_t *opts);
+
+#endif // READCMD_H
@@ -0,0 +1,10 @@
+#ifndef TESTEXPR_H
+#define TESTEXPR_H
+
+// Evaluate a test / [ expression given as @argc words (without the command
+// name or the closing ]); errors are reported as coming from @name. Files
+// are checked with stat, lstat and access directly. Returns 0 if true, 1
+// if false, 2 after printing an error.
+int testexpr_eval(const char *name, char *const *args, int argc);
+
+#endif // TESTEXPR_H
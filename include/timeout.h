@@ -0,0 +1,23 @@
+#ifndef TIMEOUT_H
+#define TIMEOUT_H
+
+#include <time.h>
+#include "parser.h"
+
+// Options of the timeout builtin
+typedef struct {
+    struct timespec duration;       // Time limit (zero: none)
+    int signal;                     // Sent to the process group at the limit
+    struct timespec kill_after;     // Then SIGKILL after this long (zero: never)
+    int preserve_status;            // Return the command's own status on timeout
+} timeout_opts_t;
+
+// Parse "1.5", "30s", "2m", "1h" or "1d". Returns 0, or -1 if invalid.
+int timeout_parse_duration(const char *text, struct timespec *out);
+
+// Run @cmd in its own process group and signal the group when the limit
+// passes. Returns the command's status, 124 if it timed out (137 if it had
+// to be killed with SIGKILL).
+int timeout_run(command_t *cmd, const timeout_opts_t *opts);
+
+#endif // TIMEOUT_H
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include "arena.h"
 #include "parser.h"
 
 // Safe string duplication with error handling
@@ -14,12 +15,11 @@ char *trim_left(char *str);
 char *trim_right(char *str);
 char *trim(char *str);
 
-// String splitting
+// String splitting (one allocation: release with free())
 char **split_string(const char *str, const char *delim, int *count);
-void free_string_array(char **array);
 
-// Environment variable utilities
-char *get_env_var(const char *name);
+// Shell variable shortcuts (see vars.h)
+const char *get_env_var(const char *name);
 void set_env_var(const char *name, const char *value);
 
 // Path utilities
@@ -31,7 +31,8 @@ void print_error(const char *format, ...);
 void print_system_error(const char *message);
 
 // Environment variable expansion
-char *expand_env_var_in_string(const char *str);
-void expand_env_vars(command_t *cmd);
+char *expand_env_var_in_string(arena_t *arena, const char *str);
+// Returns 0, or -1 when an expansion failed and the command must not run
+int expand_env_vars(arena_t *arena, command_t *cmd);
 
 #endif // UTILS_H
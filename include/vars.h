@@ -0,0 +1,57 @@
+#ifndef VARS_H
+#define VARS_H
+
+#include <stddef.h>
+
+// Variable flags
+#define VAR_EXPORT 0x01     // Passed to child processes
+
+// Load the process environment as exported variables (done lazily if not
+// called explicitly)
+void vars_init(char **envp);
+
+// Value of a variable, or NULL if unset. Valid until the variable changes.
+const char *vars_get(const char *name);
+
+// Same, for a name that is not NUL-terminated
+const char *vars_get_n(const char *name, size_t len);
+
+// Set a variable. @flags are added to the existing ones (a new variable is
+// shell-local unless VAR_EXPORT is given). Returns 0, or -1 for a bad name.
+int vars_set(const char *name, const char *value, unsigned flags);
+
+// Apply a "NAME=value" word; returns 0, or -1 if it is not an assignment
+int vars_assign(const char *assignment, unsigned flags);
+
+// Mark a variable for export, creating it without a value if needed
+int vars_export(const char *name);
+
+// Remove a variable
+void vars_unset(const char *name);
+
+// Check whether a string is a valid variable name ([A-Za-z_][A-Za-z0-9_]*)
+int vars_valid_name(const char *name, size_t len);
+
+// Counter bumped whenever the exported set or an exported value changes
+unsigned long vars_generation(void);
+
+// NULL-terminated "NAME=value" array of exported variables for exec.
+// Rebuilt only when vars_generation() has moved since the last call.
+char *const *vars_envp(void);
+
+// vars_envp() overlaid with @count "NAME=value" words (prefix assignments).
+// Returns a malloc'd array to free() (the strings are not copied).
+char **vars_envp_overlay(char *const *assignments, int count);
+
+// Call @func for every variable name (hash order, not NUL-terminated);
+// a non-zero return stops the walk
+typedef int (*vars_each_fn)(const char *name, size_t len, void *ctx);
+void vars_each(vars_each_fn func, void *ctx);
+
+// Print exported variables as `export NAME="value"` lines
+void vars_print_exported(void);
+
+// Free every variable
+void vars_destroy(void);
+
+#endif // VARS_H
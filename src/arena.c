@@ -0,0 +1,278 @@
+#define _GNU_SOURCE
+#include "arena.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_CHUNK (16 * 1024)
+
+// Strictest alignment of the types stored in an arena (max_align_t is C11)
+typedef union {
+    long double ld;
+    long long ll;
+    void *ptr;
+    void (*fn)(void);
+} arena_align_t;
+
+#define ARENA_ALIGN (sizeof(arena_align_t))
+
+typedef struct chunk {
+    struct chunk *next;
+    size_t size;                // Usable bytes in data[]
+    size_t used;
+    arena_align_t data[];
+} chunk_t;
+
+struct arena {
+    chunk_t *first;             // Chunks in allocation order
+    chunk_t *current;           // Chunk allocations are bumped from
+    size_t chunk_size;
+    size_t in_use;              // Bytes handed out since the last reset
+    size_t high_water;
+    void *last;                 // Most recent allocation (for in-place growth)
+};
+
+// Helper: round @size up to the arena alignment
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+// Helper: allocate a chunk with at least @size usable bytes
+static chunk_t *chunk_new(size_t size) {
+    chunk_t *chunk = malloc(sizeof(chunk_t) + size);
+    if (!chunk) {
+        print_error("arena: out of memory");
+        exit(1);
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+/**
+ * arena_create - Create an empty arena.
+ * @chunk_size: Minimum chunk size in bytes, or 0 for the default (16 KB).
+ *
+ * Returns: New arena (exits on allocation failure).
+ */
+arena_t *arena_create(size_t chunk_size) {
+    arena_t *arena = calloc(1, sizeof(arena_t));
+    if (!arena) {
+        print_error("arena: out of memory");
+        exit(1);
+    }
+    arena->chunk_size = align_up(chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK);
+    arena->first = arena->current = chunk_new(arena->chunk_size);
+    return arena;
+}
+
+/**
+ * arena_alloc - Allocate memory from an arena.
+ * @arena: Arena to allocate from.
+ * @size: Number of bytes.
+ *
+ * The request is bumped from the current chunk. When it does not fit, the
+ * next retained chunk is reused if it is big enough, otherwise a new chunk
+ * is linked in after the current one.
+ * Returns: Pointer aligned for any type; never NULL.
+ */
+void *arena_alloc(arena_t *arena, size_t size) {
+    size = align_up(size ? size : 1);
+
+    chunk_t *chunk = arena->current;
+    if (chunk->size - chunk->used < size) {
+        chunk_t *next = chunk->next;
+        if (next && next->size >= size) {
+            next->used = 0;
+        } else {
+            size_t new_size = size > arena->chunk_size ? size : arena->chunk_size;
+            chunk_t *fresh = chunk_new(new_size);
+            fresh->next = next;
+            chunk->next = fresh;
+            next = fresh;
+        }
+        chunk = arena->current = next;
+    }
+
+    void *ptr = (char *)chunk->data + chunk->used;
+    chunk->used += size;
+    arena->in_use += size;
+    if (arena->in_use > arena->high_water) {
+        arena->high_water = arena->in_use;
+    }
+    arena->last = ptr;
+    return ptr;
+}
+
+/**
+ * arena_calloc - Allocate zero-filled memory from an arena.
+ * @arena: Arena to allocate from.
+ * @count: Number of elements.
+ * @size: Size of each element.
+ *
+ * Returns: Zeroed memory; never NULL.
+ */
+void *arena_calloc(arena_t *arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) {
+        print_error("arena: allocation too large");
+        exit(1);
+    }
+    void *ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+/**
+ * arena_realloc - Resize an arena allocation.
+ * @arena: Arena the allocation came from.
+ * @ptr: Previous allocation, or NULL.
+ * @old_size: Size @ptr was allocated (or last resized) with.
+ * @new_size: Requested size.
+ *
+ * The most recent allocation grows or shrinks in place while it fits in its
+ * chunk, which makes building a string byte by byte cheap. Anything else is
+ * copied to a new allocation; the old space is reclaimed at the next reset.
+ * Returns: Resized allocation; never NULL.
+ */
+void *arena_realloc(arena_t *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (!ptr) {
+        return arena_alloc(arena, new_size);
+    }
+
+    chunk_t *chunk = arena->current;
+    if (ptr == arena->last) {
+        size_t offset = (size_t)((char *)ptr - (char *)chunk->data);
+        size_t old_aligned = chunk->used - offset;
+        size_t new_aligned = align_up(new_size ? new_size : 1);
+        if (offset + new_aligned <= chunk->size) {
+            chunk->used = offset + new_aligned;
+            arena->in_use = arena->in_use - old_aligned + new_aligned;
+            if (arena->in_use > arena->high_water) {
+                arena->high_water = arena->in_use;
+            }
+            return ptr;
+        }
+    }
+
+    void *moved = arena_alloc(arena, new_size);
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    return moved;
+}
+
+/**
+ * arena_strdup - Copy a string into an arena.
+ * @arena: Arena to allocate from.
+ * @str: String to copy (may be NULL).
+ *
+ * Returns: Copy of @str, or NULL if @str is NULL.
+ */
+char *arena_strdup(arena_t *arena, const char *str) {
+    if (!str) return NULL;
+    return arena_strndup(arena, str, strlen(str));
+}
+
+/**
+ * arena_strndup - Copy at most @len bytes of a string into an arena.
+ * @arena: Arena to allocate from.
+ * @str: Source string.
+ * @len: Maximum number of bytes to copy.
+ *
+ * Returns: NUL-terminated copy; never NULL.
+ */
+char *arena_strndup(arena_t *arena, const char *str, size_t len) {
+    size_t n = strnlen(str, len);
+    char *copy = arena_alloc(arena, n + 1);
+    memcpy(copy, str, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+/**
+ * arena_str_init - Start an empty arena string.
+ * @str: String to initialise.
+ * @arena: Arena that will hold the contents.
+ */
+void arena_str_init(arena_str_t *str, arena_t *arena) {
+    str->arena = arena;
+    str->cap = 64;
+    str->data = arena_alloc(arena, str->cap);
+    str->data[0] = '\0';
+    str->len = 0;
+}
+
+/**
+ * arena_str_append - Append bytes to an arena string.
+ * @str: String to extend.
+ * @text: Bytes to append.
+ * @len: Number of bytes.
+ *
+ * Capacity doubles; while nothing else has been allocated from the arena
+ * since, the growth happens in place.
+ */
+void arena_str_append(arena_str_t *str, const char *text, size_t len) {
+    if (str->len + len + 1 > str->cap) {
+        size_t new_cap = str->cap * 2;
+        while (str->len + len + 1 > new_cap) new_cap *= 2;
+        str->data = arena_realloc(str->arena, str->data, str->cap, new_cap);
+        str->cap = new_cap;
+    }
+    memcpy(str->data + str->len, text, len);
+    str->len += len;
+    str->data[str->len] = '\0';
+}
+
+/**
+ * arena_str_putc - Append one byte to an arena string.
+ * @str: String to extend.
+ * @c: Byte to append.
+ */
+void arena_str_putc(arena_str_t *str, char c) {
+    if (str->len + 2 > str->cap) {
+        str->data = arena_realloc(str->arena, str->data, str->cap, str->cap * 2);
+        str->cap *= 2;
+    }
+    str->data[str->len++] = c;
+    str->data[str->len] = '\0';
+}
+
+/**
+ * arena_reset - Release every allocation made from an arena.
+ * @arena: Arena to reset.
+ *
+ * Rewinds to the first chunk without touching the others, so the cost does
+ * not depend on how much was allocated. Chunks are reused by later lines.
+ */
+void arena_reset(arena_t *arena) {
+    arena->current = arena->first;
+    arena->first->used = 0;
+    arena->in_use = 0;
+    arena->last = NULL;
+}
+
+/**
+ * arena_high_water - Get the peak usage of an arena.
+ * @arena: Arena to query.
+ *
+ * Returns: Largest number of bytes in use at once since creation.
+ */
+size_t arena_high_water(const arena_t *arena) {
+    return arena->high_water;
+}
+
+/**
+ * arena_destroy - Free an arena and all of its chunks.
+ * @arena: Arena to free (may be NULL).
+ */
+void arena_destroy(arena_t *arena) {
+    if (!arena) return;
+
+    chunk_t *chunk = arena->first;
+    while (chunk) {
+        chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
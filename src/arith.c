@@ -0,0 +1,292 @@
+#define _GNU_SOURCE
+#include "arith.h"
+#include "utils.h"
+#include "vars.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Binary operators, lowest precedence first
+typedef enum {
+    OP_NONE = 0,
+    OP_LOR, OP_LAND, OP_BOR, OP_BXOR, OP_BAND, OP_EQ, OP_NE,
+    OP_LT, OP_LE, OP_GT, OP_GE, OP_SHL, OP_SHR, OP_ADD, OP_SUB,
+    OP_MUL, OP_DIV, OP_MOD
+} arith_op_t;
+
+// Parser state
+typedef struct {
+    const char *expr;           // Whole expression, for error messages
+    const char *p;              // Cursor
+    int skip;                   // Inside an operand that is not evaluated (0 && x)
+    int error;
+} arith_parser_t;
+
+static long long parse_ternary(arith_parser_t *a);
+
+// Helper: report an error once, at the cursor
+static void arith_error(arith_parser_t *a, const char *message) {
+    if (!a->error) {
+        print_error("%s: %s (error token is \"%s\")", a->expr, message, a->p);
+        a->error = 1;
+    }
+}
+
+// Helper: skip blanks
+static void skip_blanks(arith_parser_t *a) {
+    while (isspace((unsigned char)*a->p)) a->p++;
+}
+
+// Helper: precedence of a binary operator (1 binds loosest)
+static int op_precedence(arith_op_t op) {
+    static const int prec[] = {
+        0, 1, 2, 3, 4, 5, 6, 6, 7, 7, 7, 7, 8, 8, 9, 9, 10, 10, 10
+    };
+    return prec[op];
+}
+
+// Helper: recognise the binary operator at the cursor without consuming it
+static arith_op_t peek_op(const char *p, int *len) {
+    *len = 2;
+    switch (p[0]) {
+    case '|': if (p[1] == '|') return OP_LOR; *len = 1; return OP_BOR;
+    case '&': if (p[1] == '&') return OP_LAND; *len = 1; return OP_BAND;
+    case '=': if (p[1] == '=') return OP_EQ; return OP_NONE;
+    case '!': if (p[1] == '=') return OP_NE; return OP_NONE;
+    case '<':
+        if (p[1] == '<') return OP_SHL;
+        if (p[1] == '=') return OP_LE;
+        *len = 1;
+        return OP_LT;
+    case '>':
+        if (p[1] == '>') return OP_SHR;
+        if (p[1] == '=') return OP_GE;
+        *len = 1;
+        return OP_GT;
+    }
+    *len = 1;
+    switch (p[0]) {
+    case '^': return OP_BXOR;
+    case '+': return OP_ADD;
+    case '-': return OP_SUB;
+    case '*': return OP_MUL;
+    case '/': return OP_DIV;
+    case '%': return OP_MOD;
+    default: return OP_NONE;
+    }
+}
+
+// Helper: read a number in C syntax from @text; the whole text must be used
+static int parse_number(const char *text, size_t len, long long *value) {
+    char buf[64];
+    char *end;
+    if (len == 0) {
+        *value = 0;
+        return 0;
+    }
+    if (len >= sizeof(buf)) {
+        return -1;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+    errno = 0;
+    *value = strtoll(buf, &end, 0);
+    while (isspace((unsigned char)*end)) end++;
+    return (*end || errno == ERANGE) ? -1 : 0;
+}
+
+// Helper: value of the variable named by [name, name + len)
+static long long variable_value(arith_parser_t *a, const char *name, size_t len) {
+    const char *value = vars_get_n(name, len);
+    long long number = 0;
+    if (!value) {
+        return 0;
+    }
+    while (isspace((unsigned char)*value)) value++;
+    if (parse_number(value, strlen(value), &number) != 0) {
+        arith_error(a, "variable value is not a number");
+    }
+    return number;
+}
+
+// Helper: primary := number | name | $name | ${name} | ( expr )
+static long long parse_primary(arith_parser_t *a) {
+    skip_blanks(a);
+    const char *start = a->p;
+
+    if (*a->p == '(') {
+        a->p++;
+        long long value = parse_ternary(a);
+        skip_blanks(a);
+        if (*a->p != ')') {
+            arith_error(a, "missing `)'");
+            return 0;
+        }
+        a->p++;
+        return value;
+    }
+    if (isdigit((unsigned char)*a->p)) {
+        while (isalnum((unsigned char)*a->p)) a->p++;
+        long long value;
+        if (parse_number(start, a->p - start, &value) != 0) {
+            a->p = start;
+            arith_error(a, "invalid number");
+            return 0;
+        }
+        return value;
+    }
+
+    int braced = 0;
+    if (*a->p == '$') {
+        a->p++;
+        braced = *a->p == '{';
+        a->p += braced;
+    }
+    const char *name = a->p;
+    while (*a->p == '_' || isalnum((unsigned char)*a->p)) a->p++;
+    size_t len = a->p - name;
+    if (len == 0 || isdigit((unsigned char)*name) || (braced && *a->p++ != '}')) {
+        a->p = start;
+        arith_error(a, "syntax error: operand expected");
+        return 0;
+    }
+    return variable_value(a, name, len);
+}
+
+// Helper: unary := ( + | - | ! | ~ ) unary | primary
+static long long parse_unary(arith_parser_t *a) {
+    skip_blanks(a);
+    char c = *a->p;
+    if ((c == '+' || c == '-') && a->p[1] != c) {
+        a->p++;
+        long long value = parse_unary(a);
+        return c == '-' ? (long long)(0ULL - (unsigned long long)value) : value;
+    }
+    if (c == '!' && a->p[1] != '=') {
+        a->p++;
+        return !parse_unary(a);
+    }
+    if (c == '~') {
+        a->p++;
+        return ~parse_unary(a);
+    }
+    return parse_primary(a);
+}
+
+// Helper: apply a binary operator; wraps around like the machine does
+static long long apply_op(arith_parser_t *a, arith_op_t op, long long l, long long r) {
+    unsigned long long ul = (unsigned long long)l;
+    unsigned long long ur = (unsigned long long)r;
+    switch (op) {
+    case OP_BOR: return l | r;
+    case OP_BXOR: return l ^ r;
+    case OP_BAND: return l & r;
+    case OP_EQ: return l == r;
+    case OP_NE: return l != r;
+    case OP_LT: return l < r;
+    case OP_LE: return l <= r;
+    case OP_GT: return l > r;
+    case OP_GE: return l >= r;
+    case OP_SHL: return (long long)(ul << (r & 63));
+    case OP_SHR: return l >> (r & 63);
+    case OP_ADD: return (long long)(ul + ur);
+    case OP_SUB: return (long long)(ul - ur);
+    case OP_MUL: return (long long)(ul * ur);
+    case OP_DIV:
+    case OP_MOD:
+        if (r == 0) {
+            if (!a->skip) arith_error(a, "division by 0");
+            return 0;
+        }
+        if (r == -1) {
+            // LLONG_MIN / -1 traps; the wrapped result is LLONG_MIN
+            return op == OP_DIV ? (long long)(0ULL - ul) : 0;
+        }
+        return op == OP_DIV ? l / r : l % r;
+    default:
+        return 0;
+    }
+}
+
+// Helper: binary operators by precedence climbing, from @min_prec up.
+// && and || evaluate their right operand only when it decides the result.
+static long long parse_binary(arith_parser_t *a, int min_prec) {
+    long long left = parse_unary(a);
+    for (;;) {
+        skip_blanks(a);
+        int len;
+        arith_op_t op = peek_op(a->p, &len);
+        if (op == OP_NONE || op_precedence(op) < min_prec || a->error) {
+            return left;
+        }
+        a->p += len;
+        skip_blanks(a);
+        const char *operand = a->p;
+
+        int decided = (op == OP_LAND && !left) || (op == OP_LOR && left);
+        a->skip += decided;
+        long long right = parse_binary(a, op_precedence(op) + 1);
+        a->skip -= decided;
+
+        if (op == OP_LAND) {
+            left = left && right;
+        } else if (op == OP_LOR) {
+            left = left || right;
+        } else {
+            const char *next = a->p;
+            a->p = operand;  // An error points at the right operand
+            left = apply_op(a, op, left, right);
+            a->p = a->error ? a->p : next;
+        }
+    }
+}
+
+// Helper: ternary := binary [ ? ternary : ternary ]
+static long long parse_ternary(arith_parser_t *a) {
+    long long cond = parse_binary(a, 1);
+    skip_blanks(a);
+    if (*a->p != '?' || a->error) {
+        return cond;
+    }
+    a->p++;
+    a->skip += !cond;
+    long long yes = parse_ternary(a);
+    a->skip -= !cond;
+    skip_blanks(a);
+    if (*a->p != ':') {
+        arith_error(a, "syntax error: `:' expected");
+        return 0;
+    }
+    a->p++;
+    a->skip += !!cond;
+    long long no = parse_ternary(a);
+    a->skip -= !!cond;
+    return cond ? yes : no;
+}
+
+/**
+ * arith_eval - Evaluate an arithmetic expression.
+ * @expr: Expression text, as written between $(( and )).
+ * @value: Receives the result.
+ *
+ * An empty expression is 0. Operands that are not evaluated (the right
+ * side of a decided && or ||, the unused branch of ?:) are still parsed,
+ * but cannot fail with a division by zero.
+ * Returns: 0 on success, -1 after printing an error.
+ */
+int arith_eval(const char *expr, long long *value) {
+    arith_parser_t a = { expr, expr, 0, 0 };
+
+    skip_blanks(&a);
+    if (*a.p == '\0') {
+        *value = 0;
+        return 0;
+    }
+    *value = parse_ternary(&a);
+    skip_blanks(&a);
+    if (!a.error && *a.p != '\0') {
+        arith_error(&a, "syntax error in expression");
+    }
+    return a.error ? -1 : 0;
+}
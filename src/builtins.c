@@ -1,10 +1,34 @@
+#define _GNU_SOURCE
 #include "builtins.h"
+#include "cmdhash.h"
+#include "executor.h"
+#include "histindex.h"
+#include "histstore.h"
+#include "input.h"
+#include "jobs.h"
+#include "options.h"
+#include "outbuf.h"
+#include "parallel.h"
+#include "pathindex.h"
+#include "printfmt.h"
+#include "readcmd.h"
+#include "testexpr.h"
+#include "timeout.h"
 #include "utils.h"
+#include "vars.h"
 #include <stdio.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
+#include <signal.h>
+#include <time.h>
 #include <sys/wait.h>
+#include <readline/history.h>
+
+#define HISTORY_SEARCH_DEFAULT 20   // history -s matches shown without a count
+#define HISTORY_SEARCH_MAX 1000
 
 // Global variable to store previous directory
 static char *previous_dir = NULL;
@@ -17,17 +41,49 @@ static int builtin_echo_impl(command_t *cmd);
 static int builtin_help_impl(command_t *cmd);
 static int builtin_export_impl(command_t *cmd);
 static int builtin_unset_impl(command_t *cmd);
+static int builtin_set_impl(command_t *cmd);
+static int builtin_hash_impl(command_t *cmd);
+static int builtin_jobs_impl(command_t *cmd);
+static int builtin_fg_impl(command_t *cmd);
+static int builtin_bg_impl(command_t *cmd);
+static int builtin_wait_impl(command_t *cmd);
+static int builtin_kill_impl(command_t *cmd);
+static int builtin_parallel_impl(command_t *cmd);
+static int builtin_timeout_impl(command_t *cmd);
+static int builtin_history_impl(command_t *cmd);
+static int builtin_true_impl(command_t *cmd);
+static int builtin_false_impl(command_t *cmd);
+static int builtin_test_impl(command_t *cmd);
+static int builtin_printf_impl(command_t *cmd);
+static int builtin_read_impl(command_t *cmd);
 
 // Builtin commands table
 static const builtin_t builtins[] = {
-    {"cd", builtin_cd_impl, "cd [directory] - Change directory"},
-    {"exit", builtin_exit_impl, "exit [n] - Exit shell with status n"},
-    {"pwd", builtin_pwd_impl, "pwd - Print working directory"},
-    {"echo", builtin_echo_impl, "echo [args...] - Print arguments"},
-    {"help", builtin_help_impl, "help [command] - Show help"},
-    {"export", builtin_export_impl, "export name=value - Set environment variable"},
-    {"unset", builtin_unset_impl, "unset name - Unset environment variable"},
-    {NULL, NULL, NULL}  // Sentinel
+    {"cd", builtin_cd_impl, "cd [directory] - Change directory", 0},
+    {"exit", builtin_exit_impl, "exit [n] - Exit shell with status n", 0},
+    {"pwd", builtin_pwd_impl, "pwd - Print working directory", BUILTIN_PURE},
+    {"echo", builtin_echo_impl, "echo [args...] - Print arguments", BUILTIN_PURE},
+    {"help", builtin_help_impl, "help [command] - Show help", BUILTIN_PURE},
+    {"export", builtin_export_impl, "export [name[=value]...] - Export variables to commands", 0},
+    {"unset", builtin_unset_impl, "unset name... - Remove variables", 0},
+    {"set", builtin_set_impl, "set [-o|+o option] - Show or change shell options", 0},
+    {"hash", builtin_hash_impl, "hash [-r] [-p path] [name...] - Remember or show command locations", 0},
+    {"history", builtin_history_impl, "history [-l] [-s PATTERN] [n] | -c - Show the last n (or best n matching) history entries, or clear history", 0},
+    {"jobs", builtin_jobs_impl, "jobs [-l|-p] - List background and stopped jobs", 0},
+    {"fg", builtin_fg_impl, "fg [%job] - Resume a job in the foreground", 0},
+    {"bg", builtin_bg_impl, "bg [%job...] - Resume stopped jobs in the background", 0},
+    {"wait", builtin_wait_impl, "wait [-n] [%job|pid...] - Wait for jobs to finish", 0},
+    {"kill", builtin_kill_impl, "kill [-s sig|-sig] %job|pid... - Send a signal to jobs or processes", 0},
+    {"timeout", builtin_timeout_impl, "timeout [-s sig] [-k dur] [--preserve-status] duration cmd [args...] - Run cmd with a time limit", 0},
+    {"parallel", builtin_parallel_impl, "parallel [-j N] [-k] cmd [args] [::: inputs...] - Run cmd for each input ({}) on N workers", 0},
+    {"true", builtin_true_impl, "true - Return success", BUILTIN_PURE},
+    {"false", builtin_false_impl, "false - Return failure", BUILTIN_PURE},
+    {":", builtin_true_impl, ": [args...] - Do nothing and return success", BUILTIN_PURE},
+    {"test", builtin_test_impl, "test expr - Evaluate a file, string or integer test", BUILTIN_PURE},
+    {"[", builtin_test_impl, "[ expr ] - Evaluate a file, string or integer test", BUILTIN_PURE},
+    {"printf", builtin_printf_impl, "printf format [args...] - Print formatted text", BUILTIN_PURE},
+    {"read", builtin_read_impl, "read [-r] [-p prompt] [-d delim] [name...] - Read a line into variables", 0},
+    {NULL, NULL, NULL, 0}  // Sentinel
 };
 
 /**
@@ -50,6 +106,26 @@ int is_builtin(command_t *cmd) {
     return 0;
 }
 
+/**
+ * is_pure_builtin - Check if a command is a builtin that only writes output.
+ * @cmd: Command to check.
+ *
+ * Such a builtin behaves the same in the shell as in a subshell, so a
+ * command substitution can run it without forking.
+ * Returns: 1 if it is a BUILTIN_PURE builtin, 0 otherwise.
+ */
+int is_pure_builtin(command_t *cmd) {
+    if (!cmd || !cmd->args || cmd->argc == 0) {
+        return 0;
+    }
+    for (int i = 0; builtins[i].name; i++) {
+        if (strcmp(cmd->args[0], builtins[i].name) == 0) {
+            return (builtins[i].flags & BUILTIN_PURE) != 0;
+        }
+    }
+    return 0;
+}
+
 /**
  * run_builtin - Execute a builtin command.
  * @cmd: Command to execute.
@@ -64,7 +140,12 @@ int run_builtin(command_t *cmd) {
     const char *command_name = cmd->args[0];
     for (int i = 0; builtins[i].name; i++) {
         if (strcmp(command_name, builtins[i].name) == 0) {
-            return builtins[i].func(cmd);
+            int status = builtins[i].func(cmd);
+            if (outbuf_flush() != 0) {
+                print_error("%s: write error: %s", command_name, strerror(errno));
+                if (status == 0) status = 1;
+            }
+            return status;
         }
     }
     
@@ -82,7 +163,7 @@ static int builtin_cd_impl(command_t *cmd) {
     
     if (cmd->argc == 1) {
         // cd without arguments - go to home directory
-        target_dir = getenv("HOME");
+        target_dir = vars_get("HOME");
         if (!target_dir) {
             print_error("cd: HOME not set");
             return 1;
@@ -135,10 +216,11 @@ static int builtin_cd_impl(command_t *cmd) {
  * builtin_exit_impl - Implementation of the 'exit' builtin command.
  * @cmd: Command structure.
  *
+ * Without an argument the shell exits with the last command's status.
  * Returns: Exit status code (does not return).
  */
 static int builtin_exit_impl(command_t *cmd) {
-    int exit_code = 0;
+    int exit_code = get_last_status();
     
     if (cmd->argc > 2) {
         print_error("exit: too many arguments");
@@ -147,7 +229,10 @@ static int builtin_exit_impl(command_t *cmd) {
         exit_code = atoi(cmd->args[1]);
     }
     
-    printf("Bye from Lemuen Shell!\n");
+    if (shell_is_interactive()) {
+        outbuf_puts("Bye from Lemuen Shell!\n");
+    }
+    outbuf_flush();
     exit(exit_code);
 }
 
@@ -162,7 +247,8 @@ static int builtin_pwd_impl(command_t *cmd) {
     
     char *cwd = get_current_dir();
     if (cwd) {
-        printf("%s\n", cwd);
+        outbuf_puts(cwd);
+        outbuf_write("\n", 1);
         free(cwd);
         return 0;
     }
@@ -177,12 +263,12 @@ static int builtin_pwd_impl(command_t *cmd) {
  */
 static int builtin_echo_impl(command_t *cmd) {
     for (int i = 1; i < cmd->argc; i++) {
-        if (i > 1) write(STDOUT_FILENO, " ", 1);
+        if (i > 1) outbuf_write(" ", 1);
         if (cmd->args[i]) {
-            write(STDOUT_FILENO, cmd->args[i], strlen(cmd->args[i]));
+            outbuf_puts(cmd->args[i]);
         }
     }
-    write(STDOUT_FILENO, "\n", 1);
+    outbuf_write("\n", 1);
     return 0;
 }
 
@@ -194,17 +280,17 @@ static int builtin_echo_impl(command_t *cmd) {
  */
 static int builtin_help_impl(command_t *cmd) {
     if (cmd->argc == 1) {
-        printf("Lemuen Shell v0.7 - Available builtin commands:\n");
-        printf("==============================================\n");
+        outbuf_puts("Lemuen Shell v0.7 - Available builtin commands:\n");
+        outbuf_puts("==============================================\n");
         for (int i = 0; builtins[i].name; i++) {
-            printf("  %s\n", builtins[i].help);
+            outbuf_printf("  %s\n", builtins[i].help);
         }
-        printf("\nFor more information about a command, type: help <command>\n");
+        outbuf_puts("\nFor more information about a command, type: help <command>\n");
     } else if (cmd->argc == 2) {
         const char *command_name = cmd->args[1];
         for (int i = 0; builtins[i].name; i++) {
             if (strcmp(command_name, builtins[i].name) == 0) {
-                printf("%s\n", builtins[i].help);
+                outbuf_printf("%s\n", builtins[i].help);
                 return 0;
             }
         }
@@ -221,55 +307,669 @@ static int builtin_help_impl(command_t *cmd) {
  * builtin_export_impl - Implementation of the 'export' builtin command.
  * @cmd: Command structure.
  *
+ * `export` lists exported variables, `export name=value` sets and exports,
+ * `export name` exports an existing (or future) variable.
  * Returns: Exit status code.
  */
 static int builtin_export_impl(command_t *cmd) {
-    if (cmd->argc != 2) {
-        print_error("export: usage: export name=value");
-        return 1;
+    if (cmd->argc == 1 || (cmd->argc == 2 && strcmp(cmd->args[1], "-p") == 0)) {
+        vars_print_exported();
+        return 0;
     }
-    
-    const char *assignment = cmd->args[1];
-    char *equals = strchr(assignment, '=');
-    
-    if (!equals) {
-        print_error("export: invalid format, use: name=value");
-        return 1;
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        const char *arg = cmd->args[i];
+        int ret = strchr(arg, '=') ? vars_assign(arg, VAR_EXPORT) : vars_export(arg);
+        if (ret != 0) {
+            print_error("export: `%s': not a valid identifier", arg);
+            status = 1;
+        }
     }
-    
-    int name_len = equals - assignment;
-    char *name = malloc(name_len + 1);
-    if (!name) {
-        print_error("export: out of memory");
+    return status;
+}
+
+/**
+ * builtin_unset_impl - Implementation of the 'unset' builtin command.
+ * @cmd: Command structure.
+ *
+ * Returns: Exit status code.
+ */
+static int builtin_unset_impl(command_t *cmd) {
+    if (cmd->argc < 2) {
+        print_error("unset: usage: unset name...");
         return 1;
     }
-    
-    strncpy(name, assignment, name_len);
-    name[name_len] = '\0';
-    
-    const char *value = equals + 1;
-    set_env_var(name, value);
-    
-    free(name);
+
+    for (int i = 1; i < cmd->argc; i++) {
+        vars_unset(cmd->args[i]);
+    }
     return 0;
 }
 
 /**
- * builtin_unset_impl - Implementation of the 'unset' builtin command.
+ * builtin_set_impl - Implementation of the 'set' builtin command.
  * @cmd: Command structure.
  *
+ * Supports `set -o` (list), `set -o name` (enable) and `set +o name` (disable).
  * Returns: Exit status code.
  */
-static int builtin_unset_impl(command_t *cmd) {
-    if (cmd->argc != 2) {
-        print_error("unset: usage: unset name");
+static int builtin_set_impl(command_t *cmd) {
+    if (cmd->argc == 1 || (cmd->argc == 2 && strcmp(cmd->args[1], "-o") == 0)) {
+        shell_options_print();
+        return 0;
+    }
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        const char *flag = cmd->args[i];
+        if ((strcmp(flag, "-o") != 0 && strcmp(flag, "+o") != 0) || i + 1 >= cmd->argc) {
+            print_error("set: usage: set [-o|+o option]");
+            return 1;
+        }
+        const char *name = cmd->args[++i];
+        if (shell_option_set_by_name(name, flag[0] == '-') != 0) {
+            print_error("set: %s: invalid option name", name);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+/**
+ * builtin_hash_impl - Implementation of the 'hash' builtin command.
+ * @cmd: Command structure.
+ *
+ * `hash` lists remembered locations and lookup counters, `hash -r` forgets
+ * them, `hash -p path name` sets one explicitly and `hash name...` looks
+ * names up in PATH and remembers them.
+ * Returns: Exit status code.
+ */
+static int builtin_hash_impl(command_t *cmd) {
+    if (cmd->argc == 1) {
+        pathindex_sync();
+        cmdhash_print();
+        return 0;
+    }
+
+    int i = 1;
+    if (strcmp(cmd->args[i], "-r") == 0) {
+        cmdhash_clear();
+        pathindex_rebuild();
+        i++;
+    }
+    if (i < cmd->argc && strcmp(cmd->args[i], "-p") == 0) {
+        if (i + 2 >= cmd->argc) {
+            print_error("hash: usage: hash -p path name");
+            return 1;
+        }
+        cmdhash_insert(cmd->args[i + 2], cmd->args[i + 1]);
+        i += 3;
+    }
+
+    int status = 0;
+    for (; i < cmd->argc; i++) {
+        const char *name = cmd->args[i];
+        if (strchr(name, '/')) {
+            continue;  // Paths are never hashed
+        }
+        cmdhash_remove(name);
+        if (!find_command(name)) {
+            print_error("hash: %s: not found", name);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// Helper: print one history entry, with its time, status and directory
+// when @verbose
+static void print_history_entry(size_t index, int verbose) {
+    hist_entry_t entry;
+    if (histstore_get(index, &entry) != 0) return;
+    if (verbose) {
+        char when[32];
+        struct tm tm;
+        localtime_r(&entry.time, &tm);
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+        outbuf_printf("%5zu  %s  %3d  %s  %s\n", index + 1, when, entry.status, entry.cwd, entry.line);
+    } else {
+        outbuf_printf("%5zu  %s\n", index + 1, entry.line);
+    }
+}
+
+/**
+ * builtin_history_impl - Implementation of the 'history' builtin command.
+ * @cmd: Command structure.
+ *
+ * `history [n]` lists the last n entries of the persistent history (shared
+ * by every shell using the file), `-l` adds time, exit status and working
+ * directory, `-s PATTERN` lists the best n lines containing PATTERN (by
+ * recency and frequency, best first) and `history -c` clears it.
+ * Returns: Exit status code.
+ */
+static int builtin_history_impl(command_t *cmd) {
+    int verbose = 0;
+    const char *pattern = NULL;
+    size_t limit = (size_t)-1;
+
+    for (int i = 1; i < cmd->argc; i++) {
+        const char *arg = cmd->args[i];
+        if (strcmp(arg, "-c") == 0) {
+            clear_history();
+            if (histstore_count() > 0 && histstore_clear() != 0) {
+                print_system_error("history: failed to clear history file");
+                return 1;
+            }
+            return 0;
+        } else if (strcmp(arg, "-l") == 0) {
+            verbose = 1;
+        } else if (strcmp(arg, "-s") == 0 && i + 1 < cmd->argc) {
+            pattern = cmd->args[++i];
+        } else {
+            char *end;
+            long n = strtol(arg, &end, 10);
+            if (*end != '\0' || n < 0) {
+                print_error("history: usage: history [-l] [-s PATTERN] [n] | -c");
+                return 2;
+            }
+            limit = (size_t)n;
+        }
+    }
+
+    histstore_refresh();
+    if (pattern) {
+        size_t wanted = limit == (size_t)-1 ? HISTORY_SEARCH_DEFAULT : limit;
+        int max = wanted < HISTORY_SEARCH_MAX ? (int)wanted : HISTORY_SEARCH_MAX;
+        size_t matches[HISTORY_SEARCH_MAX];
+        int found = histindex_search(pattern, matches, max);
+        for (int i = 0; i < found; i++) {
+            print_history_entry(matches[i], verbose);
+        }
+        return found > 0 ? 0 : 1;
+    }
+
+    size_t total = histstore_count();
+    size_t first = limit < total ? total - limit : 0;
+    for (size_t i = first; i < total; i++) {
+        print_history_entry(i, verbose);
+    }
+    return 0;
+}
+
+/**
+ * builtin_jobs_impl - Implementation of the 'jobs' builtin command.
+ * @cmd: Command structure.
+ *
+ * `jobs` lists jobs, `jobs -l` adds process group ids and `jobs -p` prints
+ * only the ids. Finished jobs are listed once.
+ * Returns: Exit status code.
+ */
+static int builtin_jobs_impl(command_t *cmd) {
+    int mode = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        if (strcmp(cmd->args[i], "-l") == 0) {
+            mode = 'l';
+        } else if (strcmp(cmd->args[i], "-p") == 0) {
+            mode = 'p';
+        } else {
+            print_error("jobs: usage: jobs [-l|-p]");
+            return 2;
+        }
+    }
+    jobs_reap();
+    jobs_print(mode);
+    return 0;
+}
+
+/**
+ * builtin_fg_impl - Implementation of the 'fg' builtin command.
+ * @cmd: Command structure.
+ *
+ * Returns: Exit status of the job, or 1 if there is no such job.
+ */
+static int builtin_fg_impl(command_t *cmd) {
+    if (cmd->argc > 2) {
+        print_error("fg: usage: fg [%%job]");
+        return 2;
+    }
+    jobs_reap();
+    job_t *job = jobs_parse_spec(cmd->argc == 2 ? cmd->args[1] : NULL, "fg");
+    if (!job) {
         return 1;
     }
-    
-    set_env_var(cmd->args[1], NULL);
+    int owns_terminal = isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+    return jobs_foreground(job, owns_terminal);
+}
+
+/**
+ * builtin_bg_impl - Implementation of the 'bg' builtin command.
+ * @cmd: Command structure.
+ *
+ * Returns: Exit status code.
+ */
+static int builtin_bg_impl(command_t *cmd) {
+    jobs_reap();
+    if (cmd->argc == 1) {
+        job_t *job = jobs_parse_spec(NULL, "bg");
+        return job ? jobs_background(job) : 1;
+    }
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        job_t *job = jobs_parse_spec(cmd->args[i], "bg");
+        if (!job || jobs_background(job) != 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+/**
+ * builtin_wait_impl - Implementation of the 'wait' builtin command.
+ * @cmd: Command structure.
+ *
+ * `wait` waits for every job and returns 0, `wait %n|pid...` returns the
+ * status of the last one named, and `wait -n` returns the status of the
+ * next job to finish (127 if there is none).
+ * Returns: Exit status code.
+ */
+static int builtin_wait_impl(command_t *cmd) {
+    if (cmd->argc >= 2 && strcmp(cmd->args[1], "-n") == 0) {
+        if (cmd->argc > 2) {
+            print_error("wait: usage: wait -n");
+            return 2;
+        }
+        job_t *job = jobs_wait_any();
+        return job ? jobs_wait(job, NULL) : 127;
+    }
+
+    if (cmd->argc == 1) {
+        jobs_wait_all();
+        return 0;
+    }
+
+    int status = 0;
+    for (int i = 1; i < cmd->argc; i++) {
+        job_t *job = jobs_parse_spec(cmd->args[i], "wait");
+        status = job ? jobs_wait(job, NULL) : 127;
+    }
+    return status;
+}
+
+// Signal names accepted by kill (without the SIG prefix)
+static const struct {
+    const char *name;
+    int number;
+} signal_names[] = {
+    {"HUP", SIGHUP}, {"INT", SIGINT}, {"QUIT", SIGQUIT}, {"KILL", SIGKILL},
+    {"USR1", SIGUSR1}, {"USR2", SIGUSR2}, {"PIPE", SIGPIPE}, {"ALRM", SIGALRM},
+    {"TERM", SIGTERM}, {"CHLD", SIGCHLD}, {"CONT", SIGCONT}, {"STOP", SIGSTOP},
+    {"TSTP", SIGTSTP}, {"TTIN", SIGTTIN}, {"TTOU", SIGTTOU}, {"WINCH", SIGWINCH},
+    {NULL, 0}
+};
+
+// Helper: parse a signal given by name (with or without SIG) or number
+// Returns: Signal number, or -1 if unknown.
+static int parse_signal(const char *text) {
+    if (*text >= '0' && *text <= '9') {
+        char *end;
+        long number = strtol(text, &end, 10);
+        return (*end == '\0' && number >= 0 && number < NSIG) ? (int)number : -1;
+    }
+    if (strncasecmp(text, "SIG", 3) == 0) {
+        text += 3;
+    }
+    for (int i = 0; signal_names[i].name; i++) {
+        if (strcasecmp(text, signal_names[i].name) == 0) {
+            return signal_names[i].number;
+        }
+    }
+    return -1;
+}
+
+/**
+ * builtin_kill_impl - Implementation of the 'kill' builtin command.
+ * @cmd: Command structure.
+ *
+ * A job is signalled through its process group; a stopped job also gets
+ * SIGCONT so it can act on the signal. `kill -l` lists signal names.
+ * Returns: Exit status code.
+ */
+static int builtin_kill_impl(command_t *cmd) {
+    int sig = SIGTERM;
+    int i = 1;
+
+    if (i < cmd->argc && strcmp(cmd->args[i], "-l") == 0) {
+        for (int n = 0; signal_names[n].name; n++) {
+            outbuf_printf("%2d) SIG%s\n", signal_names[n].number, signal_names[n].name);
+        }
+        return 0;
+    }
+    if (i < cmd->argc && strcmp(cmd->args[i], "-s") == 0) {
+        if (i + 1 >= cmd->argc) {
+            print_error("kill: -s: option requires an argument");
+            return 2;
+        }
+        sig = parse_signal(cmd->args[i + 1]);
+        if (sig < 0) {
+            print_error("kill: %s: invalid signal specification", cmd->args[i + 1]);
+            return 1;
+        }
+        i += 2;
+    } else if (i < cmd->argc && cmd->args[i][0] == '-' && cmd->args[i][1] &&
+               strcmp(cmd->args[i], "--") != 0) {
+        sig = parse_signal(cmd->args[i] + 1);
+        if (sig < 0) {
+            print_error("kill: %s: invalid signal specification", cmd->args[i] + 1);
+            return 1;
+        }
+        i++;
+    }
+    if (i < cmd->argc && strcmp(cmd->args[i], "--") == 0) {
+        i++;
+    }
+    if (i >= cmd->argc) {
+        print_error("kill: usage: kill [-s sig|-sig] %%job|pid...");
+        return 2;
+    }
+
+    jobs_reap();
+    int status = 0;
+    for (; i < cmd->argc; i++) {
+        const char *target = cmd->args[i];
+        if (target[0] == '%') {
+            job_t *job = jobs_parse_spec(target, "kill");
+            if (!job) {
+                status = 1;
+                continue;
+            }
+            pid_t pid = job->pgid > 0 ? -job->pgid : job->procs[0].pid;
+            if (kill(pid, sig) == -1) {
+                print_error("kill: %s: %s", target, strerror(errno));
+                status = 1;
+            } else if (job->stopped > 0 && sig != SIGCONT && sig != SIGSTOP &&
+                       sig != SIGKILL && job->pgid > 0) {
+                kill(pid, SIGCONT);
+            }
+            continue;
+        }
+
+        char *end;
+        long pid = strtol(target, &end, 10);
+        if (*end != '\0' || end == target) {
+            print_error("kill: %s: arguments must be process or job IDs", target);
+            status = 1;
+        } else if (kill((pid_t)pid, sig) == -1) {
+            print_error("kill: (%ld): %s", pid, strerror(errno));
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// Helper: read parallel's inputs from stdin, one per line
+// Returns: Array of allocated lines (free each and the array), or NULL.
+static char **read_input_lines(int *count) {
+    input_reader_t *reader = input_open_fd(STDIN_FILENO, 1);
+    char **lines = NULL;
+    int capacity = 0;
+    char *line;
+    size_t len;
+
+    *count = 0;
+    if (!reader) {
+        print_error("parallel: failed to allocate input buffer");
+        return NULL;
+    }
+    while ((line = input_next_line(reader, &len)) != NULL) {
+        if (*count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 64;
+            char **grown = realloc(lines, new_capacity * sizeof(char *));
+            if (!grown) {
+                print_error("parallel: out of memory");
+                break;
+            }
+            lines = grown;
+            capacity = new_capacity;
+        }
+        lines[(*count)++] = strdup_safe(line);
+    }
+    input_close(reader);
+    return lines;
+}
+
+/**
+ * builtin_parallel_impl - Implementation of the 'parallel' builtin command.
+ * @cmd: Command structure.
+ *
+ * `parallel [-j N] [-k] cmd args... ::: in1 in2...` runs cmd once per
+ * input, replacing {} with it (or appending it when there is no {}).
+ * Without ::: the inputs are the lines of stdin. -j sets the number of
+ * workers (default: online CPUs), -k prints output in input order.
+ * Returns: 0 if every job succeeded, else the number of failed jobs.
+ */
+static int builtin_parallel_impl(command_t *cmd) {
+    parallel_opts_t opts = { 0, 0 };
+    int i = 1;
+
+    for (; i < cmd->argc && cmd->args[i][0] == '-'; i++) {
+        const char *arg = cmd->args[i];
+        if (strcmp(arg, "--") == 0) {
+            i++;
+            break;
+        } else if (strcmp(arg, "-k") == 0) {
+            opts.keep_order = 1;
+        } else if (strncmp(arg, "-j", 2) == 0) {
+            const char *value = arg[2] ? arg + 2 : (i + 1 < cmd->argc ? cmd->args[++i] : NULL);
+            char *end;
+            long workers = value ? strtol(value, &end, 10) : 0;
+            if (!value || *end != '\0' || workers <= 0 || workers > 65536) {
+                print_error("parallel: -j: invalid number of workers");
+                return 2;
+            }
+            opts.workers = (int)workers;
+        } else {
+            print_error("parallel: usage: parallel [-j N] [-k] cmd [args] [::: inputs...]");
+            return 2;
+        }
+    }
+
+    int template_start = i;
+    while (i < cmd->argc && strcmp(cmd->args[i], ":::") != 0) {
+        i++;
+    }
+    int template_count = i - template_start;
+    if (template_count == 0) {
+        print_error("parallel: usage: parallel [-j N] [-k] cmd [args] [::: inputs...]");
+        return 2;
+    }
+
+    if (i < cmd->argc) {
+        // Inputs after :::
+        return parallel_run(cmd->args + template_start, template_count,
+                            cmd->args + i + 1, cmd->argc - i - 1, &opts);
+    }
+
+    int count;
+    char **lines = read_input_lines(&count);
+    int status = parallel_run(cmd->args + template_start, template_count,
+                              lines, count, &opts);
+    for (int n = 0; n < count; n++) {
+        free(lines[n]);
+    }
+    free(lines);
+    return status;
+}
+
+// Helper: parse timeout options starting at @i; returns the index after
+// them, or -1 after printing an error
+static int parse_timeout_options(command_t *cmd, int i, timeout_opts_t *opts) {
+    while (i < cmd->argc && cmd->args[i][0] == '-' && cmd->args[i][1]) {
+        const char *arg = cmd->args[i];
+        if (strcmp(arg, "--preserve-status") == 0) {
+            opts->preserve_status = 1;
+            i++;
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "-k") == 0) {
+            if (i + 1 >= cmd->argc) {
+                print_error("timeout: %s: option requires an argument", arg);
+                return -1;
+            }
+            const char *value = cmd->args[i + 1];
+            if (arg[1] == 's' && (opts->signal = parse_signal(value)) < 0) {
+                print_error("timeout: %s: invalid signal", value);
+                return -1;
+            }
+            if (arg[1] == 'k' && timeout_parse_duration(value, &opts->kill_after) != 0) {
+                print_error("timeout: %s: invalid time interval", value);
+                return -1;
+            }
+            i += 2;
+        } else if (strcmp(arg, "--") == 0) {
+            return i + 1;
+        } else {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * builtin_timeout_impl - Implementation of the 'timeout' builtin command.
+ * @cmd: Command structure.
+ *
+ * `timeout [-s sig] [-k dur] duration cmd args...` runs cmd and sends sig
+ * (default TERM) to its process group once duration passes, then KILL
+ * after the -k delay. Options are also accepted right after the duration.
+ * Returns: Command status, 124 on timeout, 125 on a usage error.
+ */
+static int builtin_timeout_impl(command_t *cmd) {
+    timeout_opts_t opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.signal = SIGTERM;
+
+    int i = parse_timeout_options(cmd, 1, &opts);
+    if (i < 0) {
+        return 125;
+    }
+    if (i >= cmd->argc || timeout_parse_duration(cmd->args[i], &opts.duration) != 0) {
+        if (i < cmd->argc) {
+            print_error("timeout: %s: invalid time interval", cmd->args[i]);
+        } else {
+            print_error("timeout: usage: timeout [-s sig] [-k dur] duration cmd [args...]");
+        }
+        return 125;
+    }
+    i = parse_timeout_options(cmd, i + 1, &opts);
+    if (i < 0) {
+        return 125;
+    }
+    if (i >= cmd->argc) {
+        print_error("timeout: usage: timeout [-s sig] [-k dur] duration cmd [args...]");
+        return 125;
+    }
+
+    command_t timed;
+    memset(&timed, 0, sizeof(timed));
+    timed.args = cmd->args + i;
+    timed.argc = cmd->argc - i;
+    return timeout_run(&timed, &opts);
+}
+
+/**
+ * builtin_true_impl - Implementation of the 'true' and ':' builtin commands.
+ * @cmd: Command structure (arguments are ignored).
+ *
+ * Returns: 0.
+ */
+static int builtin_true_impl(command_t *cmd) {
+    (void)cmd;
     return 0;
 }
 
+/**
+ * builtin_false_impl - Implementation of the 'false' builtin command.
+ * @cmd: Command structure (arguments are ignored).
+ *
+ * Returns: 1.
+ */
+static int builtin_false_impl(command_t *cmd) {
+    (void)cmd;
+    return 1;
+}
+
+/**
+ * builtin_test_impl - Implementation of the 'test' and '[' builtin commands.
+ * @cmd: Command structure.
+ *
+ * `[` needs `]` as its last argument.
+ * Returns: 0 if the expression is true, 1 if false, 2 on an error.
+ */
+static int builtin_test_impl(command_t *cmd) {
+    int argc = cmd->argc - 1;
+    if (strcmp(cmd->args[0], "[") == 0) {
+        if (argc == 0 || strcmp(cmd->args[cmd->argc - 1], "]") != 0) {
+            print_error("[: missing `]'");
+            return 2;
+        }
+        argc--;
+    }
+    return testexpr_eval(cmd->args[0], cmd->args + 1, argc);
+}
+
+/**
+ * builtin_printf_impl - Implementation of the 'printf' builtin command.
+ * @cmd: Command structure.
+ *
+ * Returns: Exit status code.
+ */
+static int builtin_printf_impl(command_t *cmd) {
+    int i = 1;
+    if (i < cmd->argc && strcmp(cmd->args[i], "--") == 0) {
+        i++;
+    }
+    if (i >= cmd->argc) {
+        print_error("printf: usage: printf format [arguments]");
+        return 2;
+    }
+    return printfmt_run(cmd->args + i, cmd->argc - i);
+}
+
+/**
+ * builtin_read_impl - Implementation of the 'read' builtin command.
+ * @cmd: Command structure.
+ *
+ * -r keeps backslashes, -p shows a prompt on a terminal and -d ends the
+ * line at the first byte of its argument instead of a newline.
+ * Returns: 0, 1 at end of input, 2 on an error.
+ */
+static int builtin_read_impl(command_t *cmd) {
+    read_opts_t opts = { 0, '\n', NULL };
+    int i = 1;
+
+    for (; i < cmd->argc && cmd->args[i][0] == '-' && cmd->args[i][1]; i++) {
+        const char *arg = cmd->args[i];
+        if (strcmp(arg, "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(arg, "-r") == 0) {
+            opts.raw = 1;
+        } else if ((strcmp(arg, "-p") == 0 || strcmp(arg, "-d") == 0) && i + 1 < cmd->argc) {
+            if (arg[1] == 'p') {
+                opts.prompt = cmd->args[++i];
+            } else {
+                opts.delim = cmd->args[++i][0];
+            }
+        } else {
+            print_error("read: %s: invalid option", arg);
+            print_error("read: usage: read [-r] [-p prompt] [-d delim] [name...]");
+            return 2;
+        }
+    }
+    return readcmd_run(cmd->args + i, cmd->argc - i, &opts);
+}
+
 /**
  * get_builtins - Get the builtin commands table.
  *
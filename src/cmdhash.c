@@ -0,0 +1,196 @@
+#include "cmdhash.h"
+#include "outbuf.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CMDHASH_INITIAL_BUCKETS 64
+
+static cmdhash_entry_t **buckets = NULL;
+static size_t bucket_count = 0;
+static size_t entry_count = 0;
+static unsigned long total_hits = 0;
+static unsigned long total_misses = 0;
+
+// Helper: FNV-1a string hash
+static size_t hash_name(const char *name) {
+    size_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Helper: double the bucket array once the load factor passes 3/4
+static void grow_buckets(void) {
+    size_t new_count = bucket_count ? bucket_count * 2 : CMDHASH_INITIAL_BUCKETS;
+    cmdhash_entry_t **new_buckets = calloc(new_count, sizeof(cmdhash_entry_t *));
+    if (!new_buckets) return;  // Keep the old, fuller table
+
+    for (size_t i = 0; i < bucket_count; i++) {
+        cmdhash_entry_t *entry = buckets[i];
+        while (entry) {
+            cmdhash_entry_t *next = entry->next;
+            size_t slot = hash_name(entry->name) & (new_count - 1);
+            entry->next = new_buckets[slot];
+            new_buckets[slot] = entry;
+            entry = next;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+}
+
+// Helper: find the entry for a name
+static cmdhash_entry_t *find_entry(const char *name) {
+    if (!buckets) return NULL;
+    cmdhash_entry_t *entry = buckets[hash_name(name) & (bucket_count - 1)];
+    while (entry && strcmp(entry->name, name) != 0) {
+        entry = entry->next;
+    }
+    return entry;
+}
+
+/**
+ * cmdhash_lookup - Look up the remembered location of a command.
+ * @name: Command name.
+ *
+ * Counts a hit when found; misses are counted by the caller through
+ * cmdhash_count_miss once it has to search PATH.
+ * Returns: Path owned by the table, or NULL.
+ */
+const char *cmdhash_lookup(const char *name) {
+    if (!name) return NULL;
+    cmdhash_entry_t *entry = find_entry(name);
+    if (!entry) return NULL;
+    entry->hits++;
+    total_hits++;
+    return entry->path;
+}
+
+/**
+ * cmdhash_insert - Remember the location of a command.
+ * @name: Command name.
+ * @path: Resolved path.
+ *
+ * Replaces an existing entry for the same name.
+ * Returns: Path owned by the table.
+ */
+const char *cmdhash_insert(const char *name, const char *path) {
+    if (!name || !path) return NULL;
+
+    cmdhash_entry_t *entry = find_entry(name);
+    if (entry) {
+        char *copy = strdup_safe(path);
+        free(entry->path);
+        entry->path = copy;
+        entry->hits = 0;
+        return entry->path;
+    }
+
+    if (entry_count + 1 > bucket_count / 4 * 3) {
+        grow_buckets();
+        if (!buckets) return NULL;
+    }
+
+    entry = malloc(sizeof(cmdhash_entry_t));
+    if (!entry) return NULL;
+    entry->name = strdup_safe(name);
+    entry->path = strdup_safe(path);
+    entry->hits = 0;
+
+    size_t slot = hash_name(name) & (bucket_count - 1);
+    entry->next = buckets[slot];
+    buckets[slot] = entry;
+    entry_count++;
+    return entry->path;
+}
+
+/**
+ * cmdhash_remove - Forget the location of one command.
+ * @name: Command name.
+ */
+void cmdhash_remove(const char *name) {
+    if (!name || !buckets) return;
+
+    cmdhash_entry_t **link = &buckets[hash_name(name) & (bucket_count - 1)];
+    while (*link) {
+        cmdhash_entry_t *entry = *link;
+        if (strcmp(entry->name, name) == 0) {
+            *link = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+            entry_count--;
+            return;
+        }
+        link = &entry->next;
+    }
+}
+
+/**
+ * cmdhash_clear - Forget every remembered location.
+ *
+ * The bucket array is kept for reuse; counters are not reset.
+ */
+void cmdhash_clear(void) {
+    for (size_t i = 0; i < bucket_count; i++) {
+        cmdhash_entry_t *entry = buckets[i];
+        while (entry) {
+            cmdhash_entry_t *next = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+            entry = next;
+        }
+        buckets[i] = NULL;
+    }
+    entry_count = 0;
+}
+
+/**
+ * cmdhash_count_miss - Record a lookup that was not answered by the table.
+ */
+void cmdhash_count_miss(void) {
+    total_misses++;
+}
+
+/**
+ * cmdhash_get_stats - Get lookup counters.
+ *
+ * Returns: Hits, misses and current entry count.
+ */
+cmdhash_stats_t cmdhash_get_stats(void) {
+    cmdhash_stats_t stats = { total_hits, total_misses, entry_count };
+    return stats;
+}
+
+/**
+ * cmdhash_print - Print the table in `hash` builtin format.
+ */
+void cmdhash_print(void) {
+    if (entry_count == 0) {
+        outbuf_puts("hash: hash table empty\n");
+    } else {
+        outbuf_puts("hits\tcommand\n");
+        for (size_t i = 0; i < bucket_count; i++) {
+            for (cmdhash_entry_t *entry = buckets[i]; entry; entry = entry->next) {
+                outbuf_printf("%4lu\t%s\n", entry->hits, entry->path);
+            }
+        }
+    }
+    outbuf_printf("lookups: %lu hits, %lu misses\n", total_hits, total_misses);
+}
+
+/**
+ * cmdhash_destroy - Free the table and its bucket array.
+ */
+void cmdhash_destroy(void) {
+    cmdhash_clear();
+    free(buckets);
+    buckets = NULL;
+    bucket_count = 0;
+}
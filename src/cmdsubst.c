@@ -0,0 +1,294 @@
+#define _GNU_SOURCE
+#include "cmdsubst.h"
+#include "arith.h"
+#include "builtins.h"
+#include "executor.h"
+#include "jobs.h"
+#include "launch.h"
+#include "lexer.h"
+#include "options.h"
+#include "outbuf.h"
+#include "parser.h"
+#include "utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define READ_INITIAL_SIZE 4096
+
+// Output read from a pipe or file; grown by doubling and reused
+static char *read_buffer = NULL;
+static size_t read_capacity = 0;
+
+static int last_status = 0;
+static int status_pending = 0;
+static int expansion_failed = 0;
+
+// Helper: read @fd to end of file into read_buffer.
+// Returns: Number of bytes read (what was read before an error is kept).
+static size_t read_all(int fd) {
+    size_t len = 0;
+    for (;;) {
+        if (len == read_capacity) {
+            size_t capacity = read_capacity ? read_capacity * 2 : READ_INITIAL_SIZE;
+            char *grown = realloc(read_buffer, capacity);
+            if (!grown) {
+                print_error("command substitution: out of memory");
+                return len;
+            }
+            read_buffer = grown;
+            read_capacity = capacity;
+        }
+        ssize_t n = read(fd, read_buffer + len, read_capacity - len);
+        if (n > 0) {
+            len += (size_t)n;
+        } else if (n == 0) {
+            return len;
+        } else if (errno != EINTR) {
+            print_system_error("command substitution: read failed");
+            return len;
+        }
+    }
+}
+
+// Helper: copy output into @arena without NUL bytes or trailing newlines
+static char *finish_output(arena_t *arena, const char *data, size_t size, size_t *len) {
+    while (size > 0 && data[size - 1] == '\n') size--;
+    char *result = arena_alloc(arena, size + 1);
+    size_t used = 0;
+    if (!result) {
+        *len = 0;
+        return "";
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != '\0') result[used++] = data[i];
+    }
+    result[used] = '\0';
+    *len = used;
+    return result;
+}
+
+// Helper: the only command of @seq, or NULL if it has pipes or lists
+static command_t *single_command(sequence_t *seq) {
+    and_or_t *list = seq->lists;
+    if (list->next || list->background || list->pipelines->next ||
+        list->pipelines->commands->next_pipe) {
+        return NULL;
+    }
+    return list->pipelines->commands;
+}
+
+// Helper: $(< file): read the file without starting a process
+static int read_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    *size = 0;
+    if (fd == -1) {
+        print_system_error(path);
+        return 1;
+    }
+    *size = read_all(fd);
+    close(fd);
+    return 0;
+}
+
+// Helper: start @cmd (already expanded) with stdout on a pipe and read it
+static int capture_command(command_t *cmd, size_t *size) {
+    int fds[2];
+    int status = 0;
+    *size = 0;
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        print_system_error("command substitution: pipe failed");
+        return 1;
+    }
+    // Stays in the shell's process group, so ^C reaches it
+    job_t *job = execute_async(cmd, fds[1], -1, &status);
+    close(fds[1]);
+    if (job) {
+        *size = read_all(fds[0]);
+        status = jobs_wait(job, NULL);
+    }
+    close(fds[0]);
+    return status;
+}
+
+// Helper: run the whole of @seq in a forked subshell and read its output
+static int capture_subshell(sequence_t *seq, const char *text, size_t *size) {
+    int fds[2];
+    *size = 0;
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        print_system_error("command substitution: pipe failed");
+        return 1;
+    }
+
+    // Build the PATH index here, once, rather than in every subshell
+    sync_path_cache();
+    outbuf_flush();
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == -1) {
+        print_system_error("fork failed");
+        close(fds[0]);
+        close(fds[1]);
+        return 1;
+    }
+    if (pid == 0) {
+        setup_child_signal_handlers();
+        // The subshell's children are its own; it has no job control
+        jobs_forget_all();
+        jobs_init();
+        shell_set_interactive(0);
+        if (dup2(fds[1], STDOUT_FILENO) == -1) {
+            print_system_error("failed to redirect");
+            exit(1);
+        }
+        outbuf_retarget();
+        int ret = execute_sequence(seq);
+        outbuf_flush();
+        fflush(stdout);
+        exit(ret);
+    }
+
+    close(fds[1]);
+    job_t *job = jobs_add(0, &pid, NULL, 1, text, JOB_INTERNAL);
+    *size = read_all(fds[0]);
+    close(fds[0]);
+    if (!job) {
+        print_error("jobs: out of memory");
+        return 1;
+    }
+    return jobs_wait(job, NULL);
+}
+
+// Helper: $((expr)); @text is "(expr)". The expression is expanded like
+// a double-quoted word first, so it may use $VAR, $(...) and $((...)).
+static char *run_arith(arena_t *arena, const char *text, size_t *len) {
+    size_t size = strlen(text) - 2;
+    char *expr = arena_alloc(arena, size + 1);
+    long long value;
+    char digits[24];
+
+    *len = 0;
+    if (!expr) {
+        return "";
+    }
+    memcpy(expr, text + 1, size);
+    expr[size] = '\0';
+    expr = lexer_heredoc_word(arena, expr);
+    if (expr) {
+        expr = expand_env_var_in_string(arena, expr);
+    }
+
+    // A failed nested expansion fails this one too
+    if (!expr || expansion_failed || arith_eval(expr, &value) != 0) {
+        last_status = 1;
+        expansion_failed = 1;
+        return "";
+    }
+    last_status = 0;
+    int n = snprintf(digits, sizeof(digits), "%lld", value);
+    return finish_output(arena, digits, (size_t)n, len);
+}
+
+// Helper: produce the output of @text; sets last_status
+static char *substitute(arena_t *arena, const char *text, size_t *len) {
+    size_t text_len = strlen(text);
+    if (text_len >= 2 && text[0] == '(' && text[text_len - 1] == ')') {
+        return run_arith(arena, text, len);
+    }
+
+    int syntax_error = 0;
+    sequence_t *seq = parse_line(arena, text, &syntax_error);
+    // No lines follow the text of a $(...): here-documents in it end at once
+    if (parse_heredoc_pending(seq) && parse_heredoc_line(seq, NULL) != 0) {
+        seq = NULL;
+        syntax_error = 1;
+    }
+    if (!seq) {
+        last_status = syntax_error ? 2 : 0;
+        *len = 0;
+        return "";
+    }
+
+    command_t *cmd = single_command(seq);
+    redirect_t *redir = cmd ? cmd->redirects : NULL;
+    int read_only = cmd && cmd->argc == 0 && redir && !redir->next &&
+                    redir->type == REDIR_INPUT && redir->fd == STDIN_FILENO;
+    size_t size = 0;
+    const char *data = NULL;
+
+    if (cmd && (cmd->argc > 0 || !redir || read_only)) {
+        // Globbing never drops words, so argc stays zero or non-zero
+        if (expand_env_vars(arena, cmd) != 0) {
+            last_status = 1;
+        } else if (cmd->argc == 0 && !redir) {
+            int nested;
+            last_status = cmdsubst_take_status(&nested) ? nested : 0;
+        } else if (read_only) {
+            last_status = read_file(redir->target, &size);
+        } else if (!redir && cmd->assign_count == 0 && is_pure_builtin(cmd)) {
+            outbuf_capture_begin();
+            last_status = run_builtin(cmd);
+            data = outbuf_capture_end(&size);
+        } else {
+            last_status = capture_command(cmd, &size);
+        }
+    } else {
+        last_status = capture_subshell(seq, text, &size);
+    }
+    if (size == 0) {
+        *len = 0;
+        return "";
+    }
+    return finish_output(arena, data ? data : read_buffer, size, len);
+}
+
+/**
+ * cmdsubst_run - Run the command of a $(...) and capture its output.
+ * @arena: Arena for the parsed command, its expansions and the result.
+ * @text: Text between $( and ).
+ * @len: Receives the length of the result.
+ *
+ * A subshell is only forked when the command could change the shell's
+ * state. Pure builtins (echo, printf, pwd, test, ...) run in the shell
+ * with the output buffer collecting into memory, $(< file) reads the file,
+ * and bare assignments are skipped, since they would only reach the
+ * subshell. Any other single command is spawned with its stdout on a
+ * pipe, without copying the shell first.
+ * Returns: The output without trailing newlines, allocated from @arena.
+ */
+char *cmdsubst_run(arena_t *arena, const char *text, size_t *len) {
+    char *output = substitute(arena, text, len);
+    status_pending = 1;
+    return output;
+}
+
+/**
+ * cmdsubst_take_status - Collect the status of the last substitution.
+ * @status: Receives it, if one ran since the previous call.
+ *
+ * Returns: 1 if a substitution ran since the previous call, 0 otherwise.
+ */
+int cmdsubst_take_status(int *status) {
+    if (!status_pending) {
+        return 0;
+    }
+    *status = last_status;
+    status_pending = 0;
+    return 1;
+}
+
+/**
+ * cmdsubst_take_error - Collect a failed expansion.
+ *
+ * Set by an arithmetic error, including one in a nested $((...)), and
+ * cleared by the call.
+ * Returns: 1 if an expansion failed since the previous call, 0 otherwise.
+ */
+int cmdsubst_take_error(void) {
+    int failed = expansion_failed;
+    expansion_failed = 0;
+    return failed;
+}
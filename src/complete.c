@@ -0,0 +1,448 @@
+#define _GNU_SOURCE
+#include "complete.h"
+#include "builtins.h"
+#include "dirscan.h"
+#include "executor.h"
+#include "jobs.h"
+#include "pathindex.h"
+#include "utils.h"
+#include "vars.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <readline/readline.h>
+
+#define TRIE_INITIAL_NODES 1024
+#define MATCH_INITIAL_CAPACITY 16
+#define COMPLETE_WORD_BREAKS " \t\n\"'<>;|&()"
+
+// Where a command name comes from (a name may have both)
+#define SOURCE_PATH    0x01
+#define SOURCE_BUILTIN 0x02
+
+// Trie node; node 0 is the root
+typedef struct {
+    uint32_t child;         // First child, 0 if none
+    uint32_t sibling;       // Next sibling in ascending byte order, 0 if none
+    unsigned char byte;
+    unsigned char sources;  // Non-zero when a command name ends here
+} trie_node_t;
+
+// Matches being collected
+typedef struct {
+    char **items;
+    size_t count;
+    size_t capacity;
+} match_list_t;
+
+// Last directory listed for path completion
+typedef struct {
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    match_list_t names;     // Entry names, sorted
+} dir_cache_t;
+
+static trie_node_t *nodes = NULL;
+static uint32_t node_count = 0;
+static uint32_t node_capacity = 0;
+
+static dir_cache_t dir_cache;
+
+// Helper: add an allocated string to a match list (freed on failure)
+static void list_add(match_list_t *list, char *item) {
+    if (!item) return;
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : MATCH_INITIAL_CAPACITY;
+        char **grown = realloc(list->items, capacity * sizeof(char *));
+        if (!grown) {
+            free(item);
+            return;
+        }
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = item;
+}
+
+// Helper: free a match list's strings and array
+static void list_free(match_list_t *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+// Helper: qsort comparison for strings
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Helper: turn a match list into readline's format (the list is consumed)
+static char **list_to_matches(match_list_t *list) {
+    if (list->count == 0) {
+        list_free(list);
+        return NULL;
+    }
+    char **matches = malloc((list->count + 2) * sizeof(char *));
+    if (!matches) {
+        list_free(list);
+        return NULL;
+    }
+
+    size_t common = strlen(list->items[0]);
+    for (size_t i = 1; i < list->count; i++) {
+        size_t n = 0;
+        while (n < common && list->items[i][n] == list->items[0][n]) n++;
+        common = n;
+    }
+    matches[0] = strndup(list->items[0], common);
+    memcpy(matches + 1, list->items, list->count * sizeof(char *));
+    matches[list->count + 1] = NULL;
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+    return matches;
+}
+
+// Helper: child of @parent labelled @byte, created in sorted position when
+// @create is set. Returns: Node index, or 0 if absent.
+static uint32_t trie_child(uint32_t parent, unsigned char byte, int create) {
+    if (create && node_count == node_capacity) {
+        // Grow first: the links walked below point into the array
+        trie_node_t *grown = realloc(nodes, node_capacity * 2 * sizeof(trie_node_t));
+        if (!grown) return 0;
+        nodes = grown;
+        node_capacity *= 2;
+    }
+
+    uint32_t *link = &nodes[parent].child;
+    while (*link && nodes[*link].byte < byte) {
+        link = &nodes[*link].sibling;
+    }
+    if (*link && nodes[*link].byte == byte) {
+        return *link;
+    }
+    if (!create) {
+        return 0;
+    }
+
+    uint32_t id = node_count++;
+    nodes[id].child = 0;
+    nodes[id].sibling = *link;
+    nodes[id].byte = byte;
+    nodes[id].sources = 0;
+    *link = id;
+    return id;
+}
+
+// Helper: node reached by @name, or 0 if no name starts with it
+static uint32_t trie_find(const char *name) {
+    uint32_t node = 0;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        node = trie_child(node, *p, 0);
+        if (node == 0) return 0;
+    }
+    return node;
+}
+
+// Helper: add @name from @source; shared prefixes are stored once
+static void trie_insert(const char *name, unsigned char source) {
+    if (!nodes) {
+        nodes = malloc(TRIE_INITIAL_NODES * sizeof(trie_node_t));
+        if (!nodes) return;
+        node_capacity = TRIE_INITIAL_NODES;
+        node_count = 1;
+        memset(&nodes[0], 0, sizeof(trie_node_t));
+    }
+    uint32_t node = 0;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        node = trie_child(node, *p, 1);
+        if (node == 0) return;
+    }
+    if (node != 0) nodes[node].sources |= source;
+}
+
+// Helper: drop @source from @name, or from every name when @name is NULL.
+// Nodes are kept, so a name that comes back costs no allocation.
+static void trie_remove(const char *name, unsigned char source) {
+    if (!nodes) return;  // trie_find needs a root
+    if (!name) {
+        for (uint32_t i = 0; i < node_count; i++) nodes[i].sources &= ~source;
+        return;
+    }
+    uint32_t node = trie_find(name);
+    if (node != 0) nodes[node].sources &= ~source;
+}
+
+// Helper: add every name below @node to @list, in sorted order; @buf holds
+// the @len bytes leading to @node
+static void trie_collect(uint32_t node, char *buf, size_t len, match_list_t *list) {
+    if (node != 0 && nodes[node].sources) {
+        list_add(list, strndup(buf, len));
+    }
+    if (len + 1 >= NAME_MAX + 1) return;
+    for (uint32_t child = nodes[node].child; child; child = nodes[child].sibling) {
+        buf[len] = (char)nodes[child].byte;
+        trie_collect(child, buf, len + 1, list);
+    }
+}
+
+// Helper: pathindex hook keeping the trie in step with PATH
+static void on_path_change(const char *name, int present) {
+    if (present) {
+        trie_insert(name, SOURCE_PATH);
+    } else {
+        trie_remove(name, SOURCE_PATH);
+    }
+}
+
+// Helper: command names starting with @prefix
+static void complete_commands(const char *prefix, match_list_t *list) {
+    char buf[NAME_MAX + 1];
+    size_t len = strlen(prefix);
+
+    // Apply PATH changes (a non-blocking read when nothing happened)
+    sync_path_cache();
+    pathindex_sync();
+
+    if (!nodes) return;
+    uint32_t node = trie_find(prefix);
+    if (len > NAME_MAX || (node == 0 && len > 0)) return;
+    memcpy(buf, prefix, len);
+    trie_collect(node, buf, len, list);
+}
+
+// Context for collect_variable
+typedef struct {
+    const char *prefix;     // Name typed so far
+    size_t prefix_len;
+    const char *lead;       // Word text up to the name ("$", "x=${", ...)
+    size_t lead_len;
+    int brace;
+    match_list_t *list;
+} var_ctx_t;
+
+// Helper: vars_each callback adding names that start with the prefix
+static int collect_variable(const char *name, size_t len, void *arg) {
+    var_ctx_t *ctx = arg;
+    if (len < ctx->prefix_len || memcmp(name, ctx->prefix, ctx->prefix_len) != 0) {
+        return 0;
+    }
+    char *match = malloc(ctx->lead_len + len + 2);
+    if (!match) return 0;
+    memcpy(match, ctx->lead, ctx->lead_len);
+    memcpy(match + ctx->lead_len, name, len);
+    size_t end = ctx->lead_len + len;
+    if (ctx->brace) match[end++] = '}';
+    match[end] = '\0';
+    list_add(ctx->list, match);
+    return 0;
+}
+
+// Helper: variable names for a word whose last '$' is at @dollar
+static void complete_variables(const char *word, const char *dollar, match_list_t *list) {
+    var_ctx_t ctx;
+    ctx.brace = dollar[1] == '{';
+    ctx.prefix = dollar + 1 + ctx.brace;
+    ctx.prefix_len = strlen(ctx.prefix);
+    ctx.lead = word;
+    ctx.lead_len = (size_t)(ctx.prefix - word);
+    ctx.list = list;
+    vars_each(collect_variable, &ctx);
+    qsort(list->items, list->count, sizeof(char *), compare_strings);
+}
+
+// Helper: job specs (%n) starting with @word
+static void complete_jobs(const char *word, match_list_t *list) {
+    char spec[32];
+    size_t len = strlen(word);
+    for (job_t *job = jobs_next(NULL); job; job = jobs_next(job)) {
+        snprintf(spec, sizeof(spec), "%%%d", job->id);
+        if (strncmp(spec, word, len) == 0) {
+            list_add(list, strdup_safe(spec));
+        }
+    }
+}
+
+// Helper: dirscan callback filling the directory cache
+static int cache_entry(const char *name, size_t len, unsigned char type, void *arg) {
+    (void)type;
+    list_add(arg, strndup(name, len));
+    return 0;
+}
+
+// Helper: entries of @dir, read again only when the directory changed.
+// Returns: Cached listing, or NULL if the directory cannot be read.
+static const match_list_t *list_directory(const char *dir) {
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return NULL;
+    }
+    if (dir_cache.path && strcmp(dir_cache.path, dir) == 0 &&
+        dir_cache.dev == st.st_dev && dir_cache.ino == st.st_ino &&
+        dir_cache.mtime.tv_sec == st.st_mtim.tv_sec &&
+        dir_cache.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+        return &dir_cache.names;
+    }
+
+    free(dir_cache.path);
+    list_free(&dir_cache.names);
+    dir_cache.path = NULL;
+    if (dirscan_path(dir, cache_entry, &dir_cache.names) != 0) {
+        list_free(&dir_cache.names);
+        return NULL;
+    }
+    qsort(dir_cache.names.items, dir_cache.names.count, sizeof(char *), compare_strings);
+    dir_cache.path = strdup_safe(dir);
+    dir_cache.dev = st.st_dev;
+    dir_cache.ino = st.st_ino;
+    dir_cache.mtime = st.st_mtim;
+    return &dir_cache.names;
+}
+
+// Helper: file names completing @word (relative, absolute or ~/)
+static void complete_paths(const char *word, match_list_t *list) {
+    char dir[PATH_MAX];
+    const char *slash = strrchr(word, '/');
+    const char *base = slash ? slash + 1 : word;
+    size_t lead_len = (size_t)(base - word);
+
+    if (!slash) {
+        strcpy(dir, ".");
+    } else if (word[0] == '~' && word[1] == '/') {
+        const char *home = vars_get("HOME");
+        int n = snprintf(dir, sizeof(dir), "%s/%.*s", home ? home : "",
+                         (int)(lead_len - 2), word + 2);
+        if (n < 0 || (size_t)n >= sizeof(dir)) return;
+    } else if (lead_len == 1) {
+        strcpy(dir, "/");
+    } else {
+        if (lead_len >= sizeof(dir)) return;
+        memcpy(dir, word, lead_len - 1);
+        dir[lead_len - 1] = '\0';
+    }
+
+    const match_list_t *names = list_directory(dir);
+    if (!names) return;
+
+    // Sorted listing: the matches are one contiguous run
+    size_t base_len = strlen(base);
+    size_t lo = 0, hi = names->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strncmp(names->items[mid], base, base_len) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    for (size_t i = lo; i < names->count && strncmp(names->items[i], base, base_len) == 0; i++) {
+        const char *name = names->items[i];
+        if (name[0] == '.' && base[0] != '.') continue;  // Hidden unless asked for
+        size_t name_len = strlen(name);
+        char *match = malloc(lead_len + name_len + 1);
+        if (!match) continue;
+        memcpy(match, word, lead_len);
+        memcpy(match + lead_len, name, name_len + 1);
+        list_add(list, match);
+    }
+}
+
+// Helper: check whether the word at @start is where a command name goes
+static int command_position(const char *line, int start) {
+    int i = start - 1;
+    while (i >= 0 && (line[i] == ' ' || line[i] == '\t')) {
+        i--;
+    }
+    return i < 0 || strchr(";|&(", line[i]) != NULL;
+}
+
+// Helper: find a "$NAME" or "${NAME" being typed at the end of @word
+static const char *variable_start(const char *word) {
+    const char *dollar = strrchr(word, '$');
+    if (!dollar) return NULL;
+    const char *p = dollar + 1 + (dollar[1] == '{');
+    if (isdigit((unsigned char)*p)) return NULL;
+    while (*p == '_' || isalnum((unsigned char)*p)) p++;
+    return *p == '\0' ? dollar : NULL;
+}
+
+/**
+ * complete_word - Compute completions for one word of a line.
+ * @line: Whole line being edited.
+ * @start: Offset of the word.
+ * @end: Offset just past the word.
+ *
+ * A word ending in $NAME or ${NAME completes variable names, %n job
+ * specs, a word in command position (start of line or after ; | & ()
+ * command names from the trie, and anything else file names. Command
+ * completion walks only the trie below the typed prefix, and file
+ * completion lists a directory again only after its mtime changed.
+ * Returns: readline match array, or NULL if nothing matches.
+ */
+char **complete_word(const char *line, int start, int end) {
+    match_list_t list = { NULL, 0, 0 };
+    char *word = strndup(line + start, (size_t)(end - start));
+    if (!word) return NULL;
+
+    const char *dollar = variable_start(word);
+    rl_filename_completion_desired = 0;
+    if (dollar) {
+        complete_variables(word, dollar, &list);
+    } else if (word[0] == '%') {
+        complete_jobs(word, &list);
+    } else if (command_position(line, start) && !strchr(word, '/')) {
+        complete_commands(word, &list);
+    } else {
+        complete_paths(word, &list);
+        rl_filename_completion_desired = 1;  // readline marks directories
+    }
+    free(word);
+    return list_to_matches(&list);
+}
+
+// Helper: readline's attempted-completion hook
+static char **attempt_completion(const char *text, int start, int end) {
+    (void)text;
+    // ~user is left to readline, which knows how to expand it
+    if (rl_line_buffer[start] == '~' && !memchr(rl_line_buffer + start, '/', end - start)) {
+        return NULL;
+    }
+    rl_attempted_completion_over = 1;
+    return complete_word(rl_line_buffer, start, end);
+}
+
+/**
+ * complete_init - Install the completion engine.
+ *
+ * Builtin names go into the trie now; PATH names arrive through the PATH
+ * index's change hook as directories are read and as inotify reports
+ * files coming and going, so TAB never lists a PATH directory itself.
+ */
+void complete_init(void) {
+    const builtin_t *builtins = get_builtins();
+    for (int i = 0; builtins[i].name; i++) {
+        trie_insert(builtins[i].name, SOURCE_BUILTIN);
+    }
+    pathindex_set_watch(on_path_change);
+
+    rl_attempted_completion_function = attempt_completion;
+    rl_completer_word_break_characters = COMPLETE_WORD_BREAKS;
+}
+
+/**
+ * complete_destroy - Free the trie and the directory cache.
+ */
+void complete_destroy(void) {
+    pathindex_set_watch(NULL);
+    free(nodes);
+    nodes = NULL;
+    node_count = node_capacity = 0;
+    free(dir_cache.path);
+    dir_cache.path = NULL;
+    list_free(&dir_cache.names);
+}
@@ -0,0 +1,90 @@
+#define _GNU_SOURCE
+#include "dirscan.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+// Kernel record layout returned by getdents64
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Large enough to read a few hundred entries per system call
+#define DIRSCAN_BUFFER_SIZE (64 * 1024)
+
+/**
+ * dirscan_fd - Read all entries of an open directory.
+ * @dirfd: Directory descriptor, positioned at the start.
+ * @func: Callback for each entry (d_type is DT_UNKNOWN on some filesystems).
+ * @ctx: Passed through to @func.
+ *
+ * Uses getdents64 directly, so no DIR stream is allocated and no stat is
+ * issued per entry.
+ * Returns: 0 on success (or when @func stopped the scan), -1 on error.
+ */
+int dirscan_fd(int dirfd, dirscan_func_t func, void *ctx) {
+    // Heap buffer so callbacks may start nested scans; malloc alignment
+    // suits the 64-bit fields at the start of each record
+    char *buffer = malloc(DIRSCAN_BUFFER_SIZE);
+    if (!buffer) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (;;) {
+        long nread = syscall(SYS_getdents64, dirfd, buffer, DIRSCAN_BUFFER_SIZE);
+        if (nread == -1) {
+            if (errno == EINTR) continue;
+            int saved_errno = errno;
+            free(buffer);
+            errno = saved_errno;
+            return -1;
+        }
+        if (nread == 0) {
+            free(buffer);
+            return 0;
+        }
+
+        for (long offset = 0; offset < nread;) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)(buffer + offset);
+            offset += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            if (func(name, strlen(name), entry->d_type, ctx)) {
+                free(buffer);
+                return 0;
+            }
+        }
+    }
+}
+
+/**
+ * dirscan_path - Open a directory and read all of its entries.
+ * @path: Directory path.
+ * @func: Callback for each entry.
+ * @ctx: Passed through to @func.
+ *
+ * Returns: 0 on success, -1 on error.
+ */
+int dirscan_path(const char *path, dirscan_func_t func, void *ctx) {
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    int ret = dirscan_fd(fd, func, ctx);
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return ret;
+}
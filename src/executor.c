@@ -1,423 +1,1011 @@
+#define _GNU_SOURCE
 #include "executor.h"
 #include "builtins.h"
+#include "cmdhash.h"
+#include "cmdsubst.h"
+#include "jobs.h"
+#include "launch.h"
+#include "lexer.h"
+#include "options.h"
+#include "outbuf.h"
+#include "pathindex.h"
 #include "utils.h"
+#include "vars.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <errno.h>
+#include <limits.h>
 
-/**
- * execute_command - Entry point for executing a parsed command structure.
- * @cmd: Command to execute.
- *
- * Handles chaining, logical operators, and delegates to single command execution.
- * Returns: Exit status code.
- */
-int execute_command(command_t *cmd) {
-    if (!cmd || !cmd->args || cmd->argc == 0) {
-        return 1;
+// Cached split of $PATH used by find_command
+static char **cached_paths = NULL;
+static char *cached_path_env = NULL;
+static int cached_path_count = 0;
+
+// Exit status of the last foreground command, and of each pipeline stage
+static int last_status = 0;
+static int *pipestatus = NULL;
+static int pipestatus_count = 0;
+static int pipestatus_capacity = 0;
+
+// Helper: count the descriptors a command's redirections bind
+static int count_redirections(const command_t *cmd) {
+    int count = 0;
+    for (const redirect_t *r = cmd->redirects; r; r = r->next) {
+        count += r->type == REDIR_OUTPUT_ALL ? 2 : 1;
     }
+    return count;
+}
 
-    // Expand environment variables in command arguments
-    expand_env_vars(cmd);
+// Helper: close descriptors opened by open_redirections (an &> file appears
+// twice in a row but is open once)
+static void close_redirections(launch_dup_t *dups, int count) {
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && dups[i].fd == dups[i - 1].fd) continue;
+        close(dups[i].fd);
+    }
+}
 
-    // Handle command chaining (;)
-    if (cmd->next_command) {
-        int status = execute_single_command(cmd);
-        command_t *next_cmd = parse_command(cmd->next_command);
-        if (next_cmd) {
-            int next_status = execute_command(next_cmd);
-            free_command(next_cmd);
-            return next_status;
+// Helper: put here-document text (plus @suffix) into a sealed memfd, read
+// from the start. No file is created and no writer process is needed, so
+// a body of any size is ready before the command starts.
+// Returns: The descriptor, or -1 with errno set.
+static int open_heredoc(const char *text, const char *suffix) {
+    int fd = memfd_create("lemuen-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd == -1) {
+        return -1;
+    }
+    struct iovec iov[2] = {
+        { (void *)text, strlen(text) }, { (void *)suffix, strlen(suffix) }
+    };
+    struct iovec *next = iov;
+    int count = 2;
+    while (count > 0) {
+        ssize_t n = writev(fd, next, count);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return -1;
+        }
+        while (count > 0 && (size_t)n >= next->iov_len) {
+            n -= (ssize_t)next->iov_len;
+            next++;
+            count--;
+        }
+        if (count > 0) {
+            next->iov_base = (char *)next->iov_base + n;
+            next->iov_len -= (size_t)n;
         }
-        return status;
     }
+    // Sealed, the command sees exactly this text however it got the fd
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+// Helper: open the command's redirection targets in the parent, in order.
+// Files are opened close-on-exec and handed to the launcher as dup2 actions.
+// Returns: Number of entries filled in @dups, or -1 on error (nothing left open).
+static int open_redirections(command_t *cmd, launch_dup_t *dups) {
+    int count = 0;
+
+    for (const redirect_t *r = cmd->redirects; r; r = r->next) {
+        int flags;
+        const char *what;
+        switch (r->type) {
+        case REDIR_INPUT:
+            flags = O_RDONLY;
+            what = "input";
+            break;
+        case REDIR_APPEND:
+            flags = O_WRONLY | O_CREAT | O_APPEND;
+            what = "output";
+            break;
+        default:
+            flags = O_WRONLY | O_CREAT | O_TRUNC;
+            what = "output";
+            break;
+        }
 
-    // Handle logical operators (&&, ||)
-    if (cmd->logic_op != LOGIC_NONE && cmd->next_logic_command) {
-        return execute_with_logical(cmd);
+        int fd;
+        if (r->type == REDIR_HEREDOC || r->type == REDIR_HERESTRING) {
+            fd = open_heredoc(r->target, r->type == REDIR_HERESTRING ? "\n" : "");
+            if (fd == -1) {
+                print_error("failed to create here-document: %s", strerror(errno));
+                close_redirections(dups, count);
+                return -1;
+            }
+        } else {
+            fd = open(r->target, flags | O_CLOEXEC, 0644);
+        }
+        if (fd == -1) {
+            print_error("failed to open %s file %s: %s", what, r->target, strerror(errno));
+            close_redirections(dups, count);
+            return -1;
+        }
+        dups[count].fd = fd;
+        dups[count].target = r->fd;
+        count++;
+        if (r->type == REDIR_OUTPUT_ALL) {
+            // Same open file for stderr
+            dups[count].fd = fd;
+            dups[count].target = STDERR_FILENO;
+            count++;
+        }
     }
 
-    // Execute single command
-    return execute_single_command(cmd);
+    return count;
+}
+
+// Helper: give up on a half-applied frame: close the opened files and put
+// back whatever was already rebound
+static int abandon_frame(redirect_frame_t *frame, launch_dup_t *dups, int count) {
+    print_system_error("failed to redirect");
+    close_redirections(dups, count);
+    free(dups);
+    redirect_frame_pop(frame);
+    return -1;
 }
 
 /**
- * execute_single_command - Execute a single command (builtin or external).
- * @cmd: Command to execute.
+ * redirect_frame_push - Apply a command's redirections to the shell itself.
+ * @cmd: Command whose redirections to apply.
+ * @frame: Receives what is needed to undo them.
  *
- * Handles background execution, redirection, and builtin/external distinction.
- * Returns: Exit status code.
+ * Each descriptor a redirection binds is first copied out of the way with
+ * F_DUPFD_CLOEXEC, so the copy never reaches child processes, and then
+ * replaced with dup2. stdio is flushed first so earlier output goes to the
+ * old files.
+ * Returns: 0 on success, -1 after printing an error (nothing is changed).
  */
-int execute_single_command(command_t *cmd) {
-    if (!cmd) {
-        return 1;
-    }
-    
-    // Handle empty command
-    if (!cmd->args || cmd->argc == 0) {
-        return 0;  // Empty command succeeds
+int redirect_frame_push(command_t *cmd, redirect_frame_t *frame) {
+    frame->saves = NULL;
+    frame->count = 0;
+    if (!cmd->redirects) {
+        return 0;
     }
 
-    // Expand environment variables in command arguments
-    expand_env_vars(cmd);
-
-    // Handle builtin commands without redirection/background directly
-    if (is_builtin(cmd) && !cmd->input_redirect && !cmd->output_redirect && !cmd->background) {
-        return run_builtin(cmd);
+    int count = count_redirections(cmd);
+    launch_dup_t *dups = malloc(count * sizeof(launch_dup_t));
+    frame->saves = malloc(count * sizeof(redirect_save_t));
+    if (!dups || !frame->saves) {
+        print_error("out of memory");
+        free(dups);
+        free(frame->saves);
+        frame->saves = NULL;
+        return -1;
     }
-
-    // Handle background execution
-    if (cmd->background) {
-        return execute_background(cmd);
+    count = open_redirections(cmd, dups);
+    if (count < 0) {
+        free(dups);
+        redirect_frame_pop(frame);
+        return -1;
     }
 
-    // Handle redirections for all commands (both builtin and external)
-    if (cmd->input_redirect || cmd->output_redirect) {
-        return execute_with_redirection(cmd);
+    // A file opened while a standard descriptor was closed may have taken
+    // its number: move it out of the way before anything is rebound
+    for (int i = 0; i < count; i++) {
+        int fd = dups[i].fd;
+        if (fd >= REDIRECT_SAVE_MIN_FD) continue;
+        int moved = fcntl(fd, F_DUPFD_CLOEXEC, REDIRECT_SAVE_MIN_FD);
+        if (moved == -1) {
+            return abandon_frame(frame, dups, count);
+        }
+        for (int j = i; j < count; j++) {
+            if (dups[j].fd == fd) dups[j].fd = moved;
+        }
+        close(fd);
     }
 
-    // No redirection - handle external
-    return execute_external(cmd);
+    outbuf_flush();
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < count; i++) {
+        int target = dups[i].target;
+        int saved = 0;
+        for (int j = 0; j < frame->count; j++) {
+            if (frame->saves[j].target == target) saved = 1;
+        }
+        if (!saved) {
+            // -1 records that the descriptor was closed
+            int copy = fcntl(target, F_DUPFD_CLOEXEC, REDIRECT_SAVE_MIN_FD);
+            if (copy == -1 && errno != EBADF) {
+                return abandon_frame(frame, dups, count);
+            }
+            frame->saves[frame->count].target = target;
+            frame->saves[frame->count].saved = copy;
+            frame->count++;
+        }
+        if (dup2(dups[i].fd, target) == -1) {
+            return abandon_frame(frame, dups, count);
+        }
+    }
+    close_redirections(dups, count);
+    free(dups);
+    outbuf_retarget();
+    return 0;
 }
 
 /**
- * execute_with_redirection - Execute a command with I/O redirection in a child process.
- * @cmd: Command to execute.
+ * redirect_frame_pop - Undo redirect_frame_push.
+ * @frame: Frame filled by redirect_frame_push.
  *
- * Handles input/output file redirection and executes builtin or external command.
- * Returns: Exit status code.
+ * Flushes stdio, then puts each saved descriptor back (or closes the ones
+ * that were closed before) in reverse order.
  */
-int execute_with_redirection(command_t *cmd) {
-    pid_t pid = fork();
-    
-    if (pid == -1) {
-        print_system_error("fork failed");
+void redirect_frame_pop(redirect_frame_t *frame) {
+    if (!frame->saves) {
+        return;
+    }
+    outbuf_flush();
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = frame->count - 1; i >= 0; i--) {
+        redirect_save_t *save = &frame->saves[i];
+        if (save->saved >= 0) {
+            dup2(save->saved, save->target);
+            close(save->saved);
+        } else {
+            close(save->target);
+        }
+    }
+    free(frame->saves);
+    frame->saves = NULL;
+    frame->count = 0;
+    outbuf_retarget();
+}
+
+// Helper: apply a command's NAME=value prefixes as shell variables
+static void apply_assignments(command_t *cmd) {
+    for (int i = 0; i < cmd->assign_count; i++) {
+        vars_assign(cmd->assigns[i], 0);
+    }
+}
+
+// Helper: run a builtin (or bare assignments) in the shell, with its
+// redirections applied around it. Assignments before a builtin stay set,
+// as for POSIX special builtins.
+// Returns: Exit status.
+static int run_in_shell(command_t *cmd) {
+    redirect_frame_t frame;
+    if (redirect_frame_push(cmd, &frame) != 0) {
         return 1;
     }
-    
-    if (pid == 0) {
-        // Child process
-        
-        // Handle input redirection
-        if (cmd->input_redirect) {
-            int fd = open(cmd->input_redirect, O_RDONLY);
-            if (fd == -1) {
-                print_system_error("failed to open input file");
-                exit(1);
-            }
-            if (dup2(fd, STDIN_FILENO) == -1) {
-                print_system_error("failed to redirect input");
-                close(fd);
-                exit(1);
-            }
-            close(fd);
+    apply_assignments(cmd);
+    int status = cmd->argc > 0 ? run_builtin(cmd) : 0;
+    redirect_frame_pop(&frame);
+    return status;
+}
+
+// Helper: run the last stage of a pipeline in the shell with @in_fd (the
+// read end of the pipe, closed here) as its stdin
+static int run_last_stage(command_t *cmd, int in_fd) {
+    int saved = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, REDIRECT_SAVE_MIN_FD);
+    if ((saved == -1 && errno != EBADF) || dup2(in_fd, STDIN_FILENO) == -1) {
+        print_system_error("failed to redirect");
+        if (saved >= 0) close(saved);
+        close(in_fd);
+        return 1;
+    }
+    close(in_fd);
+
+    int status = run_in_shell(cmd);
+
+    if (saved >= 0) {
+        dup2(saved, STDIN_FILENO);
+        close(saved);
+    } else {
+        close(STDIN_FILENO);
+    }
+    return status;
+}
+
+// Helper: start one command as a child process.
+// @in_fd/@out_fd: pipe ends to bind to stdin/stdout, or -1.
+// @spare_fd: descriptor a forked builtin child must close (next pipe's read end), or -1.
+// @pgid: process group as in launch_opts_t.
+// File redirections are applied after the pipe ends, so they take precedence.
+// Returns: Child pid, or -1 after printing an error (@status is set).
+static pid_t launch_command(command_t *cmd, int in_fd, int out_fd, int spare_fd,
+                            pid_t pgid, int *status) {
+    launch_dup_t *dups = malloc((2 + count_redirections(cmd)) * sizeof(launch_dup_t));
+    int pipe_count = 0;
+
+    if (!dups) {
+        print_error("out of memory");
+        *status = 1;
+        return -1;
+    }
+    if (in_fd >= 0) {
+        dups[pipe_count].fd = in_fd;
+        dups[pipe_count].target = STDIN_FILENO;
+        pipe_count++;
+    }
+    if (out_fd >= 0) {
+        dups[pipe_count].fd = out_fd;
+        dups[pipe_count].target = STDOUT_FILENO;
+        pipe_count++;
+    }
+
+    const char *command_path = NULL;
+    int shell_code = cmd->argc == 0 || is_builtin(cmd);
+    if (!shell_code) {
+        command_path = find_command(cmd->args[0]);
+        if (!command_path) {
+            print_error("command not found: %s", cmd->args[0]);
+            *status = 127;
+            free(dups);
+            return -1;
         }
-        
-        // Handle output redirection
-        if (cmd->output_redirect) {
-            int flags = O_WRONLY | O_CREAT;
-            flags |= cmd->append_output ? O_APPEND : O_TRUNC;
-            
-            int fd = open(cmd->output_redirect, flags, 0644);
-            if (fd == -1) {
-                print_system_error("failed to open output file");
-                exit(1);
+    }
+
+    int file_count = open_redirections(cmd, dups + pipe_count);
+    if (file_count < 0) {
+        *status = 1;
+        free(dups);
+        return -1;
+    }
+    int dup_count = pipe_count + file_count;
+    pid_t pid;
+
+    if (shell_code) {
+        // Builtins are shell code: fork a child to run them with the fds bound
+        outbuf_flush();
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            if (pgid >= 0) {
+                setpgid(0, pgid);
+            }
+            setup_child_signal_handlers();
+            for (int i = 0; i < dup_count; i++) {
+                if (dup2(dups[i].fd, dups[i].target) == -1) {
+                    print_system_error("failed to redirect");
+                    exit(1);
+                }
             }
-            if (dup2(fd, STDOUT_FILENO) == -1) {
-                print_system_error("failed to redirect output");
-                close(fd);
-                exit(1);
+            close_redirections(dups, dup_count);
+            if (spare_fd >= 0) {
+                close(spare_fd);
             }
-            close(fd);
-        }
-        
-        // Execute the command (builtin or external)
-        if (is_builtin(cmd)) {
-            int ret = run_builtin(cmd);
+            outbuf_retarget();
+
+            apply_assignments(cmd);
+            int ret = cmd->argc > 0 ? run_builtin(cmd) : 0;
             fflush(stdout);
             exit(ret);
-        } else {
-            execvp(cmd->args[0], cmd->args);
-            print_system_error("exec failed");
-            exit(1);
+        }
+        if (pid == -1) {
+            print_system_error("fork failed");
+            *status = 1;
+        } else if (pgid >= 0) {
+            setpgid(pid, pgid == 0 ? pid : pgid);
         }
     } else {
-        // Parent process
-        int status;
-        waitpid(pid, &status, 0);
-        return WEXITSTATUS(status);
+        // Prefix assignments (FOO=1 cmd) only reach this command's environment
+        char **overlay = NULL;
+        if (cmd->assign_count > 0) {
+            overlay = vars_envp_overlay(cmd->assigns, cmd->assign_count);
+        }
+        launch_opts_t opts = { dups, dup_count, pgid, overlay ? overlay : vars_envp() };
+        pid = launch_process(command_path, cmd->args, &opts);
+        if (pid == -1 && errno == ENOENT && command_path != cmd->args[0]) {
+            // Stale hashed location: forget it and search PATH once more
+            cmdhash_remove(cmd->args[0]);
+            command_path = find_command(cmd->args[0]);
+            if (command_path) {
+                pid = launch_process(command_path, cmd->args, &opts);
+            } else {
+                print_error("command not found: %s", cmd->args[0]);
+                *status = 127;
+            }
+        }
+        if (pid == -1 && command_path) {
+            print_error("%s: exec failed: %s", cmd->args[0], strerror(errno));
+            *status = (errno == ENOENT) ? 127 : 126;
+        }
+        free(overlay);
     }
+
+    close_redirections(dups + pipe_count, file_count);
+    free(dups);
+    return pid;
 }
 
-/**
- * execute_background - Execute a command in the background (asynchronously).
- * @cmd: Command to execute.
- *
- * Forks a new process group and does not wait for completion.
- * Returns: 0 on success, 1 on error.
- */
-int execute_background(command_t *cmd) {
+// Helper: check whether the shell is the terminal's foreground process group
+static int shell_owns_terminal(void) {
+    return isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+}
+
+// Helper: record the statuses of the last foreground command or pipeline
+static void record_statuses(const int *statuses, int count) {
+    if (count > pipestatus_capacity) {
+        int *grown = realloc(pipestatus, count * sizeof(int));
+        if (!grown) {
+            count = pipestatus_capacity;
+        } else {
+            pipestatus = grown;
+            pipestatus_capacity = count;
+        }
+    }
+    if (count > 0) {
+        memcpy(pipestatus, statuses, count * sizeof(int));
+    }
+    pipestatus_count = count;
+    last_status = count > 0 ? statuses[count - 1] : 0;
+}
+
+// Helper: append a word to a job's command text, without quote markers
+static void append_text_word(arena_str_t *out, const char *word) {
+    for (; *word; word++) {
+        if (*word != LEX_CTLESC) {
+            arena_str_putc(out, *word);
+        } else if (word[1] == LEX_CMDSUB_OPEN) {
+            arena_str_putc(out, '$');  // The ( and ) follow as they are
+        }
+    }
+}
+
+// Helper: append a pipeline's stages, joined by " | "
+static void append_pipeline_text(arena_str_t *out, const command_t *cmd) {
+    for (const command_t *stage = cmd; stage; stage = stage->next_pipe) {
+        if (stage != cmd) arena_str_append(out, " | ", 3);
+        for (int i = 0; i < stage->assign_count + stage->argc; i++) {
+            if (i > 0) arena_str_putc(out, ' ');
+            append_text_word(out, i < stage->assign_count ? stage->assigns[i] :
+                                  stage->args[i - stage->assign_count]);
+        }
+    }
+}
+
+// Helper: command text of a pipeline, as shown by `jobs`
+static const char *pipeline_text(arena_t *arena, const command_t *cmd) {
+    arena_str_t out;
+    arena_str_init(&out, arena);
+    append_pipeline_text(&out, cmd);
+    return out.data;
+}
+
+// Helper: register started processes as a background job and announce it
+static void add_background_job(pid_t pgid, const pid_t *pids, const int *statuses,
+                               int count, const char *text) {
+    job_t *job = jobs_add(pgid, pids, statuses, count, text, JOB_BACKGROUND);
+    if (!job) {
+        print_error("jobs: out of memory");
+        return;
+    }
+    if (shell_is_interactive()) {
+        printf("[%d] %d\n", job->id, (int)jobs_last_background_pid());
+        fflush(stdout);
+    }
+}
+
+// Helper: wait for a foreground job, with the terminal handed to its
+// process group while it runs.
+// Returns: Status from jobs_wait; @statuses receives each stage's status.
+static int wait_job_in_foreground(job_t *job, int *statuses) {
+    int owns_terminal = job->pgid > 0 && shell_owns_terminal();
+    if (owns_terminal) {
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    }
+    int status = jobs_wait(job, statuses);
+    if (owns_terminal) {
+        tcsetpgrp(STDIN_FILENO, getpgrp());
+    }
+    return status;
+}
+
+// Helper: register foreground processes as a job and wait for it.
+// Returns: Status from jobs_wait; @statuses receives each stage's status.
+static int wait_foreground_job(pid_t pgid, const pid_t *pids, int *statuses,
+                               int count, const char *text) {
+    job_t *job = jobs_add(pgid > 0 ? pgid : 0, pids, statuses, count, text, 0);
+    if (!job) {
+        print_error("jobs: out of memory");
+        return 1;
+    }
+    return wait_job_in_foreground(job, statuses);
+}
+
+// Helper: run an and-or list in a background subshell
+static int execute_and_or_background(and_or_t *list, arena_t *arena) {
+    arena_str_t text;
+    arena_str_init(&text, arena);
+    for (pipeline_t *pipeline = list->pipelines; pipeline; pipeline = pipeline->next) {
+        append_pipeline_text(&text, pipeline->commands);
+        if (pipeline->next) {
+            arena_str_append(&text, pipeline->next_op == LOGIC_AND ? " && " : " || ", 4);
+        }
+    }
+
+    fflush(stdout);
     pid_t pid = fork();
-    
     if (pid == -1) {
         print_system_error("fork failed");
         return 1;
     }
-    
     if (pid == 0) {
-        // Child process - run in background
-        setpgid(0, 0);  // Create new process group
-        
-        if (cmd->input_redirect || cmd->output_redirect) {
-            execute_with_redirection(cmd);
-        } else {
-            execvp(cmd->args[0], cmd->args);
-            print_system_error("exec failed");
-        }
-        exit(1);
-    } else {
-        // Parent process
-        printf("[%d] %s\n", pid, cmd->args[0]);
+        setpgid(0, 0);
+        setup_child_signal_handlers();
+        // The subshell's children are its own; it has no job control
+        jobs_forget_all();
+        jobs_init();
+        shell_set_interactive(0);
+        list->background = 0;
+        exit(execute_and_or(list, arena));
+    }
+    setpgid(pid, pid);
+    add_background_job(pid, &pid, NULL, 1, text.data);
+    return 0;
+}
+
+/**
+ * execute_sequence - Execute a parsed command line.
+ * @seq: Tree returned by parse_line.
+ *
+ * Walks the and-or lists in order; lists ending in & are started in the
+ * background. No part of the line is parsed again.
+ * Returns: Exit status of the last list.
+ */
+int execute_sequence(sequence_t *seq) {
+    int status = 0;
+    if (!seq) {
         return 0;
     }
+
+    for (and_or_t *list = seq->lists; list; list = list->next) {
+        status = execute_and_or(list, seq->arena);
+    }
+    return status;
 }
 
 /**
- * find_command - Search for an executable in PATH or as a direct path.
- * @command: Command name or path.
+ * execute_and_or - Execute pipelines joined by && and ||.
+ * @list: And-or list.
+ * @arena: Arena for expansion results (the one the list was parsed into).
  *
- * Returns: Newly allocated string with full path, or NULL if not found.
+ * Operators are evaluated left to right: a pipeline after && runs only if
+ * the status so far is zero, one after || only if it is non-zero. Skipped
+ * pipelines leave the status unchanged. Iterative, so chain length does not
+ * grow the stack.
+ * Returns: Exit status of the last pipeline that ran.
+ */
+int execute_and_or(and_or_t *list, arena_t *arena) {
+    if (!list || !list->pipelines) {
+        return 0;
+    }
+
+    if (list->background) {
+        pipeline_t *only = list->pipelines;
+        if (only->next) {
+            return execute_and_or_background(list, arena);
+        }
+        if (only->commands->next_pipe) {
+            return execute_pipeline(only->commands, 1, arena);
+        }
+        if (expand_env_vars(arena, only->commands) != 0) {
+            return 1;
+        }
+        return execute_background(only->commands, arena);
+    }
+
+    pipeline_t *pipeline = list->pipelines;
+    int status = execute_pipeline(pipeline->commands, 0, arena);
+    for (; pipeline->next; pipeline = pipeline->next) {
+        if ((pipeline->next_op == LOGIC_AND && status == 0) ||
+            (pipeline->next_op == LOGIC_OR && status != 0)) {
+            status = execute_pipeline(pipeline->next->commands, 0, arena);
+        }
+    }
+    return status;
+}
+
+/**
+ * execute_pipeline - Run every stage of a pipeline concurrently.
+ * @cmd: First stage; later stages are linked through next_pipe.
+ * @background: Non-zero to return without waiting.
+ * @arena: Arena for expansion results.
  *
- * Optimization: Cache split $PATH result and only re-split if $PATH changes.
+ * A single-stage pipeline is handed to execute_single_command so builtins
+ * run in the shell. Otherwise stages are connected with close-on-exec pipes
+ * and placed in one process group, which gets the terminal while it runs in
+ * the foreground. The pipeline is entered in the job table, so it can be
+ * stopped and resumed; a background one is left running there. All stages
+ * of a foreground pipeline are waited for; their statuses are available
+ * through get_pipestatus.
+ * Returns: Status of the last stage, or with pipefail the rightmost non-zero
+ *          status.
  */
-char *find_command(const char *command) {
-    if (!command) return NULL;
+int execute_pipeline(command_t *cmd, int background, arena_t *arena) {
+    if (!cmd) {
+        return 0;
+    }
+    if (!cmd->next_pipe && !background) {
+        return execute_single_command(cmd, arena);
+    }
 
-    // If command contains '/', treat as absolute or relative path
-    if (strchr(command, '/')) {
-        if (is_executable(command)) {
-            return strdup_safe(command);
+    int count = 0;
+    for (command_t *stage = cmd; stage; stage = stage->next_pipe) {
+        count++;
+    }
+
+    pid_t *pids = malloc(count * sizeof(pid_t));
+    int *statuses = calloc(count, sizeof(int));
+    if (!pids || !statuses) {
+        print_error("pipeline: out of memory");
+        free(pids);
+        free(statuses);
+        return 1;
+    }
+
+    // With lastpipe a builtin last stage runs in the shell, so
+    // `... | read var` sets var here and the pipeline needs one fork less.
+    // Not under job control: a stopped writer would leave the shell
+    // blocked on the pipe.
+    int lastpipe = !background && shell_option(OPT_LASTPIPE) && !shell_is_interactive();
+    command_t *shell_stage = NULL;
+
+    // Expand every stage before starting any: a $(cmd) reaps children, and
+    // the statuses of stages not yet in the job table would be lost
+    int index = 0;
+    for (command_t *stage = cmd; stage; stage = stage->next_pipe, index++) {
+        if (expand_env_vars(arena, stage) != 0) {
+            statuses[index] = 1;
         }
-        return NULL;
     }
 
-    // --- Optimization: cache split $PATH ---
-    static char **cached_paths = NULL;
-    static char *cached_path_env = NULL;
-    static int cached_path_count = 0;
-    const char *path_env = getenv("PATH");
-    if (!path_env) {
-        return NULL;
+    pid_t pgid = 0;
+    int prev_read = -1;
+    index = 0;
+    for (command_t *stage = cmd; stage; stage = stage->next_pipe, index++) {
+        int fds[2] = { -1, -1 };
+        pids[index] = -1;
+
+        if (stage->next_pipe && pipe2(fds, O_CLOEXEC) == -1) {
+            print_system_error("pipe failed");
+            statuses[index] = 1;
+            for (int i = index + 1; i < count; i++) {
+                pids[i] = -1;
+                statuses[i] = 1;
+            }
+            break;
+        }
+
+        if (statuses[index] != 0) {
+            // Its expansion failed: not started; the next stage reads EOF
+        } else if (lastpipe && !stage->next_pipe && stage->argc > 0 && is_builtin(stage)) {
+            shell_stage = stage;
+            break;
+        } else {
+            pids[index] = launch_command(stage, prev_read, fds[1], fds[0],
+                                         pgid, &statuses[index]);
+            if (pids[index] > 0 && pgid == 0) {
+                pgid = pids[index];
+            }
+        }
+
+        if (prev_read >= 0) close(prev_read);
+        if (fds[1] >= 0) close(fds[1]);
+        prev_read = fds[0];
     }
-    if (!cached_path_env || strcmp(cached_path_env, path_env) != 0) {
-        // $PATH changed, re-split
-        if (cached_paths) {
-            free_string_array(cached_paths);
-            cached_paths = NULL;
+    const char *text = pipeline_text(arena, cmd);
+    if (shell_stage) {
+        // The other stages are running; the pipe's read end is the stage's
+        // stdin. They are entered in the job table first, so a builtin that
+        // reaps children (timeout, parallel, $(cmd)) records their statuses.
+        // Internal meanwhile: `wait` or `jobs` in the stage must not see it.
+        job_t *job = NULL;
+        if (pgid > 0) {
+            job = jobs_add(pgid, pids, statuses, count, text, JOB_INTERNAL);
+            if (!job) {
+                print_error("jobs: out of memory");
+            }
         }
-        if (cached_path_env) {
-            free(cached_path_env);
-            cached_path_env = NULL;
+        int stage_status = run_last_stage(shell_stage, prev_read);
+        prev_read = -1;
+        if (job) {
+            job->flags &= ~JOB_INTERNAL;
+            wait_job_in_foreground(job, statuses);
         }
-        cached_path_env = strdup_safe(path_env);
-        cached_paths = split_string(path_env, ":", &cached_path_count);
+        statuses[count - 1] = stage_status;
+        pgid = 0;  // Already waited for
     }
-    if (!cached_paths) {
-        return NULL;
+    if (prev_read >= 0) {
+        close(prev_read);
     }
-    // --- End optimization ---
 
-    char *found_path = NULL;
-    for (int i = 0; i < cached_path_count; i++) {
-        char *full_path = malloc(strlen(cached_paths[i]) + strlen(command) + 2);
-        if (!full_path) continue;
-        sprintf(full_path, "%s/%s", cached_paths[i], command);
-        if (is_executable(full_path)) {
-            found_path = full_path;
-            break;
+    if (background) {
+        if (pgid > 0) {
+            add_background_job(pgid, pids, statuses, count, text);
         }
-        free(full_path);
+        free(pids);
+        free(statuses);
+        return 0;
+    }
+
+    if (pgid > 0) {
+        wait_foreground_job(pgid, pids, statuses, count, text);
     }
-    return found_path;
+
+    record_statuses(statuses, count);
+    int status = last_status;
+    if (shell_option(OPT_PIPEFAIL)) {
+        for (int i = count - 1; i >= 0; i--) {
+            if (statuses[i] != 0) {
+                status = statuses[i];
+                break;
+            }
+        }
+        last_status = status;
+    }
+
+    free(pids);
+    free(statuses);
+    return status;
 }
 
 /**
- * is_executable - Check if a file is executable.
- * @path: Path to check.
+ * get_last_status - Get the exit status of the last foreground command ($?).
  *
- * Returns: 1 if executable, 0 otherwise.
+ * Returns: Exit status code.
  */
-int is_executable(const char *path) {
-    if (!path) return 0;
-    
-    struct stat st;
-    if (stat(path, &st) != 0) {
-        return 0;
-    }
-    
-    return S_ISREG(st.st_mode) && (st.st_mode & S_IXUSR);
+int get_last_status(void) {
+    return last_status;
 }
 
 /**
- * execute_external - Execute an external (non-builtin) command.
+ * get_pipestatus - Get per-stage statuses of the last foreground command.
+ * @count: Output pointer for number of stages.
+ *
+ * Returns: Array of exit statuses, valid until the next command runs.
+ */
+const int *get_pipestatus(int *count) {
+    *count = pipestatus_count;
+    return pipestatus;
+}
+
+/**
+ * execute_single_command - Execute a single command (builtin or external).
  * @cmd: Command to execute.
+ * @arena: Arena for expansion results.
  *
- * Forks and execs the command, waits for completion.
+ * Handles redirection and the builtin/external distinction.
  * Returns: Exit status code.
  */
-int execute_external(command_t *cmd) {
-    char *command_path = find_command(cmd->args[0]);
-    if (!command_path) {
-        print_error("command not found: %s", cmd->args[0]);
-        return 127;  // Command not found
-    }
-    
-    pid_t pid = fork();
-    
-    if (pid == -1) {
-        print_system_error("fork failed");
-        free(command_path);
+int execute_single_command(command_t *cmd, arena_t *arena) {
+    if (!cmd) {
         return 1;
     }
-    
-    if (pid == 0) {
-        // Child process
-        execv(command_path, cmd->args);
-        print_system_error("exec failed");
-        free(command_path);
-        exit(1);
+
+    // Expand environment variables in command arguments
+    int subst_status;
+    cmdsubst_take_status(&subst_status);
+
+    int status;
+    if (expand_env_vars(arena, cmd) != 0) {
+        // An arithmetic error: the command does not run
+        status = 1;
+    } else if (cmd->argc == 0 || is_builtin(cmd)) {
+        // Builtins and bare assignments run in the shell, so
+        // `cd dir > /dev/null` keeps its effect and `echo x >> log` costs
+        // no fork
+        status = run_in_shell(cmd);
+        // x=$(cmd) takes the status of its last command substitution
+        if (cmd->argc == 0 && status == 0 && cmdsubst_take_status(&subst_status)) {
+            status = subst_status;
+        }
     } else {
-        // Parent process
-        int status;
-        waitpid(pid, &status, 0);
-        free(command_path);
-        return WEXITSTATUS(status);
+        status = execute_external(cmd);
     }
+
+    record_statuses(&status, 1);
+    return status;
 }
 
 /**
- * execute_command_chain - Execute a chain of commands sequentially.
- * @commands: Array of command pointers.
- * @count: Number of commands.
+ * execute_with_redirection - Execute a command with I/O redirection.
+ * @cmd: Command to execute.
  *
- * Returns: Exit status of the last command.
+ * External commands are launched with the redirections expressed as spawn
+ * file actions. A builtin given here runs in a forked child (a plain
+ * builtin command is run in the shell by execute_single_command instead).
+ * With job control the child gets its own process group and the terminal.
+ * Returns: Exit status code.
  */
-int execute_command_chain(command_t **commands, int count) {
-    if (!commands || count <= 0) {
-        return 0;
-    }
-    
-    int last_status = 0;
-    for (int i = 0; i < count; i++) {
-        if (commands[i]) {
-            last_status = execute_command(commands[i]);
+int execute_with_redirection(command_t *cmd) {
+    int status = 0;
+    pid_t pgid = shell_is_interactive() ? 0 : -1;
+
+    pid_t pid = launch_command(cmd, -1, -1, -1, pgid, &status);
+    if (pid != -1) {
+        char text[256];
+        size_t used = 0;
+        text[0] = '\0';
+        for (int i = 0; i < cmd->argc && used < sizeof(text); i++) {
+            used += snprintf(text + used, sizeof(text) - used, "%s%s",
+                             i > 0 ? " " : "", cmd->args[i]);
         }
+        status = wait_foreground_job(pgid == 0 ? pid : -1, &pid, &status, 1, text);
     }
-    
-    return last_status;
+    return status;
 }
 
 /**
- * wait_for_background_processes - Reap all finished background processes.
+ * execute_background - Execute a command in the background (asynchronously).
+ * @cmd: Command to execute (already expanded).
+ * @arena: Arena for the job's command text.
+ *
+ * Launches the command in a new process group, enters it in the job table
+ * and does not wait for completion.
+ * Returns: 0 on success, 1 on error.
  */
-void wait_for_background_processes(void) {
-    int status;
-    while (waitpid(-1, &status, WNOHANG) > 0) {
-        // Background process finished
+int execute_background(command_t *cmd, arena_t *arena) {
+    int status = 0;
+    pid_t pid = launch_command(cmd, -1, -1, -1, 0, &status);
+    if (pid == -1) {
+        return status;
     }
+
+    add_background_job(pid, &pid, NULL, 1, pipeline_text(arena, cmd));
+    return 0;
 }
 
 /**
- * setup_child_signal_handlers - Reset signal handlers in child process to default.
+ * execute_async - Start a command without waiting for it.
+ * @cmd: Command to execute (already expanded).
+ * @out_fd: Descriptor to bind to the command's stdout, or -1 to inherit.
+ * @pgid: -1 to stay in the shell's process group, 0 for a group of its own.
+ * @status: Set to the failure status when nothing could be started.
+ *
+ * The command is launched like a pipeline stage and entered in the job
+ * table as an internal job: it is never listed or reported, and the
+ * caller collects it with jobs_wait.
+ * Returns: Job, or NULL after printing an error.
  */
-void setup_child_signal_handlers(void) {
-    // Reset signal handlers for child processes
-    signal(SIGINT, SIG_DFL);
-    signal(SIGQUIT, SIG_DFL);
-    signal(SIGTSTP, SIG_DFL);
-    signal(SIGTTIN, SIG_DFL);
-    signal(SIGTTOU, SIG_DFL);
+job_t *execute_async(command_t *cmd, int out_fd, pid_t pgid, int *status) {
+    pid_t pid = launch_command(cmd, -1, out_fd, -1, pgid, status);
+    if (pid == -1) {
+        return NULL;
+    }
+    job_t *job = jobs_add(pgid == 0 ? pid : 0, &pid, NULL, 1, cmd->args[0], JOB_INTERNAL);
+    if (!job) {
+        print_error("jobs: out of memory");
+        *status = 1;
+    }
+    return job;
 }
 
 /**
- * execute_with_logical - Execute a command with logical operators (&&, ||).
- * @cmd: Command to execute.
+ * sync_path_cache - Bring the PATH cache and directory index up to date.
  *
- * Returns: Exit status code.
+ * Re-splits $PATH and rebuilds the directory index only when $PATH changed
+ * (the index itself is kept current by inotify).
+ * Returns: 1 if PATH is set, 0 otherwise.
  */
-int execute_with_logical(command_t *cmd) {
-    if (!cmd) return 1;
-    
-    // Execute the current command (without logical operators to avoid recursion)
-    int status = execute_single_command(cmd);
-    
-
-    
-    // If there's a logical operator, handle it
-    if (cmd->logic_op != LOGIC_NONE && cmd->next_logic_command) {
-        command_t *next_cmd = parse_command(cmd->next_logic_command);
-        if (next_cmd) {
-            if (cmd->logic_op == LOGIC_AND) {
-                // && : execute next command only if current command succeeded
-                if (status == 0) {
-                    status = execute_command(next_cmd);
-                }
-            } else if (cmd->logic_op == LOGIC_OR) {
-                // || : execute next command only if current command failed
-                if (status != 0) {
-                    status = execute_command(next_cmd);
-                }
-            }
-            free_command(next_cmd);
-        }
+int sync_path_cache(void) {
+    // --- Optimization: cache split $PATH ---
+    const char *path_env = vars_get("PATH");
+    if (!path_env) {
+        return 0;
     }
-    
-    // Handle command chaining after logical operators
-    if (cmd->next_command) {
-        command_t *chain_cmd = parse_command(cmd->next_command);
-        if (chain_cmd) {
-            int chain_status = execute_command(chain_cmd);
-            free_command(chain_cmd);
-            return chain_status;
+    if (!cached_path_env || strcmp(cached_path_env, path_env) != 0) {
+        // $PATH changed, re-split and forget remembered locations
+        if (cached_paths) {
+            free(cached_paths);
+            cached_paths = NULL;
         }
+        if (cached_path_env) {
+            free(cached_path_env);
+            cached_path_env = NULL;
+        }
+        cached_path_env = strdup_safe(path_env);
+        cached_paths = split_string(path_env, ":", &cached_path_count);
+        if (!cached_paths) {
+            cached_path_count = 0;
+        }
+        cmdhash_clear();
+        pathindex_build(cached_paths, cached_path_count);
     }
-    
-    return status;
+    // --- End optimization ---
+    return cached_paths != NULL;
 }
 
 /**
- * execute_logical_chain - Execute a chain of commands with logical operators.
- * @commands: Array of command pointers.
- * @count: Number of commands.
+ * find_command - Search for an executable in PATH or as a direct path.
+ * @command: Command name or path.
+ *
+ * Returns: Path owned by the command hash table (or @command itself when it
+ *          contains a '/'), valid until the table changes; NULL if not found.
  *
- * Returns: Exit status of the last command.
+ * Optimization: Cache split $PATH result and only re-split if $PATH changes.
+ * Resolved names are remembered in the command hash table, so repeated
+ * lookups cost no allocation and no stat calls. Names not yet hashed are
+ * resolved through the PATH directory index instead of probing every
+ * directory.
  */
-int execute_logical_chain(command_t **commands, int count) {
-    if (!commands || count <= 0) {
-        return 0;
+const char *find_command(const char *command) {
+    if (!command) return NULL;
+
+    // If command contains '/', treat as absolute or relative path
+    if (strchr(command, '/')) {
+        return is_executable(command) ? command : NULL;
     }
-    
-    int last_status = 0;
-    for (int i = 0; i < count; i++) {
-        if (commands[i]) {
-            last_status = execute_with_logical(commands[i]);
+
+    if (!sync_path_cache()) {
+        return NULL;
+    }
+    // Apply directory changes first so hashed entries for them are dropped
+    pathindex_sync();
+
+    const char *hashed = cmdhash_lookup(command);
+    if (hashed) {
+        return hashed;
+    }
+    cmdhash_count_miss();
+
+    char full_path[PATH_MAX];
+    int indexed = pathindex_lookup(command, full_path, sizeof(full_path));
+    if (indexed > 0) {
+        return cmdhash_insert(command, full_path);
+    }
+    if (indexed == 0) {
+        return NULL;
+    }
+
+    // No index available: probe each directory
+    for (int i = 0; i < cached_path_count; i++) {
+        int len = snprintf(full_path, sizeof(full_path), "%s/%s", cached_paths[i], command);
+        if (len < 0 || (size_t)len >= sizeof(full_path)) continue;
+        if (is_executable(full_path)) {
+            return cmdhash_insert(command, full_path);
         }
     }
+    return NULL;
+}
+
+/**
+ * is_executable - Check if a file is executable.
+ * @path: Path to check.
+ *
+ * Returns: 1 if executable, 0 otherwise.
+ */
+int is_executable(const char *path) {
+    if (!path) return 0;
+    
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return 0;
+    }
     
-    return last_status;
+    return S_ISREG(st.st_mode) && (st.st_mode & S_IXUSR);
+}
+
+/**
+ * execute_external - Execute an external (non-builtin) command.
+ * @cmd: Command to execute.
+ *
+ * Launches the command with the active backend and waits for completion.
+ * Returns: Exit status code.
+ */
+int execute_external(command_t *cmd) {
+    return execute_with_redirection(cmd);
 }
 
 /**
- * cleanup_find_command_cache - Free static PATH cache used by find_command.
+ * cleanup_find_command_cache - Free the PATH cache and command hash table.
  */
 void cleanup_find_command_cache(void) {
     if (cached_paths) {
-        free_string_array(cached_paths);
+        free(cached_paths);
         cached_paths = NULL;
     }
     if (cached_path_env) {
@@ -425,4 +1013,6 @@ void cleanup_find_command_cache(void) {
         cached_path_env = NULL;
     }
     cached_path_count = 0;
+    cmdhash_destroy();
+    pathindex_destroy();
 }
@@ -0,0 +1,346 @@
+#include "histindex.h"
+#include "histstore.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HI_INITIAL_BUCKETS 1024
+#define HI_INITIAL_GRAM_SLOTS 4096
+#define HI_INITIAL_LIST 4
+#define HI_MAX_LISTS 8              // Rarest trigrams of a pattern intersected
+#define HI_RECENCY_SCALE 256.0      // A line's weight halves after this many entries
+
+// One distinct line
+typedef struct {
+    uint32_t entry;         // Store index of its latest use
+    uint32_t uses;
+    uint32_t hash;
+    uint32_t next;          // Next line in the same bucket (index + 1), 0 at the end
+} hist_line_t;
+
+// Posting list of one trigram
+typedef struct {
+    uint32_t gram;          // Three bytes of text; 0 marks a free slot
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *lines;        // Distinct lines containing it, ascending
+} gram_list_t;
+
+// A match being ranked
+typedef struct {
+    double score;
+    uint32_t line;
+} hist_match_t;
+
+static hist_line_t *lines = NULL;
+static uint32_t line_count = 0;
+static uint32_t line_capacity = 0;
+static uint32_t *buckets = NULL;
+static uint32_t bucket_count = 0;
+
+static gram_list_t *grams = NULL;
+static uint32_t gram_slots = 0;
+static uint32_t gram_count = 0;
+
+static size_t indexed = 0;                  // Store entries already indexed
+static unsigned long indexed_generation = 0;
+
+// Helper: FNV-1a string hash
+static uint32_t hash_line(const char *line) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)line; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Helper: the three bytes at @p as one key (never 0 inside a string)
+static uint32_t gram_at(const char *p) {
+    return (uint32_t)(unsigned char)p[0] << 16 | (uint32_t)(unsigned char)p[1] << 8 |
+           (unsigned char)p[2];
+}
+
+// Helper: text of a distinct line (points into the store's mapping)
+static const char *line_text(const hist_line_t *line) {
+    hist_entry_t entry;
+    return histstore_get(line->entry, &entry) == 0 ? entry.line : "";
+}
+
+// Helper: find the slot of @gram (free if absent)
+static gram_list_t *gram_slot(uint32_t gram) {
+    uint32_t slot = (gram * 2654435761u) & (gram_slots - 1);
+    while (grams[slot].gram != 0 && grams[slot].gram != gram) {
+        slot = (slot + 1) & (gram_slots - 1);
+    }
+    return &grams[slot];
+}
+
+// Helper: posting list of @gram, or NULL
+static const gram_list_t *find_gram(uint32_t gram) {
+    if (!grams) return NULL;
+    const gram_list_t *list = gram_slot(gram);
+    return list->gram ? list : NULL;
+}
+
+// Helper: double the trigram table once it is half full
+static int grow_grams(void) {
+    uint32_t old_slots = gram_slots;
+    gram_list_t *old = grams;
+    uint32_t new_slots = old_slots ? old_slots * 2 : HI_INITIAL_GRAM_SLOTS;
+    gram_list_t *table = calloc(new_slots, sizeof(gram_list_t));
+    if (!table) return -1;
+
+    grams = table;
+    gram_slots = new_slots;
+    for (uint32_t i = 0; i < old_slots; i++) {
+        if (old[i].gram) *gram_slot(old[i].gram) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+// Helper: record that line @id contains @gram
+static void add_gram(uint32_t gram, uint32_t id) {
+    if ((gram_count + 1) * 2 > gram_slots && grow_grams() != 0) return;
+
+    gram_list_t *list = gram_slot(gram);
+    if (!list->gram) {
+        list->gram = gram;
+        gram_count++;
+    }
+    if (list->count > 0 && list->lines[list->count - 1] == id) {
+        return;  // Repeated within the same line
+    }
+    if (list->count == list->capacity) {
+        uint32_t new_capacity = list->capacity ? list->capacity * 2 : HI_INITIAL_LIST;
+        uint32_t *grown = realloc(list->lines, new_capacity * sizeof(uint32_t));
+        if (!grown) return;
+        list->lines = grown;
+        list->capacity = new_capacity;
+    }
+    list->lines[list->count++] = id;
+}
+
+// Helper: double the line bucket array once it is 3/4 full
+static int grow_buckets(void) {
+    uint32_t new_count = bucket_count ? bucket_count * 2 : HI_INITIAL_BUCKETS;
+    uint32_t *table = calloc(new_count, sizeof(uint32_t));
+    if (!table) return -1;
+
+    for (uint32_t id = 0; id < line_count; id++) {
+        uint32_t slot = lines[id].hash & (new_count - 1);
+        lines[id].next = table[slot];
+        table[slot] = id + 1;
+    }
+    free(buckets);
+    buckets = table;
+    bucket_count = new_count;
+    return 0;
+}
+
+// Helper: count one use of @text (store entry @entry); a line seen for the
+// first time gets a new id and its trigrams are indexed
+static void add_line(const char *text, uint32_t entry) {
+    uint32_t hash = hash_line(text);
+    if (bucket_count) {
+        for (uint32_t i = buckets[hash & (bucket_count - 1)]; i != 0; i = lines[i - 1].next) {
+            hist_line_t *line = &lines[i - 1];
+            if (line->hash == hash && strcmp(line_text(line), text) == 0) {
+                line->entry = entry;
+                line->uses++;
+                return;
+            }
+        }
+    }
+
+    if ((line_count + 1) * 4 > bucket_count * 3 && grow_buckets() != 0) return;
+    if (line_count == line_capacity) {
+        uint32_t new_capacity = line_capacity ? line_capacity * 2 : HI_INITIAL_BUCKETS;
+        hist_line_t *grown = realloc(lines, new_capacity * sizeof(hist_line_t));
+        if (!grown) return;
+        lines = grown;
+        line_capacity = new_capacity;
+    }
+
+    uint32_t id = line_count++;
+    uint32_t slot = hash & (bucket_count - 1);
+    lines[id].entry = entry;
+    lines[id].uses = 1;
+    lines[id].hash = hash;
+    lines[id].next = buckets[slot];
+    buckets[slot] = id + 1;
+
+    size_t len = strlen(text);
+    for (size_t i = 0; i + 3 <= len; i++) {
+        add_gram(gram_at(text + i), id);
+    }
+}
+
+// Helper: drop everything indexed so far
+static void reset(void) {
+    for (uint32_t i = 0; i < gram_slots; i++) {
+        free(grams[i].lines);
+    }
+    free(grams);
+    free(buckets);
+    free(lines);
+    grams = NULL;
+    buckets = NULL;
+    lines = NULL;
+    gram_slots = gram_count = 0;
+    bucket_count = 0;
+    line_count = line_capacity = 0;
+    indexed = 0;
+}
+
+/**
+ * histindex_update - Bring the index up to date with the history store.
+ * @max: Most entries to read in this call.
+ *
+ * Only entries added since the last call are read, so keeping the index
+ * current costs one hash lookup per new command (plus its trigrams when
+ * the line is new), and a large file can be indexed in slices while the
+ * shell is idle. A store whose entries were renumbered by compaction or
+ * clearing is indexed again from the start.
+ * Returns: 1 if entries are left to index, else 0.
+ */
+int histindex_update(size_t max) {
+    if (indexed_generation != histstore_generation()) {
+        reset();
+        indexed_generation = histstore_generation();
+    }
+    size_t total = histstore_count();
+    if (total > UINT32_MAX) total = UINT32_MAX;
+    size_t end = total - indexed > max ? indexed + max : total;
+    hist_entry_t entry;
+    for (; indexed < end; indexed++) {
+        if (histstore_get(indexed, &entry) == 0) {
+            add_line(entry.line, (uint32_t)indexed);
+        }
+    }
+    return indexed < total;
+}
+
+// Helper: binary search for @id in a posting list
+static int list_contains(const gram_list_t *list, uint32_t id) {
+    uint32_t low = 0, high = list->count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (list->lines[mid] < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < list->count && list->lines[low] == id;
+}
+
+// Helper: rank of a line: recent use counts most, repeated use adds
+// about one point per doubling
+static double score_line(const hist_line_t *line, size_t total) {
+    double weight = 1.0;
+    for (uint32_t uses = line->uses; uses > 1; uses >>= 1) {
+        weight += 1.0;
+    }
+    double age = (double)(total - 1 - line->entry);
+    return weight * HI_RECENCY_SCALE / (HI_RECENCY_SCALE + age);
+}
+
+// Helper: check whether a scored match ranks above another
+static int ranks_above(const hist_match_t *a, const hist_match_t *b) {
+    if (a->score != b->score) return a->score > b->score;
+    return lines[a->line].entry > lines[b->line].entry;
+}
+
+/**
+ * histindex_search - Rank history lines containing a pattern.
+ * @pattern: Substring to look for (case-sensitive).
+ * @entries: Receives store indices, best match first.
+ * @max: Capacity of @entries.
+ *
+ * Candidates come from the shortest posting lists of the pattern's
+ * trigrams, walked newest line first and checked against the others by
+ * binary search. A candidate's score depends only on its use count and
+ * latest use, so the text is compared only for lines that would enter
+ * the current top @max; patterns under three bytes scan every distinct
+ * line the same way.
+ * Returns: Number of entries stored.
+ */
+int histindex_search(const char *pattern, size_t *entries, int max) {
+    histindex_update(SIZE_MAX);
+    if (max <= 0 || line_count == 0) {
+        return 0;
+    }
+
+    // Up to HI_MAX_LISTS shortest posting lists, shortest first
+    const gram_list_t *lists[HI_MAX_LISTS];
+    int list_count = 0;
+    size_t len = strlen(pattern);
+    for (size_t i = 0; i + 3 <= len; i++) {
+        const gram_list_t *list = find_gram(gram_at(pattern + i));
+        if (!list) {
+            return 0;  // Some trigram occurs nowhere
+        }
+        int pos = list_count;
+        for (int j = 0; j < list_count; j++) {
+            if (lists[j] == list) pos = -1;  // Trigram repeated in the pattern
+        }
+        while (pos > 0 && lists[pos - 1]->count > list->count) {
+            pos--;
+        }
+        if (pos < 0 || pos == HI_MAX_LISTS) {
+            continue;
+        }
+        if (list_count < HI_MAX_LISTS) list_count++;
+        memmove(&lists[pos + 1], &lists[pos], (list_count - 1 - pos) * sizeof(lists[0]));
+        lists[pos] = list;
+    }
+
+    hist_match_t *top = malloc((size_t)max * sizeof(hist_match_t));
+    if (!top) {
+        return 0;
+    }
+    int found = 0;
+    size_t total = histstore_count();
+    uint32_t candidates = list_count ? lists[0]->count : line_count;
+    int exact = len == 3;  // One trigram: the posting list is the answer
+
+    for (uint32_t n = candidates; n-- > 0; ) {
+        hist_match_t match;
+        match.line = list_count ? lists[0]->lines[n] : n;
+        match.score = score_line(&lines[match.line], total);
+        if (found == max && !ranks_above(&match, &top[found - 1])) {
+            continue;
+        }
+
+        int other = 1;
+        while (other < list_count && list_contains(lists[other], match.line)) {
+            other++;
+        }
+        if (other < list_count) continue;
+        if (!exact && !strstr(line_text(&lines[match.line]), pattern)) continue;
+
+        // Insert in rank order, dropping the last when full
+        int pos = found < max ? found++ : max - 1;
+        while (pos > 0 && ranks_above(&match, &top[pos - 1])) {
+            top[pos] = top[pos - 1];
+            pos--;
+        }
+        top[pos] = match;
+    }
+
+    for (int i = 0; i < found; i++) {
+        entries[i] = lines[top[i].line].entry;
+    }
+    free(top);
+    return found;
+}
+
+/**
+ * histindex_destroy - Free the index.
+ */
+void histindex_destroy(void) {
+    reset();
+    indexed_generation = 0;
+}
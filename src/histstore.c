@@ -0,0 +1,416 @@
+#define _GNU_SOURCE
+#include "histstore.h"
+#include "utils.h"
+#include "vars.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HIST_MAGIC 0x5349484cu              // "LHIS" in file byte order
+#define HIST_ALIGN 8
+#define HIST_MAX_LINE 65536                 // Longer lines are not saved
+#define HIST_MAX_BYTES (256u << 20)         // Compact once the file passes this
+#define HIST_INITIAL_CAPACITY 1024
+#define HIST_APPEND_RETRIES 16              // Compactions by others to ride out per append
+#define HIST_MAP_CHUNK (4u << 20)           // Mapping headroom, so appends rarely remap
+
+// On-disk record: header, cwd, NUL, line, NUL, padding to HIST_ALIGN.
+// Records are written whole with one O_APPEND write, so concurrent shells
+// never interleave inside one.
+typedef struct {
+    uint32_t magic;
+    uint32_t size;          // Whole record, header included
+    int64_t time;
+    int32_t status;
+    uint32_t cwd_len;
+    uint32_t line_len;
+    uint32_t reserved;
+} hist_record_t;
+
+static char *store_path = NULL;
+static int store_fd = -1;
+static dev_t store_dev;
+static ino_t store_ino;
+
+static const char *map = NULL;
+static size_t map_size = 0;
+static size_t indexed_end = 0;              // Bytes of the file already indexed
+
+static size_t *offsets = NULL;              // Record offsets, oldest first
+static size_t count = 0;
+static size_t capacity = 0;
+static unsigned long generation = 0;        // Bumped when the index is dropped
+
+// Helper: round up to the record alignment
+static size_t align_up(size_t n) {
+    return (n + HIST_ALIGN - 1) & ~(size_t)(HIST_ALIGN - 1);
+}
+
+// Helper: drop the mapping and the index
+static void reset_index(void) {
+    if (map) {
+        munmap((void *)map, map_size);
+    }
+    map = NULL;
+    map_size = 0;
+    indexed_end = 0;
+    count = 0;
+    generation++;
+}
+
+// Helper: open the file at store_path and remember its identity
+static int open_file(void) {
+    struct stat st;
+    int fd = open(store_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    store_fd = fd;
+    store_dev = st.st_dev;
+    store_ino = st.st_ino;
+    return 0;
+}
+
+// Helper: check whether the path still names the file we have open
+// (another shell may have compacted it into a new file)
+static int file_replaced(void) {
+    struct stat st;
+    if (stat(store_path, &st) == -1) {
+        return 1;
+    }
+    return st.st_dev != store_dev || st.st_ino != store_ino;
+}
+
+// Helper: switch to the file now at store_path and index it from scratch
+static int reopen_file(void) {
+    if (store_fd >= 0) {
+        close(store_fd);
+        store_fd = -1;
+    }
+    reset_index();
+    return open_file();
+}
+
+// Helper: check a record header at @offset of the mapping
+static int valid_record(size_t offset, size_t end) {
+    const hist_record_t *rec = (const hist_record_t *)(map + offset);
+    if (rec->magic != HIST_MAGIC || rec->size < sizeof(hist_record_t) ||
+        rec->size % HIST_ALIGN != 0) {
+        return 0;
+    }
+    size_t needed = sizeof(hist_record_t) + rec->cwd_len + 1 + rec->line_len + 1;
+    return needed <= rec->size && rec->size <= end - offset;
+}
+
+// Helper: map the file up to its current size and index new records
+static void map_and_index(void) {
+    struct stat st;
+    if (store_fd < 0 || fstat(store_fd, &st) == -1) {
+        return;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size <= indexed_end) {
+        return;
+    }
+
+    if (size > map_size) {
+        // Pages past the end of the file are never touched: only indexed
+        // records are read
+        size_t new_size = (size + HIST_MAP_CHUNK - 1) & ~(size_t)(HIST_MAP_CHUNK - 1);
+        void *mapped = mmap(NULL, new_size, PROT_READ, MAP_SHARED, store_fd, 0);
+        if (mapped == MAP_FAILED) {
+            return;
+        }
+        if (map) {
+            munmap((void *)map, map_size);
+        }
+        map = mapped;
+        map_size = new_size;
+    }
+
+    size_t offset = indexed_end;
+    while (offset + sizeof(hist_record_t) <= size) {
+        const hist_record_t *rec = (const hist_record_t *)(map + offset);
+        if (rec->magic == HIST_MAGIC && rec->size > size - offset) {
+            break;  // Still being written; pick it up next time
+        }
+        if (!valid_record(offset, size)) {
+            offset += HIST_ALIGN;  // Damaged bytes: resynchronise
+            continue;
+        }
+        if (count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : HIST_INITIAL_CAPACITY;
+            size_t *grown = realloc(offsets, new_capacity * sizeof(size_t));
+            if (!grown) {
+                break;
+            }
+            offsets = grown;
+            capacity = new_capacity;
+        }
+        offsets[count++] = offset;
+        offset += rec->size;
+    }
+    indexed_end = offset;
+}
+
+/**
+ * histstore_default_path - Get the default history file path.
+ *
+ * Returns: $HISTFILE if set, else ~/.lemuen_history; NULL without a home.
+ */
+const char *histstore_default_path(void) {
+    static char path[PATH_MAX];
+    const char *histfile = vars_get("HISTFILE");
+    if (histfile && *histfile) {
+        return histfile;
+    }
+    const char *home = vars_get("HOME");
+    if (!home || !*home) {
+        return NULL;
+    }
+    int len = snprintf(path, sizeof(path), "%s/.lemuen_history", home);
+    return (len > 0 && (size_t)len < sizeof(path)) ? path : NULL;
+}
+
+/**
+ * histstore_open - Open the persistent history file.
+ * @path: File to use; created with mode 0600 if missing.
+ *
+ * The file is mapped read-only and only record headers are walked to
+ * build an offset index, so even a large history loads without parsing
+ * or copying any line.
+ * Returns: 0 on success, -1 on error.
+ */
+int histstore_open(const char *path) {
+    histstore_close();
+    if (!path) {
+        return -1;
+    }
+    store_path = strdup_safe(path);
+    if (open_file() != 0) {
+        free(store_path);
+        store_path = NULL;
+        return -1;
+    }
+    map_and_index();
+    return 0;
+}
+
+/**
+ * histstore_count - Get the number of entries.
+ *
+ * Returns: Number of indexed entries.
+ */
+size_t histstore_count(void) {
+    return count;
+}
+
+/**
+ * histstore_get - Fetch one entry.
+ * @index: 0 for the oldest entry.
+ * @entry: Receives the entry; its strings point into the mapping.
+ *
+ * Returns: 0 on success, -1 if @index is out of range.
+ */
+int histstore_get(size_t index, hist_entry_t *entry) {
+    if (index >= count) {
+        return -1;
+    }
+    const hist_record_t *rec = (const hist_record_t *)(map + offsets[index]);
+    const char *data = (const char *)(rec + 1);
+    entry->time = (time_t)rec->time;
+    entry->status = rec->status;
+    entry->cwd = data;
+    entry->line = data + rec->cwd_len + 1;
+    return 0;
+}
+
+/**
+ * histstore_refresh - Pick up records appended by other shells.
+ *
+ * Follows the file to its new inode when another shell compacted it.
+ */
+void histstore_refresh(void) {
+    if (store_fd < 0) {
+        return;
+    }
+    if (file_replaced() && reopen_file() != 0) {
+        return;
+    }
+    map_and_index();
+}
+
+/**
+ * histstore_generation - Get the entry numbering generation.
+ *
+ * Returns: A value that changes whenever existing entries are renumbered.
+ */
+unsigned long histstore_generation(void) {
+    return generation;
+}
+
+// Helper: replace the file with its newest @keep bytes of whole records.
+// Runs under an exclusive lock, so no shell is appending to the old file
+// while it is copied; they notice the new inode before their next write.
+static int compact(size_t keep) {
+    if (flock(store_fd, LOCK_EX) == -1) {
+        return -1;
+    }
+    if (file_replaced()) {
+        // Someone else compacted first
+        flock(store_fd, LOCK_UN);
+        if (reopen_file() != 0) {
+            return -1;
+        }
+        map_and_index();
+        return 0;
+    }
+    map_and_index();
+
+    size_t first = count;
+    while (first > 0 && indexed_end - offsets[first - 1] <= keep) {
+        first--;
+    }
+    size_t start = first < count ? offsets[first] : indexed_end;
+
+    size_t tmp_len = strlen(store_path) + 8;
+    char *tmp = malloc(tmp_len);
+    int result = -1;
+    if (tmp) {
+        snprintf(tmp, tmp_len, "%s.XXXXXX", store_path);
+        int fd = mkstemp(tmp);
+        if (fd != -1) {
+            const char *data = map ? map + start : NULL;
+            size_t left = indexed_end - start;
+            while (left > 0) {
+                ssize_t n = write(fd, data, left);
+                if (n <= 0) {
+                    if (n < 0 && errno == EINTR) continue;
+                    break;
+                }
+                data += n;
+                left -= n;
+            }
+            fchmod(fd, 0600);
+            if (left == 0 && fsync(fd) == 0 && rename(tmp, store_path) == 0) {
+                result = 0;
+            } else {
+                unlink(tmp);
+            }
+            close(fd);
+        }
+        free(tmp);
+    }
+
+    flock(store_fd, LOCK_UN);
+    if (result == 0 && reopen_file() == 0) {
+        map_and_index();
+    }
+    return result;
+}
+
+/**
+ * histstore_append - Add an entry to the history file.
+ * @line: Command line.
+ * @when: Time it was entered.
+ * @status: Its exit status.
+ * @cwd: Directory it ran in (may be NULL).
+ *
+ * The record is built in memory and written with one write() on an
+ * O_APPEND descriptor, which the kernel keeps whole even with many shells
+ * appending at once. A shared lock is held only to keep a concurrent
+ * compaction from dropping the record.
+ * Returns: 0 on success, -1 on error.
+ */
+int histstore_append(const char *line, time_t when, int status, const char *cwd) {
+    if (store_fd < 0 || !line) {
+        return -1;
+    }
+    if (!cwd) cwd = "";
+    size_t line_len = strlen(line);
+    size_t cwd_len = strlen(cwd);
+    if (line_len > HIST_MAX_LINE || cwd_len > PATH_MAX) {
+        return -1;
+    }
+
+    size_t size = align_up(sizeof(hist_record_t) + cwd_len + 1 + line_len + 1);
+    char *buf = calloc(1, size);
+    if (!buf) {
+        return -1;
+    }
+    hist_record_t *rec = (hist_record_t *)buf;
+    rec->magic = HIST_MAGIC;
+    rec->size = (uint32_t)size;
+    rec->time = (int64_t)when;
+    rec->status = status;
+    rec->cwd_len = (uint32_t)cwd_len;
+    rec->line_len = (uint32_t)line_len;
+    memcpy(buf + sizeof(hist_record_t), cwd, cwd_len);
+    memcpy(buf + sizeof(hist_record_t) + cwd_len + 1, line, line_len);
+
+    int result = -1;
+    for (int attempt = 0; attempt < HIST_APPEND_RETRIES && result != 0; attempt++) {
+        if (flock(store_fd, LOCK_SH) == -1) {
+            break;
+        }
+        if (file_replaced()) {
+            flock(store_fd, LOCK_UN);
+            if (reopen_file() != 0) break;
+            continue;
+        }
+        ssize_t n;
+        while ((n = write(store_fd, buf, size)) == -1 && errno == EINTR) {}
+        flock(store_fd, LOCK_UN);
+        result = (n == (ssize_t)size) ? 0 : -1;
+        break;
+    }
+    free(buf);
+
+    map_and_index();
+    if (result == 0 && indexed_end > HIST_MAX_BYTES) {
+        compact(HIST_MAX_BYTES / 2);
+    }
+    return result;
+}
+
+/**
+ * histstore_clear - Remove every entry from the history file.
+ *
+ * The file is replaced rather than truncated, so shells that still have
+ * the old one mapped never read past its end.
+ * Returns: 0 on success, -1 on error.
+ */
+int histstore_clear(void) {
+    if (store_fd < 0) {
+        return -1;
+    }
+    return compact(0);
+}
+
+/**
+ * histstore_close - Unmap and close the history file.
+ */
+void histstore_close(void) {
+    reset_index();
+    if (store_fd >= 0) {
+        close(store_fd);
+        store_fd = -1;
+    }
+    free(store_path);
+    store_path = NULL;
+    free(offsets);
+    offsets = NULL;
+    capacity = 0;
+}
@@ -0,0 +1,206 @@
+#define _GNU_SOURCE
+#include "input.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INPUT_BLOCK_SIZE (64 * 1024)
+
+struct input_reader {
+    int fd;                 // Source descriptor, -1 for strings and maps
+    int shared;             // Keep the fd offset in step with consumed input
+    const char *data;       // Whole input (mmap'ed file or -c string)
+    size_t data_size;
+    size_t data_offset;     // Bytes of data consumed
+    int mapped;             // data is an mmap to unmap on close
+    char *buffer;           // Block buffer for fds, or line copy for data
+    size_t capacity;
+    size_t start;           // Unconsumed bytes are buffer[start, end)
+    size_t end;
+    int eof;
+};
+
+// Helper: allocate a reader with a buffer of @capacity bytes
+static input_reader_t *reader_new(size_t capacity) {
+    input_reader_t *reader = calloc(1, sizeof(input_reader_t));
+    if (!reader) return NULL;
+    reader->fd = -1;
+    reader->buffer = malloc(capacity);
+    if (!reader->buffer) {
+        free(reader);
+        return NULL;
+    }
+    reader->capacity = capacity;
+    return reader;
+}
+
+/**
+ * input_open_fd - Create a line reader for a descriptor.
+ * @fd: Descriptor to read.
+ * @shared: Non-zero if commands may also read from @fd.
+ *
+ * Returns: Reader, or NULL on allocation failure.
+ */
+input_reader_t *input_open_fd(int fd, int shared) {
+    input_reader_t *reader = reader_new(INPUT_BLOCK_SIZE);
+    if (!reader) return NULL;
+
+    struct stat st;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && offset >= 0 && st.st_size > offset) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            reader->data = map;
+            reader->data_size = st.st_size;
+            reader->data_offset = offset;
+            reader->mapped = 1;
+            reader->fd = shared ? fd : -1;
+            reader->shared = shared;
+            return reader;
+        }
+    }
+
+    reader->fd = fd;
+    return reader;
+}
+
+/**
+ * input_open_string - Create a line reader over a string.
+ * @str: Input text; must outlive the reader.
+ *
+ * Returns: Reader, or NULL on allocation failure.
+ */
+input_reader_t *input_open_string(const char *str) {
+    input_reader_t *reader = reader_new(256);
+    if (!reader) return NULL;
+    reader->data = str;
+    reader->data_size = strlen(str);
+    return reader;
+}
+
+// Helper: ensure room for @size bytes plus a terminator in the buffer
+static int reserve(input_reader_t *reader, size_t size) {
+    if (size + 1 <= reader->capacity) return 0;
+    size_t capacity = reader->capacity;
+    while (size + 1 > capacity) capacity *= 2;
+    char *grown = realloc(reader->buffer, capacity);
+    if (!grown) return -1;
+    reader->buffer = grown;
+    reader->capacity = capacity;
+    return 0;
+}
+
+// Helper: next line from in-memory data, copied so it can be terminated
+static char *next_data_line(input_reader_t *reader, size_t *len) {
+    if (reader->shared) {
+        // A command may have consumed (or given back) some of our input
+        off_t position = lseek(reader->fd, 0, SEEK_CUR);
+        if (position >= 0) reader->data_offset = position;
+    }
+    if (reader->data_offset >= reader->data_size) return NULL;
+
+    const char *line = reader->data + reader->data_offset;
+    size_t remaining = reader->data_size - reader->data_offset;
+    const char *newline = memchr(line, '\n', remaining);
+    size_t line_len = newline ? (size_t)(newline - line) : remaining;
+
+    if (reserve(reader, line_len) != 0) {
+        print_error("input: out of memory");
+        return NULL;
+    }
+    memcpy(reader->buffer, line, line_len);
+    reader->buffer[line_len] = '\0';
+    reader->data_offset += line_len + (newline ? 1 : 0);
+
+    if (reader->shared) {
+        lseek(reader->fd, reader->data_offset, SEEK_SET);
+    }
+    *len = line_len;
+    return reader->buffer;
+}
+
+// Helper: next line from the block buffer, refilling with read()
+static char *next_fd_line(input_reader_t *reader, size_t *len) {
+    size_t scanned = reader->start;
+
+    for (;;) {
+        char *newline = memchr(reader->buffer + scanned, '\n', reader->end - scanned);
+        if (newline) {
+            char *line = reader->buffer + reader->start;
+            *newline = '\0';
+            *len = newline - line;
+            reader->start = newline + 1 - reader->buffer;
+            return line;
+        }
+
+        if (reader->eof) {
+            if (reader->start == reader->end) return NULL;
+            // Last line without a trailing newline
+            char *line = reader->buffer + reader->start;
+            reader->buffer[reader->end] = '\0';
+            *len = reader->end - reader->start;
+            reader->start = reader->end;
+            return line;
+        }
+
+        // Move the partial line to the front and read another block
+        size_t pending = reader->end - reader->start;
+        if (reader->start > 0) {
+            memmove(reader->buffer, reader->buffer + reader->start, pending);
+            reader->start = 0;
+            reader->end = pending;
+        }
+        scanned = reader->end;
+        if (reserve(reader, reader->end + INPUT_BLOCK_SIZE / 2) != 0) {
+            print_error("input: out of memory");
+            return NULL;
+        }
+
+        ssize_t nread = read(reader->fd, reader->buffer + reader->end,
+                             reader->capacity - reader->end - 1);
+        if (nread < 0) {
+            if (errno == EINTR) continue;
+            print_system_error("input: read failed");
+            reader->eof = 1;
+        } else if (nread == 0) {
+            reader->eof = 1;
+        } else {
+            reader->end += nread;
+        }
+    }
+}
+
+/**
+ * input_next_line - Get the next input line.
+ * @reader: Reader.
+ * @len: Output pointer for the line length (may be NULL).
+ *
+ * Returns: NUL-terminated line without its newline, or NULL at end of input.
+ */
+char *input_next_line(input_reader_t *reader, size_t *len) {
+    size_t line_len = 0;
+    if (!reader) return NULL;
+
+    char *line = reader->data ? next_data_line(reader, &line_len)
+                              : next_fd_line(reader, &line_len);
+    if (line && len) *len = line_len;
+    return line;
+}
+
+/**
+ * input_close - Free a line reader.
+ * @reader: Reader to free.
+ */
+void input_close(input_reader_t *reader) {
+    if (!reader) return;
+    if (reader->mapped) {
+        munmap((void *)reader->data, reader->data_size);
+    }
+    free(reader->buffer);
+    free(reader);
+}
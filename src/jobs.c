@@ -0,0 +1,1068 @@
+#define _GNU_SOURCE
+#include "jobs.h"
+#include "options.h"
+#include "outbuf.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+
+#define JOBS_INITIAL_SLOTS 16
+#define JOBS_INITIAL_BUCKETS 64
+
+// Pid hash entry for one process of a job (its state lives in job->procs)
+typedef struct job_proc_entry {
+    job_t *job;
+    int index;                          // Position in job->procs
+    int raw_status;                     // Status word from waitpid
+    int pidfd;                          // Readable when the process exits, or -1
+    struct job_proc_entry *hash_next;
+} job_proc_entry_t;
+
+// Private part of a job: process entries and change list links
+typedef struct job_private {
+    job_t pub;
+    job_proc_entry_t *entries;
+    struct job_private *changed_prev;   // Jobs done or stopped since last report
+    struct job_private *changed_next;
+    int on_changed;
+} job_private_t;
+
+// Jobs indexed by id (slot 0 unused)
+static job_private_t **slots = NULL;
+static int slot_capacity = 0;
+static int max_id = 0;
+
+// pid -> process entry
+static job_proc_entry_t **buckets = NULL;
+static size_t bucket_count = 0;
+static size_t pid_count = 0;
+
+// Jobs whose state changed, oldest first
+static job_private_t *changed_head = NULL;
+static job_private_t *changed_tail = NULL;
+
+static unsigned long next_seq = 1;
+static pid_t last_background_pid = 0;
+
+// SIGCHLD self-pipe
+static int signal_pipe[2] = { -1, -1 };
+
+// Told about pidfds of background processes as they open and close
+static jobs_watch_fn watch_hook = NULL;
+static int pidfd_supported = 1;
+
+// Helper: SIGCHLD handler; only wakes up the main loop, reaping happens there
+static void handle_sigchld(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    if (signal_pipe[1] >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(signal_pipe[1], &byte, 1);
+        (void)ignored;  // A full pipe already holds a wakeup
+    }
+    errno = saved_errno;
+}
+
+/**
+ * jobs_init - Install the SIGCHLD handler and its self-pipe.
+ *
+ * The handler only writes a byte to a non-blocking pipe; children are
+ * collected by jobs_reap and jobs_wait in the main flow, so the table is
+ * never touched from signal context.
+ */
+void jobs_init(void) {
+    if (signal_pipe[0] < 0) {
+        if (pipe2(signal_pipe, O_CLOEXEC | O_NONBLOCK) == -1) {
+            print_system_error("jobs: pipe failed");
+            signal_pipe[0] = signal_pipe[1] = -1;
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_sigchld;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGCHLD, &sa, NULL);
+}
+
+/**
+ * jobs_signal_fd - Get the read end of the SIGCHLD self-pipe.
+ *
+ * Returns: Descriptor that becomes readable when a child changes state, or -1.
+ */
+int jobs_signal_fd(void) {
+    return signal_pipe[0];
+}
+
+// Helper: hash a pid into the bucket array
+static size_t hash_pid(pid_t pid) {
+    return ((size_t)pid * 2654435761u) & (bucket_count - 1);
+}
+
+// Helper: double the bucket array once the load factor passes 3/4
+static void grow_buckets(void) {
+    size_t new_count = bucket_count ? bucket_count * 2 : JOBS_INITIAL_BUCKETS;
+    job_proc_entry_t **new_buckets = calloc(new_count, sizeof(job_proc_entry_t *));
+    if (!new_buckets) return;  // Keep the old, fuller table
+
+    size_t old_count = bucket_count;
+    job_proc_entry_t **old_buckets = buckets;
+    buckets = new_buckets;
+    bucket_count = new_count;
+    for (size_t i = 0; i < old_count; i++) {
+        job_proc_entry_t *entry = old_buckets[i];
+        while (entry) {
+            job_proc_entry_t *next = entry->hash_next;
+            size_t slot = hash_pid(entry->job->procs[entry->index].pid);
+            entry->hash_next = buckets[slot];
+            buckets[slot] = entry;
+            entry = next;
+        }
+    }
+    free(old_buckets);
+}
+
+// Helper: add a process to the pid hash
+static void hash_insert(job_proc_entry_t *entry) {
+    if (pid_count + 1 > bucket_count * 3 / 4) {
+        grow_buckets();
+    }
+    if (!buckets) return;
+    size_t slot = hash_pid(entry->job->procs[entry->index].pid);
+    entry->hash_next = buckets[slot];
+    buckets[slot] = entry;
+    pid_count++;
+}
+
+// Helper: drop a process from the pid hash
+static void hash_remove(job_proc_entry_t *entry) {
+    if (!buckets) return;
+    job_proc_entry_t **link = &buckets[hash_pid(entry->job->procs[entry->index].pid)];
+    while (*link && *link != entry) {
+        link = &(*link)->hash_next;
+    }
+    if (*link) {
+        *link = entry->hash_next;
+        pid_count--;
+    }
+}
+
+// Helper: find the process entry for a pid
+static job_proc_entry_t *hash_find(pid_t pid) {
+    if (!buckets) return NULL;
+    job_proc_entry_t *entry = buckets[hash_pid(pid)];
+    while (entry && entry->job->procs[entry->index].pid != pid) {
+        entry = entry->hash_next;
+    }
+    return entry;
+}
+
+// Helper: queue a job for notification / wait -n (once)
+static void changed_push(job_private_t *job) {
+    if (job->on_changed) return;
+    job->on_changed = 1;
+    job->changed_next = NULL;
+    job->changed_prev = changed_tail;
+    if (changed_tail) {
+        changed_tail->changed_next = job;
+    } else {
+        changed_head = job;
+    }
+    changed_tail = job;
+}
+
+// Helper: unlink a job from the change list
+static void changed_unlink(job_private_t *job) {
+    if (!job->on_changed) return;
+    if (job->changed_prev) {
+        job->changed_prev->changed_next = job->changed_next;
+    } else {
+        changed_head = job->changed_next;
+    }
+    if (job->changed_next) {
+        job->changed_next->changed_prev = job->changed_prev;
+    } else {
+        changed_tail = job->changed_prev;
+    }
+    job->on_changed = 0;
+    job->changed_prev = job->changed_next = NULL;
+}
+
+// Helper: open a pidfd for a process (once); -1 if pidfds are unsupported
+static int open_pidfd(job_proc_entry_t *entry) {
+    if (entry->pidfd >= 0 || !pidfd_supported) return entry->pidfd;
+#ifdef SYS_pidfd_open
+    int fd = (int)syscall(SYS_pidfd_open, entry->job->procs[entry->index].pid, 0);
+    if (fd == -1) {
+        if (errno == ENOSYS) pidfd_supported = 0;
+        return -1;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    entry->pidfd = fd;
+    if (watch_hook) watch_hook(fd, 1);
+    return fd;
+#else
+    pidfd_supported = 0;
+    return -1;
+#endif
+}
+
+// Helper: open a pidfd for a background process so the hook can watch it.
+// Failures are harmless: SIGCHLD still wakes the shell.
+static void watch_proc(job_proc_entry_t *entry) {
+    if (watch_hook) open_pidfd(entry);
+}
+
+// Helper: close a process's pidfd, if any
+static void unwatch_proc(job_proc_entry_t *entry) {
+    if (entry->pidfd < 0) return;
+    if (watch_hook) watch_hook(entry->pidfd, 0);
+    close(entry->pidfd);
+    entry->pidfd = -1;
+}
+
+// Helper: watch every running process of a background job
+static void watch_job(job_private_t *job) {
+    for (int i = 0; i < job->pub.proc_count; i++) {
+        if (job->pub.procs[i].state != JOB_DONE) {
+            watch_proc(&job->entries[i]);
+        }
+    }
+}
+
+/**
+ * jobs_set_watch - Register a hook for background process pidfds.
+ * @hook: Called with (fd, 1) when a pidfd is opened and (fd, 0) before it
+ *        is closed; NULL to stop opening pidfds.
+ *
+ * Lets an event loop wake up as soon as a background process exits.
+ */
+void jobs_set_watch(jobs_watch_fn hook) {
+    watch_hook = hook;
+}
+
+// Helper: convert a waitpid status into a shell exit status
+static int exit_status_from_wait(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    if (WIFSTOPPED(status)) {
+        return 128 + WSTOPSIG(status);
+    }
+    return 1;
+}
+
+// Helper: make room for job id @id
+static int ensure_slot(int id) {
+    if (id < slot_capacity) return 0;
+    int new_capacity = slot_capacity ? slot_capacity : JOBS_INITIAL_SLOTS;
+    while (new_capacity <= id) {
+        new_capacity *= 2;
+    }
+    job_private_t **grown = realloc(slots, new_capacity * sizeof(job_private_t *));
+    if (!grown) return -1;
+    memset(grown + slot_capacity, 0, (new_capacity - slot_capacity) * sizeof(job_private_t *));
+    slots = grown;
+    slot_capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * jobs_add - Register started processes as a job.
+ * @pgid: Process group of the job (0 if the processes share the shell's).
+ * @pids: Pid of each stage; <= 0 for a stage that never started.
+ * @statuses: Status of stages that never started (may be NULL).
+ * @count: Number of stages.
+ * @command: Text shown by `jobs` (copied).
+ * @flags: JOB_BACKGROUND, JOB_INTERNAL.
+ *
+ * The job gets the lowest id above every live job, as in other shells.
+ * Returns: New job, or NULL on allocation failure.
+ */
+job_t *jobs_add(pid_t pgid, const pid_t *pids, const int *statuses, int count,
+                const char *command, int flags) {
+    int id = max_id + 1;
+    if (count <= 0 || ensure_slot(id) != 0) {
+        return NULL;
+    }
+
+    job_private_t *job = calloc(1, sizeof(job_private_t));
+    job_proc_entry_t *entries = calloc(count, sizeof(job_proc_entry_t));
+    job_proc_t *procs = calloc(count, sizeof(job_proc_t));
+    char *text = strdup_safe(command ? command : "");
+    if (!job || !entries || !procs || !text) {
+        free(job);
+        free(entries);
+        free(procs);
+        free(text);
+        return NULL;
+    }
+
+    job->pub.id = id;
+    job->pub.pgid = pgid;
+    job->pub.command = text;
+    job->pub.procs = procs;
+    job->pub.proc_count = count;
+    job->pub.flags = flags;
+    job->pub.seq = next_seq++;
+    job->entries = entries;
+
+    for (int i = 0; i < count; i++) {
+        job_proc_entry_t *entry = &entries[i];
+        entry->job = &job->pub;
+        entry->index = i;
+        entry->pidfd = -1;
+        if (pids[i] > 0) {
+            procs[i].pid = pids[i];
+            procs[i].state = JOB_RUNNING;
+            job->pub.running++;
+            hash_insert(entry);
+        } else {
+            procs[i].pid = -1;
+            procs[i].state = JOB_DONE;
+            procs[i].status = statuses ? statuses[i] : 1;
+            entry->raw_status = (procs[i].status & 0xff) << 8;
+        }
+    }
+
+    slots[id] = job;
+    max_id = id;
+
+    if (flags & JOB_BACKGROUND) {
+        for (int i = count - 1; i >= 0; i--) {
+            if (pids[i] > 0) {
+                last_background_pid = pids[i];
+                break;
+            }
+        }
+        if (job->pub.running == 0) {
+            changed_push(job);
+        }
+        watch_job(job);
+    }
+    return &job->pub;
+}
+
+/**
+ * jobs_find_id - Look up a job by number.
+ * @id: Job number.
+ *
+ * Returns: Job, or NULL.
+ */
+job_t *jobs_find_id(int id) {
+    if (id <= 0 || id > max_id) return NULL;
+    return slots[id] ? &slots[id]->pub : NULL;
+}
+
+/**
+ * jobs_find_pid - Look up the job a process belongs to.
+ * @pid: Process id of any stage.
+ *
+ * Returns: Job, or NULL.
+ */
+job_t *jobs_find_pid(pid_t pid) {
+    job_proc_entry_t *entry = hash_find(pid);
+    return entry ? entry->job : NULL;
+}
+
+// Helper: listed jobs with the highest and second-highest seq (%+ and %-)
+static void find_current(job_t **current, job_t **previous) {
+    *current = *previous = NULL;
+    for (int id = 1; id <= max_id; id++) {
+        job_t *job = slots[id] ? &slots[id]->pub : NULL;
+        if (!job || (job->flags & JOB_INTERNAL)) continue;
+        // A stopped job is preferred as current, as in other shells
+        int rank = job->stopped > 0;
+        int cur_rank = *current ? (*current)->stopped > 0 : -1;
+        if (!*current || rank > cur_rank || (rank == cur_rank && job->seq > (*current)->seq)) {
+            *previous = *current;
+            *current = job;
+        } else if (!*previous || job->seq > (*previous)->seq) {
+            *previous = job;
+        }
+    }
+}
+
+/**
+ * jobs_current - Get the current job (%+).
+ *
+ * Returns: Most recently stopped job, else the most recently started one.
+ */
+job_t *jobs_current(void) {
+    job_t *current, *previous;
+    find_current(&current, &previous);
+    return current;
+}
+
+/**
+ * jobs_parse_spec - Resolve a job specification.
+ * @spec: %n, %%, %+, %-, %prefix, or a process id.
+ * @builtin: Builtin name used in error messages.
+ *
+ * Returns: Job, or NULL after printing an error.
+ */
+job_t *jobs_parse_spec(const char *spec, const char *builtin) {
+    job_t *current, *previous;
+    job_t *job = NULL;
+
+    if (!spec || !*spec) {
+        spec = "%+";
+    }
+    if (spec[0] != '%') {
+        char *end;
+        long pid = strtol(spec, &end, 10);
+        if (*end != '\0' || pid <= 0) {
+            print_error("%s: %s: arguments must be process or job IDs", builtin, spec);
+            return NULL;
+        }
+        job = jobs_find_pid((pid_t)pid);
+        if (!job) {
+            print_error("%s: pid %ld is not a child of this shell", builtin, pid);
+        }
+        return job;
+    }
+
+    const char *rest = spec + 1;
+    if (*rest == '\0' || strcmp(rest, "%") == 0 || strcmp(rest, "+") == 0) {
+        find_current(&current, &previous);
+        job = current;
+    } else if (strcmp(rest, "-") == 0) {
+        find_current(&current, &previous);
+        job = previous ? previous : current;
+    } else if (*rest >= '0' && *rest <= '9') {
+        char *end;
+        long id = strtol(rest, &end, 10);
+        if (*end == '\0' && id <= max_id) {
+            job = jobs_find_id((int)id);
+        }
+    } else {
+        // %prefix: the job whose command starts with the text
+        size_t len = strlen(rest);
+        for (int id = 1; id <= max_id; id++) {
+            job_t *candidate = slots[id] ? &slots[id]->pub : NULL;
+            if (!candidate || (candidate->flags & JOB_INTERNAL)) continue;
+            if (strncmp(candidate->command, rest, len) == 0) {
+                if (job) {
+                    print_error("%s: %s: ambiguous job spec", builtin, spec);
+                    return NULL;
+                }
+                job = candidate;
+            }
+        }
+    }
+
+    if (!job || (job->flags & JOB_INTERNAL)) {
+        print_error("%s: %s: no such job", builtin, spec);
+        return NULL;
+    }
+    return job;
+}
+
+// Helper: record a status change reported by waitpid
+static void record_status(pid_t pid, int raw) {
+    job_proc_entry_t *entry = hash_find(pid);
+    if (!entry) {
+        return;  // Not one of ours (e.g. reaped for a forgotten job)
+    }
+    job_t *job = entry->job;
+    job_private_t *priv = (job_private_t *)job;
+    job_proc_t *proc = &job->procs[entry->index];
+
+    if (WIFSTOPPED(raw)) {
+        if (proc->state == JOB_RUNNING) {
+            job->running--;
+            job->stopped++;
+        }
+        proc->state = JOB_STOPPED;
+        proc->status = exit_status_from_wait(raw);
+        entry->raw_status = raw;
+        if (job->running == 0) {
+            job->seq = next_seq++;
+            job->notified = 0;
+            changed_push(priv);
+        }
+    } else if (WIFCONTINUED(raw)) {
+        if (proc->state == JOB_STOPPED) {
+            job->stopped--;
+            job->running++;
+        }
+        proc->state = JOB_RUNNING;
+    } else {
+        if (proc->state == JOB_RUNNING) {
+            job->running--;
+        } else if (proc->state == JOB_STOPPED) {
+            job->stopped--;
+        }
+        proc->state = JOB_DONE;
+        proc->status = exit_status_from_wait(raw);
+        entry->raw_status = raw;
+        hash_remove(entry);
+        unwatch_proc(entry);
+        if (job->running == 0 && job->stopped == 0) {
+            job->notified = 0;
+            changed_push(priv);
+        }
+    }
+}
+
+// Helper: collect one child status change.
+// Returns: 1 if a child was collected, 0 if none was ready, -1 if there
+//          are no children at all.
+static int reap_one(int block) {
+    int raw;
+    pid_t pid;
+    int options = WUNTRACED | WCONTINUED | (block ? 0 : WNOHANG);
+
+    while ((pid = waitpid(-1, &raw, options)) == -1 && errno == EINTR) {}
+    if (pid == -1) {
+        return -1;
+    }
+    if (pid == 0) {
+        return 0;
+    }
+    record_status(pid, raw);
+    return 1;
+}
+
+// Helper: empty the self-pipe
+static void drain_signal_pipe(void) {
+    char buf[64];
+    if (signal_pipe[0] < 0) return;
+    while (read(signal_pipe[0], buf, sizeof(buf)) > 0) {}
+}
+
+/**
+ * jobs_reap - Collect every child that changed state, without blocking.
+ */
+void jobs_reap(void) {
+    drain_signal_pipe();
+    while (reap_one(0) > 0) {}
+}
+
+/**
+ * jobs_wait_event - Block until some child changes state and record it.
+ *
+ * For callers that run several jobs at once and check which of them
+ * finished.
+ * Returns: 0, or -1 if the shell has no children left.
+ */
+int jobs_wait_event(void) {
+    return reap_one(1) < 0 ? -1 : 0;
+}
+
+// Helper: whether a job has no running process left
+static int job_settled(const job_t *job) {
+    return job->running == 0;
+}
+
+// Helper: wait with pidfds and a timerfd armed for @timeout.
+// Returns: 1 settled, 0 timed out, -1 if pidfds or timerfd are unavailable.
+static int wait_until_pidfd(job_t *job, const struct timespec *timeout) {
+    job_private_t *priv = (job_private_t *)job;
+    struct pollfd fds[job->proc_count + 1];
+
+    for (int i = 0; i < job->proc_count; i++) {
+        if (job->procs[i].state != JOB_DONE && open_pidfd(&priv->entries[i]) < 0) {
+            return -1;
+        }
+    }
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer == -1) {
+        return -1;
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value = *timeout;
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;  // Zero would disarm the timer
+    }
+    timerfd_settime(timer, 0, &spec, NULL);
+
+    int result = 0;
+    for (;;) {
+        jobs_reap();
+        if (job_settled(job)) {
+            result = 1;
+            break;
+        }
+
+        int count = 0;
+        for (int i = 0; i < job->proc_count; i++) {
+            if (job->procs[i].state == JOB_RUNNING && priv->entries[i].pidfd >= 0) {
+                fds[count].fd = priv->entries[i].pidfd;
+                fds[count].events = POLLIN;
+                count++;
+            }
+        }
+        fds[count].fd = timer;
+        fds[count].events = POLLIN;
+        if (poll(fds, count + 1, -1) == -1 && errno != EINTR) {
+            result = -1;
+            break;
+        }
+        if (fds[count].revents & POLLIN) {
+            // Deadline: settle on whatever exited meanwhile
+            jobs_reap();
+            result = job_settled(job);
+            break;
+        }
+    }
+    close(timer);
+    return result;
+}
+
+// Helper: wait with sigtimedwait on SIGCHLD (kernels without pidfd_open).
+// SIGCHLD is blocked while waiting, so no exit can slip in between the
+// check and the wait.
+static int wait_until_sigchld(job_t *job, const struct timespec *timeout) {
+    sigset_t mask, old_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &old_mask);
+
+    struct timespec deadline, now;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout->tv_sec;
+    deadline.tv_nsec += timeout->tv_nsec;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    int result;
+    for (;;) {
+        jobs_reap();
+        if (job_settled(job)) {
+            result = 1;
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        struct timespec left;
+        left.tv_sec = deadline.tv_sec - now.tv_sec;
+        left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+        if (left.tv_nsec < 0) {
+            left.tv_sec--;
+            left.tv_nsec += 1000000000L;
+        }
+        if (left.tv_sec < 0) {
+            result = 0;
+            break;
+        }
+        sigtimedwait(&mask, NULL, &left);
+    }
+
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+    return result;
+}
+
+/**
+ * jobs_wait_until - Wait for a job to finish or stop, for a bounded time.
+ * @job: Job to wait for.
+ * @timeout: Longest time to wait.
+ *
+ * Sleeps in poll() on the job's pidfds and a timerfd, so no extra process
+ * or signal handler is involved; kernels without pidfd_open fall back to
+ * sigtimedwait on SIGCHLD. The job stays in the table either way; collect
+ * it with jobs_wait.
+ * Returns: 1 if no process of the job is running any more, 0 on timeout.
+ */
+int jobs_wait_until(job_t *job, const struct timespec *timeout) {
+    if (!job) return 1;
+    int result = wait_until_pidfd(job, timeout);
+    if (result < 0) {
+        result = wait_until_sigchld(job, timeout);
+    }
+    return result;
+}
+
+// Helper: mark every unfinished process of a job done (children lost to
+// an ECHILD, e.g. reaped by someone else)
+static void mark_lost(job_t *job) {
+    job_private_t *priv = (job_private_t *)job;
+    for (int i = 0; i < job->proc_count; i++) {
+        if (job->procs[i].state != JOB_DONE) {
+            job->procs[i].state = JOB_DONE;
+            hash_remove(&priv->entries[i]);
+            unwatch_proc(&priv->entries[i]);
+        }
+    }
+    job->running = job->stopped = 0;
+}
+
+/**
+ * jobs_wait - Wait for a job to finish or stop.
+ * @job: Job to wait for.
+ * @statuses: Receives the status of each stage (may be NULL).
+ *
+ * Other children that change state meanwhile are recorded too. A finished
+ * job is removed from the table; a stopped one stays and is reported as
+ * `[n]+  Stopped` when job control is on.
+ * Returns: Status of the last stage, or 128 + the stop signal.
+ */
+int jobs_wait(job_t *job, int *statuses) {
+    if (!job) return 127;
+
+    while (job->running > 0) {
+        if (reap_one(1) < 0) {
+            mark_lost(job);
+        }
+    }
+
+    if (statuses) {
+        for (int i = 0; i < job->proc_count; i++) {
+            statuses[i] = job->procs[i].status;
+        }
+    }
+    int status = job->procs[job->proc_count - 1].status;
+
+    if (job->stopped > 0) {
+        // Report the stop now; the job stays listed
+        for (int i = 0; i < job->proc_count; i++) {
+            if (job->procs[i].state == JOB_STOPPED) {
+                status = job->procs[i].status;
+            }
+        }
+        job->flags |= JOB_BACKGROUND;
+        job->flags &= ~JOB_INTERNAL;
+        changed_unlink((job_private_t *)job);
+        if (!job->notified && shell_is_interactive()) {
+            outbuf_printf("\n[%d]+  %-24s%s\n", job->id, "Stopped", job->command);
+            outbuf_flush();
+        }
+        job->notified = 1;
+        return status;
+    }
+
+    jobs_remove(job);
+    return status;
+}
+
+/**
+ * jobs_wait_any - Wait until some listed job finishes (wait -n).
+ *
+ * A job that already finished but was not reported is returned at once.
+ * Returns: Finished job (still in the table), or NULL if none is running.
+ */
+job_t *jobs_wait_any(void) {
+    for (;;) {
+        for (job_private_t *job = changed_head; job; job = job->changed_next) {
+            if (job->pub.running == 0 && job->pub.stopped == 0 &&
+                !(job->pub.flags & JOB_INTERNAL)) {
+                return &job->pub;
+            }
+        }
+
+        int waiting = 0;
+        for (int id = 1; id <= max_id && !waiting; id++) {
+            waiting = slots[id] && slots[id]->pub.running > 0 &&
+                      !(slots[id]->pub.flags & JOB_INTERNAL);
+        }
+        if (!waiting || reap_one(1) < 0) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * jobs_wait_all - Wait for every running job (wait without arguments).
+ *
+ * Jobs are taken in id order; each collected child costs one table update,
+ * however many jobs there are. Finished jobs are then dropped without
+ * being reported. Stopped jobs are left alone.
+ */
+void jobs_wait_all(void) {
+    for (int id = 1; id <= max_id; id++) {
+        job_t *job = slots[id] ? &slots[id]->pub : NULL;
+        if (!job || (job->flags & JOB_INTERNAL)) continue;
+        while (job->running > 0) {
+            if (reap_one(1) < 0) {
+                mark_lost(job);
+            }
+        }
+        if (job->stopped == 0) {
+            jobs_remove(job);
+        }
+    }
+}
+
+// Helper: set a job's processes running again after SIGCONT
+static int continue_job(job_t *job) {
+    job_private_t *priv = (job_private_t *)job;
+    if (job->pgid > 0 ? kill(-job->pgid, SIGCONT) : 0) {
+        print_system_error("failed to continue job");
+        return -1;
+    }
+    for (int i = 0; i < job->proc_count; i++) {
+        if (job->procs[i].state == JOB_STOPPED) {
+            job->procs[i].state = JOB_RUNNING;
+            job->stopped--;
+            job->running++;
+        }
+    }
+    job->seq = next_seq++;
+    changed_unlink(priv);
+    return 0;
+}
+
+/**
+ * jobs_foreground - Resume a job in the foreground (fg).
+ * @job: Job to resume.
+ * @owns_terminal: Whether to hand the terminal to the job while it runs.
+ *
+ * Returns: Status as from jobs_wait.
+ */
+int jobs_foreground(job_t *job, int owns_terminal) {
+    outbuf_puts(job->command);
+    outbuf_write("\n", 1);
+    outbuf_flush();  // Before the job writes to the same terminal
+
+    job->flags &= ~JOB_BACKGROUND;
+    if (owns_terminal && job->pgid > 0) {
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    }
+    int status = continue_job(job) == 0 ? jobs_wait(job, NULL) : 1;
+    if (owns_terminal && job->pgid > 0) {
+        tcsetpgrp(STDIN_FILENO, getpgrp());
+    }
+    return status;
+}
+
+/**
+ * jobs_background - Resume a stopped job in the background (bg).
+ * @job: Job to resume.
+ *
+ * Returns: 0 on success, 1 on error.
+ */
+int jobs_background(job_t *job) {
+    if (job->stopped == 0) {
+        print_error("bg: job %d already in background", job->id);
+        return 0;
+    }
+    job->flags |= JOB_BACKGROUND;
+    if (continue_job(job) != 0) {
+        return 1;
+    }
+    watch_job((job_private_t *)job);
+    outbuf_printf("[%d]+ %s &\n", job->id, job->command);
+    return 0;
+}
+
+// Helper: describe a job's state the way `jobs` prints it
+static const char *describe_state(const job_t *job, char *buf, size_t size) {
+    if (job->running > 0) {
+        return "Running";
+    }
+    const job_proc_entry_t *entries = ((const job_private_t *)job)->entries;
+    if (job->stopped > 0) {
+        for (int i = 0; i < job->proc_count; i++) {
+            if (job->procs[i].state != JOB_STOPPED) continue;
+            // "Stopped" for SIGTSTP, "Stopped (signal)", "Stopped (tty input)", ...
+            snprintf(buf, size, "%s", strsignal(WSTOPSIG(entries[i].raw_status)));
+            return buf;
+        }
+    }
+
+    int raw = entries[job->proc_count - 1].raw_status;
+    if (WIFSIGNALED(raw)) {
+        snprintf(buf, size, "%s%s", strsignal(WTERMSIG(raw)),
+                 WCOREDUMP(raw) ? " (core dumped)" : "");
+        return buf;
+    }
+    if (WIFEXITED(raw) && WEXITSTATUS(raw) != 0) {
+        snprintf(buf, size, "Exit %d", WEXITSTATUS(raw));
+        return buf;
+    }
+    return "Done";
+}
+
+// Helper: print one job line
+static void print_job(const job_t *job, int mode, const job_t *current, const job_t *previous) {
+    char buf[64];
+    char mark = job == current ? '+' : job == previous ? '-' : ' ';
+
+    if (mode == 'p') {
+        outbuf_printf("%d\n", job->pgid > 0 ? job->pgid : job->procs[0].pid);
+        return;
+    }
+    const char *state = describe_state(job, buf, sizeof(buf));
+    if (mode == 'l') {
+        // The state column is 24 wide; a longer state still gets a space
+        outbuf_printf("[%d]%c %d %-23s %s%s\n", job->id, mark,
+               job->pgid > 0 ? job->pgid : job->procs[0].pid, state, job->command,
+               job->running > 0 ? " &" : "");
+    } else {
+        outbuf_printf("[%d]%c  %-23s %s%s\n", job->id, mark, state, job->command,
+               job->running > 0 ? " &" : "");
+    }
+}
+
+/**
+ * jobs_print - List jobs (the `jobs` builtin).
+ * @mode: 0 for the normal format, 'l' to add process group ids, 'p' for
+ *        process group ids only.
+ *
+ * Finished jobs are listed once and then removed.
+ */
+void jobs_print(int mode) {
+    job_t *current, *previous;
+    find_current(&current, &previous);
+
+    for (int id = 1; id <= max_id; id++) {
+        job_t *job = slots[id] ? &slots[id]->pub : NULL;
+        if (!job || (job->flags & JOB_INTERNAL)) continue;
+        print_job(job, mode, current, previous);
+        if (job->running == 0 && job->stopped == 0) {
+            jobs_remove(job);
+        } else if (job->stopped > 0) {
+            job->notified = 1;
+            changed_unlink((job_private_t *)job);
+        }
+    }
+}
+
+/**
+ * jobs_have_changes - Check whether jobs_notify has anything to do.
+ *
+ * Returns: 1 if some job finished or stopped since the last report.
+ */
+int jobs_have_changes(void) {
+    return changed_head != NULL;
+}
+
+/**
+ * jobs_notify - Report background jobs that finished or stopped.
+ *
+ * Walks only the jobs that changed since the last call, so the cost does
+ * not grow with the number of running jobs. Finished jobs are removed.
+ */
+void jobs_notify(void) {
+    if (!changed_head) return;
+
+    job_t *current, *previous;
+    find_current(&current, &previous);
+    while (changed_head) {
+        job_t *job = &changed_head->pub;
+        changed_unlink(changed_head);
+        if (job->flags & JOB_INTERNAL) {
+            continue;
+        }
+        if (!job->notified && (job->flags & JOB_BACKGROUND)) {
+            print_job(job, 0, current, previous);
+            job->notified = 1;
+        }
+        if (job->running == 0 && job->stopped == 0) {
+            jobs_remove(job);
+        }
+    }
+    outbuf_flush();
+}
+
+/**
+ * jobs_remove - Remove a job from the table and free it.
+ * @job: Job to remove (may be NULL).
+ */
+void jobs_remove(job_t *job) {
+    if (!job) return;
+    job_private_t *priv = (job_private_t *)job;
+
+    for (int i = 0; i < job->proc_count; i++) {
+        if (job->procs[i].state != JOB_DONE) {
+            hash_remove(&priv->entries[i]);
+        }
+        unwatch_proc(&priv->entries[i]);
+    }
+    changed_unlink(priv);
+    if (job->id > 0 && job->id <= max_id && slots[job->id] == priv) {
+        slots[job->id] = NULL;
+        while (max_id > 0 && !slots[max_id]) {
+            max_id--;
+        }
+    }
+    free(job->command);
+    free(job->procs);
+    free(priv->entries);
+    free(priv);
+}
+
+/**
+ * jobs_next - Step through the listed jobs.
+ * @job: Previous job, or NULL to start.
+ *
+ * Returns: The listed job with the next higher id, or NULL at the end.
+ */
+job_t *jobs_next(job_t *job) {
+    for (int id = job ? job->id + 1 : 1; id <= max_id; id++) {
+        if (slots[id] && !(slots[id]->pub.flags & JOB_INTERNAL)) {
+            return &slots[id]->pub;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * jobs_count - Get the number of listed jobs.
+ *
+ * Returns: Number of jobs, excluding internal ones.
+ */
+int jobs_count(void) {
+    int count = 0;
+    for (int id = 1; id <= max_id; id++) {
+        if (slots[id] && !(slots[id]->pub.flags & JOB_INTERNAL)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * jobs_last_background_pid - Get the value of $!.
+ *
+ * Returns: Pid of the last process of the newest background job, or 0.
+ */
+pid_t jobs_last_background_pid(void) {
+    return last_background_pid;
+}
+
+/**
+ * jobs_forget_all - Empty the table without waiting for anything.
+ *
+ * Used in forked subshells: the parent's jobs are not their children. The
+ * watch hook is dropped first, as it belongs to the parent's event loop.
+ */
+void jobs_forget_all(void) {
+    watch_hook = NULL;
+    for (int id = 1; id <= max_id; id++) {
+        if (slots[id]) {
+            jobs_remove(&slots[id]->pub);
+        }
+    }
+    last_background_pid = 0;
+}
+
+/**
+ * jobs_destroy - Free the job table, its pid hash and the self-pipe.
+ */
+void jobs_destroy(void) {
+    jobs_forget_all();
+    free(slots);
+    slots = NULL;
+    slot_capacity = 0;
+    free(buckets);
+    buckets = NULL;
+    bucket_count = 0;
+    pid_count = 0;
+}
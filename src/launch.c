@@ -0,0 +1,209 @@
+#define _GNU_SOURCE
+#include "launch.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+
+extern char **environ;
+
+// Signals the shell may catch or ignore; children always start with defaults
+static const int child_default_signals[] = {
+    SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU, SIGCHLD, SIGPIPE
+};
+
+#define CHILD_DEFAULT_SIGNAL_COUNT \
+    (int)(sizeof(child_default_signals) / sizeof(child_default_signals[0]))
+
+static launch_backend_t active_backend = LAUNCH_SPAWN;
+
+/**
+ * launch_set_backend - Select the process launch backend.
+ * @backend: LAUNCH_SPAWN or LAUNCH_FORK.
+ */
+void launch_set_backend(launch_backend_t backend) {
+    active_backend = backend;
+}
+
+/**
+ * launch_get_backend - Get the active process launch backend.
+ *
+ * Returns: Active backend.
+ */
+launch_backend_t launch_get_backend(void) {
+    return active_backend;
+}
+
+/**
+ * launch_set_backend_by_name - Select the launch backend by name.
+ * @name: "spawn" or "fork".
+ *
+ * Returns: 0 on success, -1 if the name is unknown.
+ */
+int launch_set_backend_by_name(const char *name) {
+    if (!name) return -1;
+    if (strcmp(name, "spawn") == 0) {
+        active_backend = LAUNCH_SPAWN;
+        return 0;
+    }
+    if (strcmp(name, "fork") == 0) {
+        active_backend = LAUNCH_FORK;
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * launch_backend_name - Get the printable name of a launch backend.
+ * @backend: Backend.
+ *
+ * Returns: Static string.
+ */
+const char *launch_backend_name(launch_backend_t backend) {
+    return backend == LAUNCH_FORK ? "fork" : "spawn";
+}
+
+/**
+ * setup_child_signal_handlers - Reset signal handlers in child process to default.
+ *
+ * Used by code paths that fork a child running shell code (and by the
+ * fork backend before exec). The spawn backend gets the same result
+ * through POSIX_SPAWN_SETSIGDEF and POSIX_SPAWN_SETSIGMASK.
+ */
+void setup_child_signal_handlers(void) {
+    for (int i = 0; i < CHILD_DEFAULT_SIGNAL_COUNT; i++) {
+        signal(child_default_signals[i], SIG_DFL);
+    }
+
+    sigset_t empty;
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, NULL);
+}
+
+// Helper: launch through posix_spawn; glibc implements it with
+// clone(CLONE_VM | CLONE_VFORK), so the parent's page tables are never copied
+static pid_t launch_spawn(const char *path, char *const argv[], const launch_opts_t *opts) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t defaults, empty;
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    pid_t pid = -1;
+    int err;
+
+    if ((err = posix_spawn_file_actions_init(&actions)) != 0) {
+        errno = err;
+        return -1;
+    }
+    if ((err = posix_spawnattr_init(&attr)) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        errno = err;
+        return -1;
+    }
+
+    // Redirections and pipe ends become dup2 file actions. A dup2 onto the
+    // same number clears FD_CLOEXEC, so it is still passed through.
+    for (int i = 0; i < opts->dup_count && err == 0; i++) {
+        err = posix_spawn_file_actions_adddup2(&actions, opts->dups[i].fd,
+                                               opts->dups[i].target);
+    }
+
+    sigemptyset(&defaults);
+    for (int i = 0; i < CHILD_DEFAULT_SIGNAL_COUNT; i++) {
+        sigaddset(&defaults, child_default_signals[i]);
+    }
+    sigemptyset(&empty);
+
+    if (opts->pgid >= 0) {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        if (err == 0) err = posix_spawnattr_setpgroup(&attr, opts->pgid);
+    }
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    if (err == 0) err = posix_spawnattr_setsigdefault(&attr, &defaults);
+    if (err == 0) err = posix_spawnattr_setsigmask(&attr, &empty);
+    if (err == 0) err = posix_spawnattr_setflags(&attr, flags);
+    if (err == 0) err = posix_spawn(&pid, path, &actions, &attr, argv,
+                                    opts->envp ? opts->envp : environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return pid;
+}
+
+// Helper: launch through fork + execve (fallback backend)
+static pid_t launch_fork(const char *path, char *const argv[], const launch_opts_t *opts) {
+    pid_t pid = fork();
+
+    if (pid == -1) {
+        return -1;
+    }
+
+    if (pid == 0) {
+        // Child process
+        if (opts->pgid >= 0) {
+            setpgid(0, opts->pgid);
+        }
+        setup_child_signal_handlers();
+
+        for (int i = 0; i < opts->dup_count; i++) {
+            const launch_dup_t *d = &opts->dups[i];
+            if (d->fd == d->target) {
+                fcntl(d->fd, F_SETFD, 0);
+            } else if (dup2(d->fd, d->target) == -1) {
+                print_system_error("failed to redirect");
+                _exit(1);
+            }
+        }
+
+        execve(path, argv, opts->envp ? opts->envp : environ);
+        int exec_errno = errno;
+        print_system_error("exec failed");
+        _exit(exec_errno == ENOENT ? 127 : 126);
+    }
+
+    // Parent process: set the group here too so there is no window where
+    // the child has not joined yet
+    if (opts->pgid >= 0) {
+        setpgid(pid, opts->pgid == 0 ? pid : opts->pgid);
+    }
+    return pid;
+}
+
+/**
+ * launch_process - Start an executable with the active backend.
+ * @path: Resolved path of the executable.
+ * @argv: NULL-terminated argument vector.
+ * @opts: Descriptor rebindings and process group, or NULL for defaults.
+ *
+ * The child starts with default dispositions for the signals the shell
+ * handles and an empty signal mask. Descriptors in @opts are expected to be
+ * close-on-exec in the parent.
+ * Returns: Child pid, or -1 with errno set.
+ */
+pid_t launch_process(const char *path, char *const argv[], const launch_opts_t *opts) {
+    static const launch_opts_t default_opts = { NULL, 0, -1, NULL };
+
+    if (!path || !argv) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!opts) {
+        opts = &default_opts;
+    }
+
+    if (active_backend == LAUNCH_FORK) {
+        return launch_fork(path, argv, opts);
+    }
+    return launch_spawn(path, argv, opts);
+}
@@ -0,0 +1,410 @@
+#include "lexer.h"
+#include "lexscan.h"
+#include "utils.h"
+#include <ctype.h>
+#include <string.h>
+
+static const char *token_names[] = {
+    "newline", "word", "|", "||", "&&", ";", "&", "<", ">", ">>", "2>", "&>",
+    "<<", "<<-", "<<<"
+};
+
+// Helper: check for a byte that ends an unquoted word
+static int is_word_break(char c) {
+    switch (c) {
+    case '\0': case ' ': case '\t': case '\n':
+    case '|': case '&': case ';': case '<': case '>':
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Helper: check for a byte that pathname expansion would act on
+static int is_glob_byte(char c) {
+    return c == '*' || c == '?' || c == '[';
+}
+
+// Helper: append a quoted byte, marking bytes that expansion would act on
+static void append_quoted(arena_str_t *word, char c) {
+    if (c == '$' || c == LEX_CTLESC || is_glob_byte(c)) {
+        arena_str_putc(word, LEX_CTLESC);
+    }
+    arena_str_putc(word, c);
+}
+
+// Helper: append a quoted run, marking glob bytes so they stay literal
+static void append_quoted_run(arena_str_t *word, const char *s, size_t len) {
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (is_glob_byte(s[i])) {
+            arena_str_append(word, s + start, i - start);
+            append_quoted(word, s[i]);
+            start = i + 1;
+        }
+    }
+    arena_str_append(word, s + start, len - start);
+}
+
+// Helper: report a quote left open at @offset
+static int unterminated_quote(char quote, size_t offset) {
+    print_error("syntax error: unterminated %c quote (column %zu)", quote, offset + 1);
+    return -1;
+}
+
+// Helper: offset of the first "$(" in [s, s + len), or @len if none
+static size_t find_cmdsub(const char *s, size_t len) {
+    const char *p = s;
+    const char *end = s + len;
+    while ((p = memchr(p, '$', end - p)) != NULL) {
+        if (p + 1 < end && p[1] == '(') {
+            return p - s;
+        }
+        p++;
+    }
+    return len;
+}
+
+static size_t scan_cmdsub(const char *in, size_t pos);
+
+// Helper: skip a double-quoted string opened at @pos, including any $(...)
+// inside it. Returns: Offset just past the closing quote, or 0 if none.
+static size_t scan_dquote(const char *in, size_t pos) {
+    for (pos++; in[pos] != '"'; pos++) {
+        if (in[pos] == '\0') {
+            return 0;
+        }
+        if (in[pos] == '\\' && in[pos + 1] != '\0') {
+            pos++;
+        } else if (in[pos] == '$' && in[pos + 1] == '(') {
+            pos = scan_cmdsub(in, pos);
+            if (pos == 0) return 0;
+        }
+    }
+    return pos + 1;
+}
+
+// Helper: find the end of the $(...) starting at @pos, honouring quotes,
+// backslashes and nested parentheses.
+// Returns: Offset of the matching ')', or 0 if it is missing.
+static size_t scan_cmdsub(const char *in, size_t pos) {
+    int depth = 1;
+    for (pos += 2; ; pos++) {
+        switch (in[pos]) {
+        case '\0':
+            return 0;
+        case '\\':
+            if (in[pos + 1] != '\0') pos++;
+            break;
+        case '\'': {
+            const char *close = strchr(in + pos + 1, '\'');
+            if (!close) return 0;
+            pos = close - in;
+            break;
+        }
+        case '"':
+            pos = scan_dquote(in, pos);
+            if (pos == 0) return 0;
+            pos--;
+            break;
+        case '(':
+            depth++;
+            break;
+        case ')':
+            if (--depth == 0) return pos;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Helper: append the $(...) at *@pos to @word in its marked form (see
+// LEX_CMDSUB_OPEN) and move *@pos past it.
+// Returns: 0, or -1 if the closing ) is missing.
+static int lex_cmdsub(const char *in, size_t *pos, arena_str_t *word) {
+    size_t close = scan_cmdsub(in, *pos);
+    if (close == 0) {
+        print_error("syntax error: unterminated $( (column %zu)", *pos + 1);
+        return -1;
+    }
+    arena_str_putc(word, LEX_CTLESC);
+    arena_str_putc(word, LEX_CMDSUB_OPEN);
+    size_t start = *pos + 2;
+    for (size_t i = start; i < close; i++) {
+        if (in[i] == LEX_CTLESC) {
+            arena_str_append(word, in + start, i + 1 - start);
+            start = i;  // The marker goes out twice
+        }
+    }
+    arena_str_append(word, in + start, close - start);
+    arena_str_putc(word, LEX_CTLESC);
+    arena_str_putc(word, LEX_CMDSUB_CLOSE);
+    *pos = close + 1;
+    return 0;
+}
+
+// Helper: read one word starting at the cursor, removing quotes.
+// Single quotes keep everything literal; inside double quotes a backslash
+// only escapes $ ` " \ and newline, and $ stays active.
+// A $(...) is kept whole, in the marked form described in lexer.h.
+// Returns: 0, or -1 on an unterminated quote or $(...).
+static int lex_word(lexer_t *lexer, token_t *token) {
+    const char *in = lexer->input;
+    size_t pos = lexer->pos;
+
+    // NAME= at the very start of the raw word makes it an assignment
+    size_t name_len = 0;
+    while (in[pos + name_len] == '_' || isalpha((unsigned char)in[pos + name_len]) ||
+           (name_len > 0 && isdigit((unsigned char)in[pos + name_len]))) {
+        name_len++;
+    }
+    token->assignment = name_len > 0 && in[pos + name_len] == '=';
+    token->quoted = 0;
+
+    // Most words are one plain run: copy them without building a string
+    size_t plain = lexscan_unquoted(in + pos, lexer->length - pos);
+    if (plain > 0 && is_word_break(in[pos + plain]) && find_cmdsub(in + pos, plain) == plain) {
+        token->type = TOK_WORD;
+        token->word = arena_alloc(lexer->arena, plain + 1);
+        memcpy(token->word, in + pos, plain);
+        token->word[plain] = '\0';
+        lexer->pos = pos + plain;
+        return 0;
+    }
+
+    arena_str_t word;
+    arena_str_init(&word, lexer->arena);
+
+    while (!is_word_break(in[pos])) {
+        char c = in[pos];
+
+        if (c == '\'' || c == '"' || c == '\\') {
+            token->quoted = 1;
+        }
+
+        if (c == '\'') {
+            size_t open = pos++;
+            for (;;) {
+                size_t run = lexscan_squoted(in + pos, lexer->length - pos);
+                append_quoted_run(&word, in + pos, run);
+                pos += run;
+
+                if (in[pos] == '\'') {
+                    pos++;
+                    break;
+                }
+                if (in[pos] == '\0') {
+                    return unterminated_quote('\'', open);
+                }
+                append_quoted(&word, in[pos++]);  // $ or a literal marker byte
+            }
+        } else if (c == '"') {
+            size_t open = pos++;
+            for (;;) {
+                size_t run = lexscan_dquoted(in + pos, lexer->length - pos);
+                size_t sub = find_cmdsub(in + pos, run);
+                append_quoted_run(&word, in + pos, sub);
+                pos += sub;
+                if (sub < run) {
+                    if (lex_cmdsub(in, &pos, &word) != 0) return -1;
+                    continue;
+                }
+
+                if (in[pos] == '"') {
+                    pos++;
+                    break;
+                }
+                if (in[pos] == '\0') {
+                    return unterminated_quote('"', open);
+                }
+                if (in[pos] == LEX_CTLESC) {
+                    append_quoted(&word, in[pos++]);
+                    continue;
+                }
+                // Backslash
+                char next = in[pos + 1];
+                if (next == '\n') {
+                    pos += 2;  // Line continuation
+                } else if (next == '$' || next == '`' || next == '"' || next == '\\') {
+                    append_quoted(&word, next);
+                    pos += 2;
+                } else {
+                    arena_str_putc(&word, '\\');
+                    pos++;
+                }
+            }
+        } else if (c == '\\') {
+            char next = in[pos + 1];
+            if (next == '\0') {
+                arena_str_putc(&word, '\\');
+                pos++;
+            } else if (next == '\n') {
+                pos += 2;  // Line continuation
+            } else {
+                append_quoted(&word, next);
+                pos += 2;
+            }
+        } else if (c == LEX_CTLESC) {
+            append_quoted(&word, c);
+            pos++;
+        } else {
+            // Unquoted run: copied as is, $ is expanded later
+            size_t run = lexscan_unquoted(in + pos, lexer->length - pos);
+            size_t sub = find_cmdsub(in + pos, run);
+            arena_str_append(&word, in + pos, sub);
+            pos += sub;
+            if (sub < run && lex_cmdsub(in, &pos, &word) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    token->type = TOK_WORD;
+    token->word = word.data;
+    lexer->pos = pos;
+    return 0;
+}
+
+/**
+ * lexer_init - Start lexing a command line.
+ * @lexer: Lexer state to initialise.
+ * @arena: Arena that receives word text.
+ * @input: NUL-terminated command line.
+ */
+void lexer_init(lexer_t *lexer, arena_t *arena, const char *input) {
+    lexer->input = input;
+    lexer->length = strlen(input);
+    lexer->pos = 0;
+    lexer->arena = arena;
+}
+
+/**
+ * lexer_next - Read the next token.
+ * @lexer: Lexer state.
+ * @token: Output token.
+ *
+ * Skips blanks, then reads one operator or word. Every byte of the line is
+ * examined once; plain runs inside words are skipped with the lexscan
+ * kernels (SIMD where the CPU has it). A # at the start of a token begins a comment, which ends
+ * the line.
+ * Returns: 0 on success, -1 after printing a syntax error.
+ */
+int lexer_next(lexer_t *lexer, token_t *token) {
+    const char *in = lexer->input;
+    size_t pos = lexer->pos;
+
+    while (in[pos] == ' ' || in[pos] == '\t' || in[pos] == '\n') pos++;
+
+    token->offset = pos;
+    token->word = NULL;
+    token->assignment = 0;
+    token->quoted = 0;
+    lexer->pos = pos;
+
+    size_t len = 1;
+    switch (in[pos]) {
+    case '\0':
+    case '#':
+        token->type = TOK_END;
+        return 0;
+    case '|':
+        token->type = in[pos + 1] == '|' ? TOK_OR : TOK_PIPE;
+        break;
+    case '&':
+        token->type = in[pos + 1] == '&' ? TOK_AND :
+                      in[pos + 1] == '>' ? TOK_ALL_GREAT : TOK_BACKGROUND;
+        break;
+    case ';':
+        token->type = TOK_SEMICOLON;
+        break;
+    case '<':
+        if (in[pos + 1] != '<') {
+            token->type = TOK_LESS;
+        } else if (in[pos + 2] == '<' || in[pos + 2] == '-') {
+            token->type = in[pos + 2] == '<' ? TOK_TLESS : TOK_DLESSDASH;
+            len = 3;
+        } else {
+            token->type = TOK_DLESS;
+            len = 2;
+        }
+        break;
+    case '>':
+        token->type = in[pos + 1] == '>' ? TOK_DGREAT : TOK_GREAT;
+        break;
+    case '2':
+        if (in[pos + 1] == '>') {
+            token->type = TOK_ERR_GREAT;
+            break;
+        }
+        return lex_word(lexer, token);
+    default:
+        return lex_word(lexer, token);
+    }
+
+    if (token->type == TOK_OR || token->type == TOK_AND || token->type == TOK_ALL_GREAT ||
+        token->type == TOK_DGREAT || token->type == TOK_ERR_GREAT) {
+        len = 2;
+    }
+    lexer->pos = pos + len;
+    return 0;
+}
+
+/**
+ * lexer_heredoc_word - Turn an expanding here-document body into a word.
+ * @arena: Arena that receives the word.
+ * @text: Body text, every line ending in a newline.
+ *
+ * The body is treated like the inside of double quotes, except that a
+ * double quote is an ordinary byte: $VAR and $(...) are expanded later,
+ * \$, \` and \\ lose their backslash and backslash-newline joins lines.
+ * Wildcards are marked so the result is never globbed.
+ * Returns: The word, or NULL after a syntax error (unterminated $().
+ */
+char *lexer_heredoc_word(arena_t *arena, const char *text) {
+    arena_str_t word;
+    arena_str_init(&word, arena);
+
+    size_t pos = 0;
+    for (;;) {
+        size_t run = strcspn(text + pos, "\\$*?[\001");
+        arena_str_append(&word, text + pos, run);
+        pos += run;
+
+        char c = text[pos];
+        if (c == '\0') {
+            break;
+        }
+        if (c == '\\') {
+            char next = text[pos + 1];
+            if (next == '$' || next == '`' || next == '\\') {
+                append_quoted(&word, next);
+                pos += 2;
+            } else if (next == '\n') {
+                pos += 2;  // Line continuation
+            } else {
+                arena_str_putc(&word, '\\');
+                pos++;
+            }
+        } else if (c == '$' && text[pos + 1] == '(') {
+            if (lex_cmdsub(text, &pos, &word) != 0) return NULL;
+        } else if (c == '$') {
+            arena_str_putc(&word, c);  // Expanded later
+            pos++;
+        } else {
+            append_quoted(&word, c);
+            pos++;
+        }
+    }
+    return word.data;
+}
+
+/**
+ * token_type_name - Get the source spelling of a token type.
+ * @type: Token type.
+ *
+ * Returns: Static string, "newline" for TOK_END.
+ */
+const char *token_type_name(token_type_t type) {
+    return token_names[type];
+}
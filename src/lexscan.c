@@ -0,0 +1,306 @@
+#include "lexscan.h"
+#include "lexer.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LEXSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Byte classes for the scalar kernel
+#define CLASS_UNQUOTED 0x01     // Ends an unquoted run
+#define CLASS_DQUOTED  0x02     // Ends a run inside double quotes
+#define CLASS_SQUOTED  0x04     // Ends a run inside single quotes
+
+static unsigned char byte_class[256];
+static int classes_ready = 0;
+
+typedef size_t (*scan_func_t)(const char *s, size_t len);
+
+static scan_func_t scan_unquoted = NULL;
+static scan_func_t scan_dquoted = NULL;
+static scan_func_t scan_squoted = NULL;
+static lexscan_impl_t current_impl = LEXSCAN_AUTO;
+
+// Helper: fill the scalar class table
+static void init_classes(void) {
+    static const char unquoted[] = " \t\n|&;<>'\"\\";
+    for (const char *p = unquoted; *p; p++) {
+        byte_class[(unsigned char)*p] |= CLASS_UNQUOTED;
+    }
+    byte_class[0] |= CLASS_UNQUOTED | CLASS_DQUOTED | CLASS_SQUOTED;
+    byte_class[(unsigned char)LEX_CTLESC] |= CLASS_UNQUOTED | CLASS_DQUOTED | CLASS_SQUOTED;
+    byte_class['"'] |= CLASS_DQUOTED;
+    byte_class['\\'] |= CLASS_DQUOTED;
+    byte_class['\''] |= CLASS_SQUOTED;
+    byte_class['$'] |= CLASS_SQUOTED;
+    classes_ready = 1;
+}
+
+// Helper: scalar scan for the first byte of class @mask
+static size_t scan_scalar(const char *s, size_t len, unsigned char mask) {
+    const unsigned char *p = (const unsigned char *)s;
+    for (size_t i = 0; i < len; i++) {
+        if (byte_class[p[i]] & mask) return i;
+    }
+    return len;
+}
+
+static size_t scan_unquoted_scalar(const char *s, size_t len) {
+    return scan_scalar(s, len, CLASS_UNQUOTED);
+}
+
+static size_t scan_dquoted_scalar(const char *s, size_t len) {
+    return scan_scalar(s, len, CLASS_DQUOTED);
+}
+
+static size_t scan_squoted_scalar(const char *s, size_t len) {
+    return scan_scalar(s, len, CLASS_SQUOTED);
+}
+
+#ifdef LEXSCAN_X86
+
+// SSE2 has no byte shuffle, so compare against each special byte and OR
+static size_t scan_unquoted_sse2(const char *s, size_t len) {
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n'), pipe = _mm_set1_epi8('|');
+    const __m128i amp = _mm_set1_epi8('&'), semi = _mm_set1_epi8(';');
+    const __m128i less = _mm_set1_epi8('<'), great = _mm_set1_epi8('>');
+    const __m128i squote = _mm_set1_epi8('\''), dquote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\'), nul = _mm_setzero_si128();
+    const __m128i ctlesc = _mm_set1_epi8(LEX_CTLESC);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, newline), _mm_cmpeq_epi8(v, pipe))),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, semi)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, less), _mm_cmpeq_epi8(v, great))));
+        hit = _mm_or_si128(hit, _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, squote), _mm_cmpeq_epi8(v, dquote)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, backslash),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, nul), _mm_cmpeq_epi8(v, ctlesc)))));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scan_unquoted_scalar(s + i, len - i);
+}
+
+// Helper: first occurrence of any of four bytes, 16 at a time
+static inline size_t scan_any4_sse2(const char *s, size_t len,
+                                    char b0, char b1, char b2, char b3) {
+    const __m128i v0 = _mm_set1_epi8(b0), v1 = _mm_set1_epi8(b1);
+    const __m128i v2 = _mm_set1_epi8(b2), v3 = _mm_set1_epi8(b3);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, v0), _mm_cmpeq_epi8(v, v1)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, v2), _mm_cmpeq_epi8(v, v3)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    for (; i < len; i++) {
+        if (s[i] == b0 || s[i] == b1 || s[i] == b2 || s[i] == b3) return i;
+    }
+    return len;
+}
+
+static size_t scan_dquoted_sse2(const char *s, size_t len) {
+    return scan_any4_sse2(s, len, '"', '\\', '\0', LEX_CTLESC);
+}
+
+static size_t scan_squoted_sse2(const char *s, size_t len) {
+    return scan_any4_sse2(s, len, '\'', '$', '\0', LEX_CTLESC);
+}
+
+// AVX2 classifies 32 bytes with two nibble lookups: a byte is special when
+// low_table[low nibble] & high_table[high nibble] is non-zero.
+//   high 0: NUL, marker, tab, newline (bit 0)   high 2: space " & ' (bit 1)
+//   high 3: ; < > (bit 2)                        high 5/7: \ | (bit 3)
+__attribute__((target("avx2")))
+static size_t scan_unquoted_avx2(const char *s, size_t len) {
+    const __m256i low_table = _mm256_setr_epi8(
+        3, 1, 2, 0, 0, 0, 2, 2, 0, 1, 1, 4, 12, 0, 4, 0,
+        3, 1, 2, 0, 0, 0, 2, 2, 0, 1, 1, 4, 12, 0, 4, 0);
+    const __m256i high_table = _mm256_setr_epi8(
+        1, 0, 2, 4, 0, 8, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0,
+        1, 0, 2, 4, 0, 8, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(v, nibble));
+        __m256i high = _mm256_shuffle_epi8(high_table,
+                                           _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        __m256i plain = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero);
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(plain);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scan_unquoted_sse2(s + i, len - i);
+}
+
+// Helper: first occurrence of any of four bytes, 32 at a time
+__attribute__((target("avx2")))
+static inline size_t scan_any4_avx2(const char *s, size_t len,
+                                    char b0, char b1, char b2, char b3) {
+    const __m256i v0 = _mm256_set1_epi8(b0), v1 = _mm256_set1_epi8(b1);
+    const __m256i v2 = _mm256_set1_epi8(b2), v3 = _mm256_set1_epi8(b3);
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, v0), _mm256_cmpeq_epi8(v, v1)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, v2), _mm256_cmpeq_epi8(v, v3)));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + scan_any4_sse2(s + i, len - i, b0, b1, b2, b3);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_dquoted_avx2(const char *s, size_t len) {
+    return scan_any4_avx2(s, len, '"', '\\', '\0', LEX_CTLESC);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_squoted_avx2(const char *s, size_t len) {
+    return scan_any4_avx2(s, len, '\'', '$', '\0', LEX_CTLESC);
+}
+
+#endif // LEXSCAN_X86
+
+// Helper: check whether the CPU can run a kernel
+static int impl_supported(lexscan_impl_t impl) {
+    switch (impl) {
+    case LEXSCAN_SCALAR:
+        return 1;
+#ifdef LEXSCAN_X86
+    case LEXSCAN_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case LEXSCAN_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+/**
+ * lexscan_set_impl - Select the classification kernel.
+ * @impl: Kernel, or LEXSCAN_AUTO for the best one the CPU supports.
+ *
+ * Every kernel returns the same offsets; only the speed differs.
+ * Returns: 0 on success, -1 if the kernel is not available.
+ */
+int lexscan_set_impl(lexscan_impl_t impl) {
+    if (!classes_ready) {
+        init_classes();
+    }
+
+    if (impl == LEXSCAN_AUTO) {
+        impl = impl_supported(LEXSCAN_AVX2) ? LEXSCAN_AVX2 :
+               impl_supported(LEXSCAN_SSE2) ? LEXSCAN_SSE2 : LEXSCAN_SCALAR;
+    }
+    if (!impl_supported(impl)) {
+        return -1;
+    }
+
+    switch (impl) {
+#ifdef LEXSCAN_X86
+    case LEXSCAN_AVX2:
+        scan_unquoted = scan_unquoted_avx2;
+        scan_dquoted = scan_dquoted_avx2;
+        scan_squoted = scan_squoted_avx2;
+        break;
+    case LEXSCAN_SSE2:
+        scan_unquoted = scan_unquoted_sse2;
+        scan_dquoted = scan_dquoted_sse2;
+        scan_squoted = scan_squoted_sse2;
+        break;
+#endif
+    default:
+        scan_unquoted = scan_unquoted_scalar;
+        scan_dquoted = scan_dquoted_scalar;
+        scan_squoted = scan_squoted_scalar;
+        break;
+    }
+    current_impl = impl;
+    return 0;
+}
+
+/**
+ * lexscan_get_impl - Get the kernel in use.
+ *
+ * Returns: Selected kernel (resolved from LEXSCAN_AUTO on first use).
+ */
+lexscan_impl_t lexscan_get_impl(void) {
+    if (!scan_unquoted) {
+        lexscan_set_impl(LEXSCAN_AUTO);
+    }
+    return current_impl;
+}
+
+/**
+ * lexscan_impl_name - Get the name of a kernel.
+ * @impl: Kernel.
+ *
+ * Returns: Static string.
+ */
+const char *lexscan_impl_name(lexscan_impl_t impl) {
+    static const char *names[] = { "auto", "scalar", "sse2", "avx2" };
+    return names[impl];
+}
+
+/**
+ * lexscan_unquoted - Find the end of a plain run in an unquoted word.
+ * @s: Start of the run.
+ * @len: Bytes available at @s.
+ *
+ * Returns: Offset of the first blank, operator, quote, backslash, NUL or
+ *          quote marker, or @len if there is none.
+ */
+size_t lexscan_unquoted(const char *s, size_t len) {
+    if (!scan_unquoted) {
+        lexscan_set_impl(LEXSCAN_AUTO);
+    }
+    return scan_unquoted(s, len);
+}
+
+/**
+ * lexscan_dquoted - Find the end of a plain run inside double quotes.
+ * @s: Start of the run.
+ * @len: Bytes available at @s.
+ *
+ * Returns: Offset of the first ", backslash, NUL or quote marker, or @len.
+ */
+size_t lexscan_dquoted(const char *s, size_t len) {
+    if (!scan_dquoted) {
+        lexscan_set_impl(LEXSCAN_AUTO);
+    }
+    return scan_dquoted(s, len);
+}
+
+/**
+ * lexscan_squoted - Find the end of a plain run inside single quotes.
+ * @s: Start of the run.
+ * @len: Bytes available at @s.
+ *
+ * $ ends the run because quoted $ must be marked for expansion.
+ * Returns: Offset of the first ', $, NUL or quote marker, or @len.
+ */
+size_t lexscan_squoted(const char *s, size_t len) {
+    if (!scan_squoted) {
+        lexscan_set_impl(LEXSCAN_AUTO);
+    }
+    return scan_squoted(s, len);
+}
@@ -5,71 +5,520 @@
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 #include <errno.h> // Required for errno
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
 
+#include "arena.h"
 #include "parser.h"
 #include "executor.h"
+#include "histindex.h"
+#include "histstore.h"
 #include "builtins.h"
+#include "complete.h"
+#include "input.h"
+#include "jobs.h"
+#include "launch.h"
+#include "options.h"
 #include "utils.h"
+#include "vars.h"
 
 #define PROMPT_COLOR "\001\033[1;36m\002"  // Cyan bold
 #define RESET_COLOR  "\001\033[0m\002"
 
-/**
- * handle_sigint - Signal handler for SIGINT (Ctrl+C).
- * @sig: Signal number.
- *
- * Resets the prompt line and redisplays it.
- */
-void handle_sigint(int sig) {
-    (void)sig;
+// Holds the parse tree and expansions of the line being executed
+static arena_t *line_arena = NULL;
+
+#define PROMPT PROMPT_COLOR "lemuen> " RESET_COLOR
+#define HEREDOC_PROMPT "> "
+#define MAX_EVENTS 16
+#define HISTORY_LOAD 1000   // Newest persistent entries given to readline
+#define HISTORY_INDEX_STEP 20000    // Entries indexed per idle turn of the loop
+#define HISTORY_MATCHES 64          // Matches Ctrl-R steps through
+#define HISTORY_QUERY_MAX 256
+
+// Interactive event loop state
+static int epoll_fd = -1;
+static int signal_fd = -1;
+static pid_t loop_pid = 0;          // Forked children must not touch epoll_fd
+static int input_done = 0;
+static int interactive_status = 0;
+
+// Helper: Ctrl+C at the prompt (read from the signalfd): drop the line
+// being edited and start a fresh prompt
+static void on_interrupt(void) {
     write(STDOUT_FILENO, "\n", 1);
     rl_on_new_line();
     rl_replace_line("", 0);
     rl_redisplay();
 }
 
-/**
- * handle_sigchld - Signal handler for SIGCHLD (Child process terminated).
- * @sig: Signal number.
- *
- * Cleans up background processes that have finished.
- */
-void handle_sigchld(int sig) {
-    (void)sig;
-    int saved_errno = errno;
-    while (waitpid(-1, NULL, WNOHANG) > 0) {}
-    errno = saved_errno;
+// Source of the input lines after a command line, for here-document
+// bodies; returns NULL at end of input
+typedef char *(*next_line_fn)(void *ctx);
+
+// Helper: parse and execute one input line; here-document bodies are
+// taken from @next_line
+// Returns: Status of the line, or @status unchanged for blank/comment lines.
+static int run_line(const char *line, int status, next_line_fn next_line, void *ctx) {
+    jobs_reap();  // Record background jobs that finished meanwhile
+    // Blank and comment lines (including a #! line) parse to nothing
+    int syntax_error;
+    sequence_t *seq = parse_line(line_arena, line, &syntax_error);
+    while (parse_heredoc_pending(seq)) {
+        if (parse_heredoc_line(seq, next_line(ctx)) != 0) {
+            seq = NULL;
+            syntax_error = 1;
+        }
+    }
+    if (seq) {
+        // Execute the whole tree (sequences, and-or lists, pipelines)
+        status = execute_sequence(seq);
+    } else if (syntax_error) {
+        status = 2;
+    }
+    arena_reset(line_arena);  // Drop the tree and expansions in one step
+    return status;
+}
+
+// Helper: next_line_fn reading from an input_reader_t
+static char *next_reader_line(void *ctx) {
+    return input_next_line(ctx, NULL);
+}
+
+// Helper: next_line_fn prompting with readline; @ctx holds the previous
+// line, which is freed here (the caller frees the last one)
+static char *next_readline_line(void *ctx) {
+    char **line = ctx;
+    free(*line);
+    *line = readline(HEREDOC_PROMPT);
+    return *line;
+}
+
+// Helper: run every line of a non-interactive input without readline
+static int run_batch(input_reader_t *reader) {
+    int status = 0;
+    char *line;
+    while ((line = input_next_line(reader, NULL)) != NULL) {
+        status = run_line(line, status, next_reader_line, reader);
+    }
+    input_close(reader);
+    return status;
+}
+
+// Helper: put the shell in its own process group in the terminal's
+// foreground, so jobs can be given the terminal and taken back
+static void init_job_control(void) {
+    // Started in the background: wait until we are brought to the foreground
+    pid_t pgrp;
+    while ((pgrp = tcgetpgrp(STDIN_FILENO)) != -1 && pgrp != getpgrp()) {
+        kill(-getpgrp(), SIGTTIN);
+    }
+
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    // Needed to take the terminal back from a foreground job
+    signal(SIGTTOU, SIG_IGN);
+
+    pid_t shell_pgid = getpid();
+    if (getpgrp() != shell_pgid && setpgid(0, shell_pgid) == -1) {
+        print_system_error("failed to create process group");
+        return;
+    }
+    tcsetpgrp(STDIN_FILENO, shell_pgid);
+}
+
+// Helper: add or remove a background process's pidfd in the event loop
+static void watch_pidfd(int fd, int watch) {
+    if (epoll_fd < 0 || getpid() != loop_pid) return;
+    if (watch) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    } else {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    }
+}
+
+// Helper: collect finished children and report background jobs above the
+// line being edited, then redraw it
+static void report_jobs(int editing) {
+    jobs_reap();
+    if (!jobs_have_changes()) return;
+    if (editing) rl_clear_visible_line();
+    jobs_notify();
+    if (editing) rl_forced_update_display();
+}
+
+// Helper: run an interactive line and record it, with its start time,
+// status and working directory, in the persistent history
+static void run_interactive_line(char *line) {
+    char cwd[PATH_MAX];
+    time_t started = time(NULL);
+
+    if (*line) add_history(line);
+    if (!getcwd(cwd, sizeof(cwd))) cwd[0] = '\0';
+    // The callback handler is removed while a line runs, so here-document
+    // lines can be read with plain readline()
+    char *body_line = NULL;
+    interactive_status = run_line(line, interactive_status, next_readline_line, &body_line);
+    free(body_line);
+    if (!is_empty_command(line)) {
+        histstore_append(line, started, interactive_status, cwd);
+    }
+}
+
+// Helper: open the history file and give its newest entries to readline
+static void load_history(void) {
+    if (histstore_open(histstore_default_path()) != 0) {
+        return;
+    }
+    size_t total = histstore_count();
+    size_t first = total > HISTORY_LOAD ? total - HISTORY_LOAD : 0;
+    hist_entry_t entry;
+    for (size_t i = first; i < total; i++) {
+        if (histstore_get(i, &entry) == 0) {
+            add_history(entry.line);
+        }
+    }
+}
+
+// Helper: readline callback for a complete line (NULL at end of input).
+// The terminal is given back to cooked mode while the line runs.
+static void on_line(char *line) {
+    rl_callback_handler_remove();
+    if (!line) {
+        input_done = 1;
+        return;
+    }
+    run_interactive_line(line);
+    free(line);
+
+    report_jobs(0);
+    rl_callback_handler_install(PROMPT, on_line);
+}
+
+// Helper: drain the signalfd and act on each signal in loop context.
+// Returns: 1 if SIGINT was among them (the caller decides what it ends).
+static int on_signals(void) {
+    struct signalfd_siginfo info;
+    int children = 0;
+    int interrupted = 0;
+
+    while (read(signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        switch (info.ssi_signo) {
+        case SIGINT:
+            interrupted = 1;
+            break;
+        case SIGWINCH:
+            rl_resize_terminal();
+            break;
+        case SIGCHLD:
+            children = 1;
+            break;
+        }
+    }
+    if (children) {
+        report_jobs(1);
+    }
+    return interrupted;
+}
+
+// Helper: wait for the next key of a history search, serving signals
+// meanwhile. Returns: The key, or -1 on Ctrl+C or end of input.
+static int read_search_key(void) {
+    if (signal_fd >= 0 && !rl_pending_input) {
+        struct pollfd fds[2];
+        fds[0].fd = fileno(rl_instream);
+        fds[0].events = POLLIN;
+        fds[1].fd = signal_fd;
+        fds[1].events = POLLIN;
+        for (;;) {
+            if (poll(fds, 2, -1) == -1) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            if ((fds[1].revents & POLLIN) && on_signals()) {
+                return -1;
+            }
+            if (fds[0].revents) break;
+        }
+    }
+    int key = rl_read_key();
+    return key == EOF ? -1 : key;
+}
+
+// Helper: show match @current of a history search in the line buffer, with
+// the cursor where the query occurs
+static void show_search_match(const size_t *matches, int current, const char *query) {
+    hist_entry_t entry;
+    if (histstore_get(matches[current], &entry) != 0) return;
+    rl_replace_line(entry.line, 0);
+    const char *at = strstr(entry.line, query);
+    rl_point = at ? (int)(at - entry.line) : 0;
+}
+
+// Helper: Ctrl-R. Incremental search over the whole history file through
+// its trigram index, best match by recency and frequency first; Ctrl-R
+// again steps to the next one. Enter runs the match, Ctrl-G or Ctrl+C
+// restores the line, and any other key starts editing the match.
+static int lemuen_history_search(int count, int key) {
+    histstore_refresh();
+    if (histstore_count() == 0) {
+        return rl_reverse_search_history(count, key);  // No history file
+    }
+
+    char query[HISTORY_QUERY_MAX];
+    size_t len = 0;
+    size_t matches[HISTORY_MATCHES];
+    int found = 0, current = 0;
+    char *saved_line = strdup_safe(rl_line_buffer);
+    int saved_point = rl_point;
+    int accept = 0, interrupted = 0;
+
+    query[0] = '\0';
+    rl_save_prompt();
+    for (;;) {
+        rl_message("(%sreverse-i-search)`%s': ", len > 0 && found == 0 ? "failed " : "", query);
+        int c = read_search_key();
+        if (c == -1 || c == CTRL('G')) {
+            interrupted = c == -1;
+            rl_replace_line(saved_line, 0);
+            rl_point = saved_point;
+            break;
+        } else if (c == CTRL('R')) {
+            if (found > 0) {
+                current = (current + 1) % found;
+                show_search_match(matches, current, query);
+            }
+            continue;
+        } else if (c == RUBOUT || c == CTRL('H')) {
+            if (len == 0) continue;
+            query[--len] = '\0';
+        } else if (c >= ' ' && len + 1 < sizeof(query)) {
+            query[len++] = (char)c;
+            query[len] = '\0';
+        } else {
+            // Enter runs the match; anything else edits it
+            if (c == NEWLINE || c == RETURN) {
+                accept = 1;
+            } else {
+                rl_execute_next(c);
+            }
+            break;
+        }
+
+        found = len > 0 ? histindex_search(query, matches, HISTORY_MATCHES) : 0;
+        current = 0;
+        if (found > 0) {
+            show_search_match(matches, current, query);
+        } else if (len == 0) {
+            rl_replace_line(saved_line, 0);
+            rl_point = saved_point;
+        }
+    }
+    rl_restore_prompt();
+    rl_clear_message();
+    free(saved_line);
+
+    if (interrupted) {
+        on_interrupt();
+    } else if (accept) {
+        return rl_newline(1, key);
+    }
+    return 0;
+}
+
+// Helper: set up epoll over stdin and a signalfd for SIGINT/SIGCHLD/SIGWINCH.
+// Returns: 0, or -1 if the event loop is unavailable.
+static int init_event_loop(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGWINCH);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+        print_system_error("epoll_create1 failed");
+        return -1;
+    }
+    // Blocked signals are only seen through the signalfd; children start
+    // with an empty mask (see setup_child_signal_handlers)
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    signal_fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    if (signal_fd == -1) {
+        print_system_error("signalfd failed");
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+        close(epoll_fd);
+        epoll_fd = -1;
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = STDIN_FILENO;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &ev);
+    ev.data.fd = signal_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev);
+
+    loop_pid = getpid();
+    jobs_set_watch(watch_pidfd);
+    return 0;
 }
 
+// Helper: the interactive loop. Readline is driven through its callback
+// interface from epoll, so finished jobs and signals are handled as they
+// happen instead of at the next keystroke, and no signal handler does
+// any work.
+static int run_interactive(void) {
+    init_job_control();
+
+    using_history();
+    load_history();
+    complete_init();
+    rl_catch_signals = 0;
+    rl_catch_sigwinch = 0;
+    rl_bind_key(CTRL('R'), lemuen_history_search);
+
+    if (init_event_loop() != 0) {
+        print_error("falling back to blocking readline");
+        char *line;
+        while ((line = readline(PROMPT)) != NULL) {
+            run_interactive_line(line);
+            free(line);
+            report_jobs(0);
+        }
+    } else {
+        struct epoll_event events[MAX_EVENTS];
+        int indexing = 1;
+        rl_callback_handler_install(PROMPT, on_line);
+        while (!input_done) {
+            // While the search index is behind, build it in slices between
+            // keystrokes instead of on the first Ctrl-R
+            int n = epoll_wait(epoll_fd, events, MAX_EVENTS, indexing ? 0 : -1);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                print_system_error("epoll_wait failed");
+                break;
+            }
+            if (n == 0) {
+                indexing = histindex_update(HISTORY_INDEX_STEP);
+                continue;
+            }
+            int children = 0;
+            for (int i = 0; i < n && !input_done; i++) {
+                int fd = events[i].data.fd;
+                if (fd == STDIN_FILENO) {
+                    rl_callback_read_char();
+                } else if (fd == signal_fd) {
+                    if (on_signals()) on_interrupt();
+                } else {
+                    children = 1;  // A background process's pidfd
+                }
+            }
+            if (children && !input_done) {
+                report_jobs(1);
+            }
+        }
+        rl_callback_handler_remove();
+        jobs_set_watch(NULL);
+    }
+
+    printf("\nBye from Lemuen Shell!\n");
+    return interactive_status;
+}
+
+#ifdef DEBUG
+static pid_t shell_pid = 0;
+
+// Helper: report the per-line arena's peak usage at exit (debug builds).
+// Forked children (pipeline builtins, $(...) subshells) stay quiet.
+static void report_arena_usage(void) {
+    if (line_arena && getpid() == shell_pid) {
+        fprintf(stderr, "lemuen: line arena high-water mark: %zu bytes\n",
+                arena_high_water(line_arena));
+    }
+}
+#endif
+
 /**
  * main - Entry point for Lemuen Shell.
+ * @argc: Argument count.
+ * @argv: `lemuen`, `lemuen script`, or `lemuen -c 'commands'`.
  *
- * Initializes signal handling, readline, and runs the main shell loop.
- * Returns: Exit status code.
+ * Runs the readline loop when stdin is a terminal and no script or -c
+ * string is given; otherwise reads commands through a buffered reader.
+ * Returns: Exit status of the last command.
  */
-int main() {
-    signal(SIGINT, handle_sigint);
-    signal(SIGCHLD, handle_sigchld);
+int main(int argc, char *argv[]) {
+    jobs_init();
+    vars_init(environ);
+    line_arena = arena_create(0);
+#ifdef DEBUG
+    shell_pid = getpid();
+    atexit(report_arena_usage);
+#endif
 
-    using_history();
+    // LEMUEN_LAUNCH=fork selects the fork+exec fallback backend
+    const char *backend = getenv("LEMUEN_LAUNCH");
+    if (backend && launch_set_backend_by_name(backend) != 0) {
+        print_error("unknown LEMUEN_LAUNCH backend '%s', using %s",
+                    backend, launch_backend_name(launch_get_backend()));
+    }
 
-    char *line;
-    while ((line = readline(PROMPT_COLOR "lemuen> " RESET_COLOR)) != NULL) {
-        if (*line) add_history(line);
-
-        command_t *cmd = parse_command(line);
-        if (cmd) {
-            // Execute command (handles chaining, logical operators, etc.)
-            execute_command(cmd);
-            free_command(cmd);
+    input_reader_t *reader = NULL;
+    int script_fd = -1;
+    if (argc >= 2 && strcmp(argv[1], "-c") == 0) {
+        if (argc < 3) {
+            print_error("-c: option requires an argument");
+            return 2;
         }
-        free(line);
+        reader = input_open_string(argv[2]);
+    } else if (argc >= 2) {
+        script_fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+        if (script_fd == -1) {
+            print_error("%s: %s", argv[1], strerror(errno));
+            return 127;
+        }
+        reader = input_open_fd(script_fd, 0);
+    } else if (!isatty(STDIN_FILENO)) {
+        reader = input_open_fd(STDIN_FILENO, 1);
     }
 
-    printf("\nBye from Lemuen Shell!\n");
+    int status;
+    if (reader) {
+        status = run_batch(reader);
+    } else if (argc >= 2 || !isatty(STDIN_FILENO)) {
+        print_error("failed to allocate input buffer");
+        status = 1;
+    } else {
+        shell_set_interactive(1);
+        status = run_interactive();
+    }
+
+    if (script_fd != -1) {
+        close(script_fd);
+    }
     cleanup_find_command_cache();
-    return 0;
+    jobs_destroy();
+    complete_destroy();
+    histindex_destroy();
+    histstore_close();
+    vars_destroy();
+#ifndef DEBUG
+    arena_destroy(line_arena);
+    line_arena = NULL;
+#endif
+    return status;
 }
@@ -0,0 +1,82 @@
+#include "options.h"
+#include "outbuf.h"
+#include <stdio.h>
+#include <string.h>
+
+// Option table, indexed by shell_option_id_t
+typedef struct {
+    const char *name;
+    int value;
+} shell_option_t;
+
+static shell_option_t options[OPT_COUNT] = {
+    [OPT_PIPEFAIL] = {"pipefail", 0},
+    [OPT_LASTPIPE] = {"lastpipe", 1},
+};
+
+static int interactive = 0;
+
+/**
+ * shell_option - Get the value of a shell option.
+ * @id: Option identifier.
+ *
+ * Returns: 1 if enabled, 0 otherwise.
+ */
+int shell_option(shell_option_id_t id) {
+    if (id < 0 || id >= OPT_COUNT) return 0;
+    return options[id].value;
+}
+
+/**
+ * shell_option_set - Enable or disable a shell option.
+ * @id: Option identifier.
+ * @value: Non-zero to enable.
+ */
+void shell_option_set(shell_option_id_t id, int value) {
+    if (id < 0 || id >= OPT_COUNT) return;
+    options[id].value = value != 0;
+}
+
+/**
+ * shell_option_set_by_name - Enable or disable a shell option by name.
+ * @name: Option name.
+ * @value: Non-zero to enable.
+ *
+ * Returns: 0 on success, -1 if the option does not exist.
+ */
+int shell_option_set_by_name(const char *name, int value) {
+    if (!name) return -1;
+    for (int i = 0; i < OPT_COUNT; i++) {
+        if (strcmp(name, options[i].name) == 0) {
+            options[i].value = value != 0;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * shell_options_print - Print every option with its current value.
+ */
+void shell_options_print(void) {
+    for (int i = 0; i < OPT_COUNT; i++) {
+        outbuf_printf("%-15s %s\n", options[i].name, options[i].value ? "on" : "off");
+    }
+}
+
+/**
+ * shell_is_interactive - Check whether the shell reads from a terminal.
+ *
+ * Returns: 1 for the readline loop, 0 for scripts, -c and piped input.
+ */
+int shell_is_interactive(void) {
+    return interactive;
+}
+
+/**
+ * shell_set_interactive - Record the shell's input mode.
+ * @value: Non-zero for interactive.
+ */
+void shell_set_interactive(int value) {
+    interactive = value != 0;
+}
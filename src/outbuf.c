@@ -0,0 +1,200 @@
+#define _GNU_SOURCE
+#include "outbuf.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/uio.h>
+
+// Large enough that a long listing or echo needs one write
+#define OUTBUF_SIZE (64 * 1024)
+#define CAPTURE_INITIAL_SIZE 4096
+
+static char buffer[OUTBUF_SIZE];
+static size_t used = 0;
+static int line_buffered = -1;      // Stdout is a terminal; -1 until checked
+static int write_errno = 0;         // First error since the last flush
+
+// Output of a builtin run for $(...): kept in memory instead of written
+static int capturing = 0;
+static char *capture = NULL;
+static size_t capture_len = 0;
+static size_t capture_cap = 0;
+
+// Helper: append @count iovecs to the capture buffer, doubling it as needed
+static void capture_all(const struct iovec *iov, int count) {
+    for (int i = 0; i < count; i++) {
+        if (iov[i].iov_len > capture_cap - capture_len) {
+            size_t cap = capture_cap ? capture_cap : CAPTURE_INITIAL_SIZE;
+            while (cap - capture_len < iov[i].iov_len) cap *= 2;
+            char *grown = realloc(capture, cap);
+            if (!grown) {
+                if (!write_errno) write_errno = ENOMEM;
+                return;
+            }
+            capture = grown;
+            capture_cap = cap;
+        }
+        memcpy(capture + capture_len, iov[i].iov_base, iov[i].iov_len);
+        capture_len += iov[i].iov_len;
+    }
+}
+
+// Helper: write @count iovecs to stdout, resuming after partial writes
+static void write_all(struct iovec *iov, int count) {
+    if (capturing) {
+        capture_all(iov, count);
+        return;
+    }
+    while (count > 0) {
+        ssize_t n = writev(STDOUT_FILENO, iov, count);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            if (!write_errno) write_errno = errno;
+            return;
+        }
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+}
+
+// Helper: check (once per stdout binding) whether lines go out at once
+static int is_line_buffered(void) {
+    if (line_buffered < 0) {
+        line_buffered = isatty(STDOUT_FILENO);
+    }
+    return line_buffered;
+}
+
+/**
+ * outbuf_write - Append bytes to the builtin output buffer.
+ * @data: Bytes to write.
+ * @len: Number of bytes.
+ *
+ * Data that does not fit is written together with what is buffered in a
+ * single writev, without being copied.
+ */
+void outbuf_write(const char *data, size_t len) {
+    if (len <= OUTBUF_SIZE - used) {
+        memcpy(buffer + used, data, len);
+        used += len;
+    } else {
+        struct iovec iov[2] = { { buffer, used }, { (void *)data, len } };
+        write_all(used > 0 ? iov : iov + 1, used > 0 ? 2 : 1);
+        used = 0;
+    }
+    if (used > 0 && is_line_buffered() && memchr(data, '\n', len)) {
+        outbuf_flush();
+    }
+}
+
+/**
+ * outbuf_puts - Append a string to the builtin output buffer.
+ * @str: String to write.
+ */
+void outbuf_puts(const char *str) {
+    outbuf_write(str, strlen(str));
+}
+
+/**
+ * outbuf_printf - Append formatted text to the builtin output buffer.
+ * @format: printf-style format string.
+ * @...: Arguments.
+ *
+ * Formats straight into the free space; only text longer than the whole
+ * buffer goes through a temporary allocation.
+ */
+void outbuf_printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer + used, OUTBUF_SIZE - used, format, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+
+    if ((size_t)len < OUTBUF_SIZE - used) {
+        // Fitted in place; go through outbuf_write's bookkeeping
+        used += (size_t)len;
+        if (is_line_buffered() && memchr(buffer + used - len, '\n', (size_t)len)) {
+            outbuf_flush();
+        }
+        return;
+    }
+
+    char *text = NULL;
+    va_start(args, format);
+    len = vasprintf(&text, format, args);
+    va_end(args);
+    if (len >= 0) {
+        outbuf_write(text, (size_t)len);
+        free(text);
+    }
+}
+
+/**
+ * outbuf_flush - Write out the builtin output buffer.
+ *
+ * Returns: 0 on success, -1 with errno set if any write since the last
+ *          flush failed.
+ */
+int outbuf_flush(void) {
+    if (used > 0) {
+        struct iovec iov = { buffer, used };
+        write_all(&iov, 1);
+        used = 0;
+    }
+    if (write_errno) {
+        errno = write_errno;
+        write_errno = 0;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * outbuf_retarget - Note that stdout was rebound.
+ *
+ * Anything buffered belongs to the old file and must have been flushed.
+ */
+void outbuf_retarget(void) {
+    line_buffered = -1;
+}
+
+/**
+ * outbuf_capture_begin - Collect builtin output in memory.
+ *
+ * Whatever was buffered before is written to stdout first. Until
+ * outbuf_capture_end, flushes append to a heap buffer that is reused from
+ * one capture to the next.
+ */
+void outbuf_capture_begin(void) {
+    outbuf_flush();
+    capturing = 1;
+    capture_len = 0;
+    line_buffered = 0;
+}
+
+/**
+ * outbuf_capture_end - Stop collecting builtin output.
+ * @len: Receives the number of bytes captured.
+ *
+ * Returns: The captured bytes (not NUL-terminated), valid until the next
+ *          capture starts.
+ */
+const char *outbuf_capture_end(size_t *len) {
+    outbuf_flush();
+    capturing = 0;
+    line_buffered = -1;
+    *len = capture_len;
+    return capture;
+}
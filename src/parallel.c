@@ -0,0 +1,274 @@
+#define _GNU_SOURCE
+#include "parallel.h"
+#include "executor.h"
+#include "jobs.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#define PARALLEL_MAX_FAILURES 101
+#define PARALLEL_COPY_BUFFER 65536
+// With keep_order, how many inputs per worker may start ahead of the
+// oldest one not printed yet (each holds an open memfd until printed)
+#define PARALLEL_LOOKAHEAD 4
+
+// Output of a finished job not printed yet (keep_order)
+#define OUTPUT_PENDING -1   // Job not finished
+#define OUTPUT_NONE    -2   // Finished, nothing buffered
+
+// One slot of the worker pool
+typedef struct {
+    job_t *job;         // NULL when idle
+    int input;          // Index of the input being run
+    int out_fd;         // Output buffer, or -1
+} parallel_worker_t;
+
+/**
+ * parallel_default_workers - Get the default number of workers.
+ *
+ * Returns: Number of online CPUs, at least 1.
+ */
+int parallel_default_workers(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+// Helper: replace every {} in @word with @input.
+// Returns: Newly allocated string, or NULL if @word has no {}.
+static char *substitute(const char *word, const char *input) {
+    const char *mark = strstr(word, "{}");
+    if (!mark) {
+        return NULL;
+    }
+
+    size_t input_len = strlen(input);
+    size_t len = 0;
+    for (const char *p = word; *p; ) {
+        if (p[0] == '{' && p[1] == '}') {
+            len += input_len;
+            p += 2;
+        } else {
+            len++;
+            p++;
+        }
+    }
+
+    char *result = malloc(len + 1);
+    if (!result) {
+        return NULL;
+    }
+    char *out = result;
+    for (const char *p = word; *p; ) {
+        if (p[0] == '{' && p[1] == '}') {
+            memcpy(out, input, input_len);
+            out += input_len;
+            p += 2;
+        } else {
+            *out++ = *p++;
+        }
+    }
+    *out = '\0';
+    return result;
+}
+
+// Helper: build the argument vector for one input. Substituted words are
+// allocated; the rest point into @template.
+// Returns: NULL-terminated vector (free with free_args), or NULL.
+static char **build_args(char *const *template, int count, const char *input,
+                         int *argc, char *owned[]) {
+    int used = 0;
+    char **args = malloc((count + 2) * sizeof(char *));
+    if (!args) {
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        owned[i] = substitute(template[i], input);
+        if (owned[i]) used = 1;
+        args[i] = owned[i] ? owned[i] : template[i];
+    }
+    *argc = count;
+    if (!used) {
+        // No {} anywhere: the input becomes the last argument
+        args[(*argc)++] = (char *)input;
+    }
+    args[*argc] = NULL;
+    return args;
+}
+
+// Helper: free what build_args allocated
+static void free_args(char **args, char *owned[], int count) {
+    for (int i = 0; i < count; i++) {
+        free(owned[i]);
+    }
+    free(args);
+}
+
+// Helper: copy a finished job's buffered output to stdout and close it
+static void flush_output(int fd) {
+    static char buffer[PARALLEL_COPY_BUFFER];
+    ssize_t n;
+
+    if (fd < 0) return;
+    if (lseek(fd, 0, SEEK_SET) == 0) {
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            ssize_t done = 0;
+            while (done < n) {
+                ssize_t written = write(STDOUT_FILENO, buffer + done, n - done);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) {
+                    close(fd);
+                    return;
+                }
+                done += written;
+            }
+        }
+    }
+    close(fd);
+}
+
+// Helper: start the job for one input on a worker.
+// Returns: 0 if started, otherwise the failure status.
+static int start_worker(parallel_worker_t *worker, char *const *template, int count,
+                        const char *input, int index, int keep_order) {
+    char *owned[count > 0 ? count : 1];
+    int argc;
+    int status = 1;
+
+    worker->input = index;
+    worker->out_fd = -1;
+    worker->job = NULL;
+
+    char **args = build_args(template, count, input, &argc, owned);
+    if (!args) {
+        print_error("parallel: out of memory");
+        return 1;
+    }
+    if (keep_order) {
+        worker->out_fd = memfd_create("parallel", MFD_CLOEXEC);
+        if (worker->out_fd == -1) {
+            // Output would go out of order: fail the job instead
+            print_system_error("parallel: cannot buffer output");
+            free_args(args, owned, count);
+            return 1;
+        }
+    }
+
+    command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.args = args;
+    cmd.argc = argc;
+    worker->job = execute_async(&cmd, worker->out_fd, -1, &status);
+    free_args(args, owned, count);
+    return worker->job ? 0 : status;
+}
+
+/**
+ * parallel_run - Run a command template over a list of inputs.
+ * @template: Command words; {} in any word is replaced by the input.
+ * @template_count: Number of words.
+ * @inputs: Inputs, one job each, started in order.
+ * @input_count: Number of inputs.
+ * @opts: Worker count and output ordering.
+ *
+ * Keeps at most opts->workers children running, starting the next input
+ * whenever one finishes. Children are started through the executor, so
+ * hashed command lookup and the spawn backend apply to every job. With
+ * keep_order each job writes to its own memfd, which is copied to stdout
+ * once every earlier job has been printed; otherwise jobs share stdout.
+ * A slow job holds back new ones once PARALLEL_LOOKAHEAD inputs per
+ * worker are waiting behind it, which bounds the open buffers.
+ * Returns: 0 if every job succeeded, else the number of failed jobs (at
+ *          most 101).
+ */
+int parallel_run(char *const *template, int template_count,
+                 char *const *inputs, int input_count, const parallel_opts_t *opts) {
+    int workers = opts->workers > 0 ? opts->workers : parallel_default_workers();
+    if (workers > input_count) {
+        workers = input_count;
+    }
+    if (workers <= 0) {
+        return 0;
+    }
+
+    parallel_worker_t *pool = calloc(workers, sizeof(parallel_worker_t));
+    int *outputs = NULL;
+    if (opts->keep_order) {
+        outputs = malloc(input_count * sizeof(int));
+    }
+    if (!pool || (opts->keep_order && !outputs)) {
+        print_error("parallel: out of memory");
+        free(pool);
+        free(outputs);
+        return 1;
+    }
+    for (int i = 0; opts->keep_order && i < input_count; i++) {
+        outputs[i] = OUTPUT_PENDING;
+    }
+
+    int next_input = 0;
+    int next_output = 0;
+    int running = 0;
+    int failed = 0;
+    int window = workers * PARALLEL_LOOKAHEAD;
+
+    while (next_input < input_count || running > 0) {
+        // Print every finished job that is next in input order
+        while (outputs && next_output < input_count && outputs[next_output] != OUTPUT_PENDING) {
+            flush_output(outputs[next_output]);
+            outputs[next_output++] = OUTPUT_NONE;
+        }
+
+        // Fill idle workers from the queue
+        for (int w = 0; w < workers && next_input < input_count &&
+                        (!outputs || next_input - next_output < window); w++) {
+            parallel_worker_t *worker = &pool[w];
+            if (worker->job) continue;
+
+            int index = next_input++;
+            int status = start_worker(worker, template, template_count,
+                                      inputs[index], index, opts->keep_order);
+            if (worker->job) {
+                running++;
+                continue;
+            }
+            // Could not start: counts as a failed job with no output
+            if (status != 0) failed++;
+            if (outputs) {
+                if (worker->out_fd >= 0) close(worker->out_fd);
+                outputs[index] = OUTPUT_NONE;
+            }
+            w--;  // Try the next input on the same worker
+        }
+        if (running == 0) {
+            continue;
+        }
+
+        int lost = jobs_wait_event() != 0;
+        for (int w = 0; w < workers; w++) {
+            parallel_worker_t *worker = &pool[w];
+            job_t *job = worker->job;
+            if (!job || (!lost && (job->running > 0 || job->stopped > 0))) {
+                continue;
+            }
+            if (jobs_wait(job, NULL) != 0) {
+                failed++;
+            }
+            worker->job = NULL;
+            running--;
+            if (outputs) {
+                outputs[worker->input] = worker->out_fd >= 0 ? worker->out_fd : OUTPUT_NONE;
+            }
+        }
+    }
+    while (outputs && next_output < input_count) {
+        flush_output(outputs[next_output++]);
+    }
+
+    free(pool);
+    free(outputs);
+    return failed > PARALLEL_MAX_FAILURES ? PARALLEL_MAX_FAILURES : failed;
+}
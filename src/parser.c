@@ -1,311 +1,286 @@
-#define _GNU_SOURCE
 #include "parser.h"
+#include "arena.h"
+#include "lexer.h"
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-/**
- * parse_command - Parse a command line string into a command_t structure.
- * @line: Input command line.
- *
- * Handles logical operators, pipelines, redirection, background, and argument splitting.
- * Returns: Pointer to parsed command_t, or NULL on error.
- */
-// Helper: parse redirection in-place, set fields and null-terminate
-static void parse_redirection(char *cmd_str, command_t *cmd) {
-    // Output append (>>)
-    char *append_redir = strstr(cmd_str, ">>");
-    if (append_redir) {
-        *append_redir = '\0';
-        append_redir += 2;
-        while (*append_redir == ' ' || *append_redir == '\t') append_redir++;
-        cmd->output_redirect = strdup_safe(append_redir);
-        cmd->append_output = 1;
-    } else {
-        // Output overwrite (>), but not >>
-        char *output_redir = strchr(cmd_str, '>');
-        if (output_redir) {
-            *output_redir = '\0';
-            output_redir++;
-            while (*output_redir == ' ' || *output_redir == '\t') output_redir++;
-            cmd->output_redirect = strdup_safe(output_redir);
-            cmd->append_output = 0;
-        }
-    }
-    // Input (<)
-    char *input_redir = strchr(cmd_str, '<');
-    if (input_redir) {
-        *input_redir = '\0';
-        input_redir++;
-        while (*input_redir == ' ' || *input_redir == '\t') input_redir++;
-        cmd->input_redirect = strdup_safe(input_redir);
-    }
+// Helper: report a syntax error at a token
+static sequence_t *syntax_error_at(const token_t *token, int *syntax_error) {
+    print_error("syntax error near unexpected token `%s' (column %zu)",
+                token_type_name(token->type), token->offset + 1);
+    if (syntax_error) *syntax_error = 1;
+    return NULL;
 }
 
-// Helper: parse background (&) in-place
-static void parse_background(char *cmd_str, command_t *cmd) {
-    size_t len = strlen(cmd_str);
-    if (len > 0 && cmd_str[len-1] == '&') {
-        cmd->background = 1;
-        cmd_str[len-1] = '\0';
-        // Remove trailing whitespace
-        trim(cmd_str);
+// Helper: append a word to a growing NULL-terminated word array
+static void append_word(arena_t *arena, char ***words, int *count, int *capacity, char *word) {
+    if (*count + 2 > *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 8;
+        *words = arena_realloc(arena, *words, *capacity * sizeof(char *),
+                               new_capacity * sizeof(char *));
+        *capacity = new_capacity;
     }
+    (*words)[(*count)++] = word;
+    (*words)[*count] = NULL;
 }
 
-// Helper: parse arguments in-place
-static void parse_args(char *cmd_str, command_t *cmd) {
-    trim(cmd_str);
-    if (strlen(cmd_str) > 0) {
-        int arg_count;
-        char **args = split_string(cmd_str, " \t", &arg_count);
-        if (args) {
-            cmd->args = args;
-            cmd->argc = arg_count;
-        }
-    } else {
-        cmd->args = NULL;
-        cmd->argc = 0;
+// Helper: map a redirection token to its type and default descriptor.
+// Returns: 1 for a redirection operator, 0 otherwise.
+static int redirect_for_token(token_type_t type, redirect_type_t *redir, int *fd) {
+    switch (type) {
+    case TOK_LESS:      *redir = REDIR_INPUT;      *fd = 0; return 1;
+    case TOK_GREAT:     *redir = REDIR_OUTPUT;     *fd = 1; return 1;
+    case TOK_DGREAT:    *redir = REDIR_APPEND;     *fd = 1; return 1;
+    case TOK_ERR_GREAT: *redir = REDIR_OUTPUT;     *fd = 2; return 1;
+    case TOK_ALL_GREAT: *redir = REDIR_OUTPUT_ALL; *fd = 1; return 1;
+    case TOK_DLESS:
+    case TOK_DLESSDASH: *redir = REDIR_HEREDOC;    *fd = 0; return 1;
+    case TOK_TLESS:     *redir = REDIR_HERESTRING; *fd = 0; return 1;
+    default:            return 0;
     }
 }
 
-command_t *parse_command(const char *line) {
-    if (!line || is_empty_command(line)) {
-        return NULL;
+// Helper: set up a here-document redirection from the << or <<- token
+// @op and the delimiter word in @token, and queue it for its body
+static void start_heredoc(redirect_t *redirect, token_type_t op, const token_t *token,
+                          redirect_t ***heredoc_tail) {
+    // The delimiter is matched after quote removal; quoting any part of it
+    // keeps the body literal
+    char *delim = token->word;
+    size_t len = 0;
+    for (const char *p = token->word; *p; p++) {
+        if (*p != LEX_CTLESC) delim[len++] = *p;
     }
-    // Work on a single buffer for the whole function
-    char *buffer = strdup_safe(line);
-    trim(buffer);
-    // Check for logical operators (&&, ||)
-    char *and_op = strstr(buffer, "&&");
-    char *or_op = strstr(buffer, "||");
-    if (and_op || or_op) {
-        command_t *cmd = calloc(1, sizeof(command_t));
-        if (!cmd) {
-            print_error("Failed to allocate command structure");
-            free(buffer);
-            return NULL;
-        }
-        if (and_op && (!or_op || and_op < or_op)) {
-            *and_op = '\0';
-            cmd->logic_op = LOGIC_AND;
-            char *next_part = and_op + 2;
-            trim(next_part);
-            // Check for command chaining
-            char *semicolon = strchr(next_part, ';');
-            if (semicolon) {
-                *semicolon = '\0';
-                cmd->next_logic_command = strdup_safe(trim(next_part));
-                cmd->next_command = strdup_safe(trim(semicolon + 1));
-            } else {
-                cmd->next_logic_command = strdup_safe(trim(next_part));
+    delim[len] = '\0';
+    redirect->target = delim;
+    redirect->flags = (op == TOK_DLESSDASH ? HEREDOC_STRIP_TABS : 0) |
+                      (token->quoted ? 0 : HEREDOC_EXPAND);
+    **heredoc_tail = redirect;
+    *heredoc_tail = &redirect->next_heredoc;
+}
+
+// Helper: parse a simple command (assignments, words and redirections).
+// Here-documents are appended to the list at @heredoc_tail.
+// On return @token holds the operator that ended the command.
+// Returns: command_t, or NULL on a syntax error (*syntax_error set).
+static command_t *parse_simple_command(lexer_t *lexer, token_t *token, int *syntax_error,
+                                       redirect_t ***heredoc_tail) {
+    arena_t *arena = lexer->arena;
+    command_t *cmd = arena_calloc(arena, 1, sizeof(command_t));
+    redirect_t **redirect_tail = &cmd->redirects;
+    int capacity = 0;
+    int assign_capacity = 0;
+
+    for (;;) {
+        redirect_type_t type;
+        int fd;
+
+        if (token->type == TOK_WORD && token->assignment && cmd->argc == 0) {
+            // NAME=value before the command name
+            append_word(arena, &cmd->assigns, &cmd->assign_count, &assign_capacity, token->word);
+        } else if (token->type == TOK_WORD) {
+            append_word(arena, &cmd->args, &cmd->argc, &capacity, token->word);
+        } else if (redirect_for_token(token->type, &type, &fd)) {
+            token_type_t op = token->type;
+            if (lexer_next(lexer, token) != 0) {
+                if (syntax_error) *syntax_error = 1;
+                return NULL;
             }
-        } else if (or_op) {
-            *or_op = '\0';
-            cmd->logic_op = LOGIC_OR;
-            char *next_part = or_op + 2;
-            trim(next_part);
-            char *semicolon = strchr(next_part, ';');
-            if (semicolon) {
-                *semicolon = '\0';
-                cmd->next_logic_command = strdup_safe(trim(next_part));
-                cmd->next_command = strdup_safe(trim(semicolon + 1));
-            } else {
-                cmd->next_logic_command = strdup_safe(trim(next_part));
+            if (token->type != TOK_WORD) {
+                syntax_error_at(token, syntax_error);
+                return NULL;
             }
-        }
-        // Parse first part (before && or ||)
-        char *first_part = trim(buffer);
-        parse_background(first_part, cmd);
-        parse_redirection(first_part, cmd);
-        parse_args(first_part, cmd);
-        free(buffer);
-        return cmd;
-    }
-    // Pipeline split (|) - only if no logical operators
-    char *pipe_saveptr = NULL;
-    char *pipe_token = strtok_r(buffer, "|", &pipe_saveptr);
-    command_t *first_cmd = NULL;
-    command_t *last_cmd = NULL;
-    while (pipe_token) {
-        command_t *cmd = calloc(1, sizeof(command_t));
-        if (!cmd) {
-            print_error("Failed to allocate command structure");
-            if (first_cmd) free_command(first_cmd);
-            free(buffer);
-            return NULL;
-        }
-        char *segment = trim(pipe_token);
-        parse_background(segment, cmd);
-        parse_redirection(segment, cmd);
-        parse_args(segment, cmd);
-        if (!first_cmd) {
-            first_cmd = cmd;
+            redirect_t *redirect = arena_calloc(arena, 1, sizeof(redirect_t));
+            redirect->type = type;
+            redirect->fd = fd;
+            redirect->target = token->word;
+            if (type == REDIR_HEREDOC) {
+                start_heredoc(redirect, op, token, heredoc_tail);
+            }
+            *redirect_tail = redirect;
+            redirect_tail = &redirect->next;
         } else {
-            last_cmd->next_pipe = cmd;
+            return cmd;
         }
-        last_cmd = cmd;
-        pipe_token = strtok_r(NULL, "|", &pipe_saveptr);
-    }
-    free(buffer);
-    return first_cmd;
-}
-
-/**
- * free_command - Free all memory associated with a command_t structure.
- * @cmd: Command to free.
- */
-void free_command(command_t *cmd) {
-    if (!cmd) return;
-    
-    if (cmd->args) {
-        free_string_array(cmd->args);
-    }
-    
-    free(cmd->input_redirect);
-    free(cmd->output_redirect);
-    free(cmd->next_command);
-    free(cmd->next_logic_command);
-    free(cmd);
-}
 
-/**
- * is_empty_command - Check if a command line is empty or whitespace only.
- * @line: Input string.
- *
- * Returns: 1 if empty, 0 otherwise.
- */
-int is_empty_command(const char *line) {
-    if (!line) return 1;
-    
-    while (*line) {
-        if (*line != ' ' && *line != '\t' && *line != '\n') {
-            return 0;
+        if (lexer_next(lexer, token) != 0) {
+            if (syntax_error) *syntax_error = 1;
+            return NULL;
         }
-        line++;
     }
-    return 1;
 }
 
 /**
- * parse_command_chain - Parse a chain of commands separated by ';'.
+ * parse_line - Parse a command line into a sequence tree.
+ * @arena: Arena that receives every node and string of the tree.
  * @line: Input command line.
- * @count: Output pointer for number of commands.
+ * @syntax_error: Set to 1 on a syntax error (may be NULL).
  *
- * Returns: Array of command_t pointers.
+ * Tokens are pulled from the lexer left to right. Simple commands are
+ * grouped into pipelines (|), pipelines into and-or lists (&&, ||), and
+ * and-or lists into a sequence (; and &). Nothing is kept as text to be
+ * parsed again later. The tree is released by resetting @arena, not node
+ * by node.
+ * Returns: Parsed tree, or NULL for an empty line or on error.
  */
-command_t **parse_command_chain(const char *line, int *count) {
-    if (!line || !count) return NULL;
-    
-    char *line_copy = strdup_safe(line);
-    int chain_count;
-    char **commands = split_string(line_copy, ";", &chain_count);
-    
-    if (!commands) {
-        free(line_copy);
-        *count = 0;
+sequence_t *parse_line(arena_t *arena, const char *line, int *syntax_error) {
+    if (syntax_error) *syntax_error = 0;
+    if (!line) {
+        return NULL;
+    }
+
+    lexer_t lexer;
+    token_t token;
+    lexer_init(&lexer, arena, line);
+    if (lexer_next(&lexer, &token) != 0) {
+        if (syntax_error) *syntax_error = 1;
         return NULL;
     }
-    
-    command_t **parsed_commands = malloc(chain_count * sizeof(command_t *));
-    if (!parsed_commands) {
-        free_string_array(commands);
-        free(line_copy);
-        *count = 0;
+    if (token.type == TOK_END) {
         return NULL;
     }
-    
-    int valid_count = 0;
-    for (int i = 0; i < chain_count; i++) {
-        trim(commands[i]);
-        if (strlen(commands[i]) > 0) {
-            parsed_commands[valid_count] = parse_command(commands[i]);
-            if (parsed_commands[valid_count]) {
-                valid_count++;
-            }
+
+    sequence_t *seq = arena_calloc(arena, 1, sizeof(sequence_t));
+    seq->arena = arena;
+    redirect_t **heredoc_tail = &seq->heredocs;
+
+    and_or_t **list_tail = &seq->lists;
+    and_or_t *list = NULL;
+    pipeline_t **pipeline_tail = NULL;
+    pipeline_t *pipeline = NULL;
+    command_t **stage_tail = NULL;
+
+    for (;;) {
+        command_t *cmd = parse_simple_command(&lexer, &token, syntax_error, &heredoc_tail);
+        if (!cmd) {
+            return NULL;
+        }
+
+        if (cmd->argc == 0 && cmd->assign_count == 0 && !cmd->redirects) {
+            // Nothing before the operator: only the end of the line after a
+            // complete list (e.g. a trailing ; or &) is allowed
+            if (token.type == TOK_END && !list) break;
+            return syntax_error_at(&token, syntax_error);
+        }
+
+        if (!list) {
+            list = arena_calloc(arena, 1, sizeof(and_or_t));
+            *list_tail = list;
+            list_tail = &list->next;
+            pipeline_tail = &list->pipelines;
+        }
+        if (!pipeline) {
+            pipeline = arena_calloc(arena, 1, sizeof(pipeline_t));
+            *pipeline_tail = pipeline;
+            pipeline_tail = &pipeline->next;
+            stage_tail = &pipeline->commands;
+        }
+        *stage_tail = cmd;
+        stage_tail = &cmd->next_pipe;
+        pipeline->stage_count++;
+
+        token_type_t op = token.type;
+        switch (op) {
+        case TOK_PIPE:
+            break;
+        case TOK_AND:
+        case TOK_OR:
+            pipeline->next_op = op == TOK_AND ? LOGIC_AND : LOGIC_OR;
+            pipeline = NULL;
+            break;
+        case TOK_BACKGROUND:
+        case TOK_SEMICOLON:
+            list->background = op == TOK_BACKGROUND;
+            list = NULL;
+            pipeline = NULL;
+            break;
+        default:
+            break;
+        }
+        if (op == TOK_END) break;
+
+        if (lexer_next(&lexer, &token) != 0) {
+            if (syntax_error) *syntax_error = 1;
+            return NULL;
         }
     }
-    
-    free_string_array(commands);
-    free(line_copy);
-    *count = valid_count;
-    return parsed_commands;
+
+    return seq->lists ? seq : NULL;
 }
 
 /**
- * free_command_chain - Free an array of command_t pointers.
- * @commands: Array to free.
- * @count: Number of commands.
+ * parse_heredoc_pending - Check if here-documents still need body lines.
+ * @seq: Tree returned by parse_line.
+ *
+ * Returns: 1 if parse_heredoc_line must be given more lines, 0 otherwise.
  */
-void free_command_chain(command_t **commands, int count) {
-    if (!commands) return;
-    
-    for (int i = 0; i < count; i++) {
-        free_command(commands[i]);
-    }
-    free(commands);
+int parse_heredoc_pending(const sequence_t *seq) {
+    return seq && seq->heredocs;
 }
 
 /**
- * parse_logical_chain - Parse a chain of commands separated by '&&' or '||'.
- * @line: Input command line.
- * @count: Output pointer for number of commands.
+ * parse_heredoc_line - Add a line to the first unfinished here-document.
+ * @seq: Tree returned by parse_line.
+ * @line: Next input line without its newline, or NULL at end of input.
  *
- * Returns: Array of command_t pointers.
+ * The delimiter line (after tab stripping for <<-) finishes the body and
+ * moves on to the next here-document of the line. A literal body is used
+ * as read; an expanding one becomes a word for expand_env_vars.
+ * Returns: 0, or -1 after a syntax error in an expanding body.
  */
-command_t **parse_logical_chain(const char *line, int *count) {
-    if (!line || !count) return NULL;
-    
-    char *line_copy = strdup_safe(line);
-    int chain_count;
-    char **commands = split_string(line_copy, "&&", &chain_count);
-    
-    if (!commands) {
-        // Try splitting by ||
-        commands = split_string(line_copy, "||", &chain_count);
-        if (!commands) {
-            free(line_copy);
-            *count = 0;
-            return NULL;
-        }
+int parse_heredoc_line(sequence_t *seq, const char *line) {
+    redirect_t *heredoc = seq->heredocs;
+    if (!heredoc) {
+        return 0;
     }
-    
-    command_t **parsed_commands = malloc(chain_count * sizeof(command_t *));
-    if (!parsed_commands) {
-        free_string_array(commands);
-        free(line_copy);
-        *count = 0;
-        return NULL;
+    if (!seq->heredoc_body.data) {
+        arena_str_init(&seq->heredoc_body, seq->arena);
     }
-    
-    int valid_count = 0;
-    for (int i = 0; i < chain_count; i++) {
-        trim(commands[i]);
-        if (strlen(commands[i]) > 0) {
-            parsed_commands[valid_count] = parse_command(commands[i]);
-            if (parsed_commands[valid_count]) {
-                valid_count++;
-            }
+
+    if (line) {
+        if (heredoc->flags & HEREDOC_STRIP_TABS) {
+            while (*line == '\t') line++;
+        }
+        if (strcmp(line, heredoc->target) != 0) {
+            arena_str_append(&seq->heredoc_body, line, strlen(line));
+            arena_str_putc(&seq->heredoc_body, '\n');
+            return 0;
         }
+    } else {
+        print_error("warning: here-document delimited by end of input (wanted `%s')",
+                    heredoc->target);
+    }
+
+    char *body = seq->heredoc_body.data;
+    if (heredoc->flags & HEREDOC_EXPAND) {
+        body = lexer_heredoc_word(seq->arena, body);
     }
-    
-    free_string_array(commands);
-    free(line_copy);
-    *count = valid_count;
-    return parsed_commands;
+    seq->heredocs = heredoc->next_heredoc;
+    seq->heredoc_body.data = NULL;
+    if (!body) {
+        seq->heredocs = NULL;
+        return -1;
+    }
+    heredoc->target = body;
+    return line ? 0 : parse_heredoc_line(seq, NULL);
 }
 
 /**
- * free_logical_chain - Free an array of command_t pointers for logical chains.
- * @commands: Array to free.
- * @count: Number of commands.
+ * is_empty_command - Check if a command line is empty or whitespace only.
+ * @line: Input string.
+ *
+ * Returns: 1 if empty, 0 otherwise.
  */
-void free_logical_chain(command_t **commands, int count) {
-    if (!commands) return;
-    
-    for (int i = 0; i < count; i++) {
-        free_command(commands[i]);
+int is_empty_command(const char *line) {
+    if (!line) return 1;
+
+    while (*line) {
+        if (*line != ' ' && *line != '\t' && *line != '\n') {
+            return 0;
+        }
+        line++;
     }
-    free(commands);
+    return 1;
 }
@@ -0,0 +1,439 @@
+#define _GNU_SOURCE
+#include "pathglob.h"
+#include "dirscan.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#define GLOB_INITIAL_RESULTS 64
+
+// One step of a compiled segment
+typedef enum {
+    GLOB_LITERAL,   // One given byte
+    GLOB_ANY,       // ?
+    GLOB_STAR,      // *
+    GLOB_CLASS      // [...]
+} glob_op_t;
+
+typedef struct {
+    glob_op_t op;
+    unsigned char byte;         // GLOB_LITERAL
+    uint32_t set[8];            // GLOB_CLASS: accepted bytes (negation applied)
+} glob_elem_t;
+
+// One '/'-separated part of a pattern
+typedef struct {
+    glob_elem_t *elems;
+    int count;
+    int magic;                  // Has *, ? or [...]; otherwise a plain name
+    int globstar;               // Exactly **
+    int dot;                    // Starts with a literal '.', so may match dotfiles
+    char *literal;              // Unescaped text, for plain names
+} glob_segment_t;
+
+// A compiled pattern and the matches found so far
+typedef struct {
+    glob_segment_t *segments;
+    int count;
+    int dirs_only;              // Pattern ended in '/'
+    arena_t *arena;
+    char **results;
+    size_t result_count;
+    size_t result_capacity;
+    char path[PATH_MAX];        // Directory being walked, with a trailing '/'
+} glob_walk_t;
+
+// Context for one directory scan
+typedef struct {
+    glob_walk_t *walk;
+    int dirfd;
+    size_t path_len;
+    int index;                  // Segment matched against the entries
+} glob_scan_t;
+
+static void walk_dir(glob_walk_t *walk, int dirfd, size_t path_len, int index);
+
+// Helper: add @byte to a class set
+static void set_add(uint32_t *set, unsigned char byte) {
+    set[byte >> 5] |= 1u << (byte & 31);
+}
+
+// Helper: check @byte against a class set
+static int set_has(const uint32_t *set, unsigned char byte) {
+    return (set[byte >> 5] >> (byte & 31)) & 1;
+}
+
+// Helper: add the bytes of a [:name:] class. Returns: 0, or -1 if unknown.
+static int add_named_class(uint32_t *set, const char *name, size_t len) {
+    static const struct {
+        const char *name;
+        int (*test)(int);
+    } classes[] = {
+        { "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+        { "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+        { "lower", islower }, { "print", isprint }, { "punct", ispunct },
+        { "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit },
+    };
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        if (strlen(classes[i].name) == len && memcmp(classes[i].name, name, len) == 0) {
+            for (int c = 1; c < 256; c++) {
+                if (classes[i].test(c)) set_add(set, (unsigned char)c);
+            }
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Helper: compile a bracket expression starting at @p (just after '[')
+// Returns: Pointer past the closing ']', or NULL if it is not closed (the
+//          '[' is then an ordinary byte).
+static const char *compile_class(const char *p, const char *end, glob_elem_t *elem) {
+    int negate = 0;
+    memset(elem->set, 0, sizeof(elem->set));
+    elem->op = GLOB_CLASS;
+
+    if (p < end && (*p == '!' || *p == '^')) {
+        negate = 1;
+        p++;
+    }
+    int first = 1;
+    while (p < end && (*p != ']' || first)) {
+        first = 0;
+        if (p[0] == '[' && p + 1 < end && p[1] == ':') {
+            const char *close = p + 2;
+            while (close + 1 < end && !(close[0] == ':' && close[1] == ']')) close++;
+            if (close + 1 < end && add_named_class(elem->set, p + 2, close - (p + 2)) == 0) {
+                p = close + 2;
+                continue;
+            }
+        }
+        unsigned char low = (unsigned char)*p++;
+        if (low == '\\' && p < end) low = (unsigned char)*p++;
+        unsigned char high = low;
+        if (p + 1 < end && *p == '-' && p[1] != ']') {
+            p++;
+            high = (unsigned char)*p++;
+            if (high == '\\' && p < end) high = (unsigned char)*p++;
+        }
+        for (int c = low; c <= high; c++) {
+            set_add(elem->set, (unsigned char)c);
+        }
+    }
+    if (p >= end) {
+        return NULL;
+    }
+    if (negate) {
+        for (int i = 0; i < 8; i++) elem->set[i] = ~elem->set[i];
+        elem->set[0] &= ~1u;  // Never NUL
+    }
+    return p + 1;
+}
+
+// Helper: compile the segment [@p, @end) into @seg
+static int compile_segment(arena_t *arena, const char *p, const char *end, glob_segment_t *seg) {
+    size_t len = (size_t)(end - p);
+    seg->elems = arena_alloc(arena, (len + 1) * sizeof(glob_elem_t));
+    seg->literal = arena_alloc(arena, len + 1);
+    seg->count = 0;
+    seg->magic = 0;
+    seg->globstar = len == 2 && p[0] == '*' && p[1] == '*';
+    seg->dot = p < end && (*p == '.' || (*p == '\\' && p + 1 < end && p[1] == '.'));
+    if (!seg->elems || !seg->literal) {
+        return -1;
+    }
+
+    size_t literal_len = 0;
+    while (p < end) {
+        glob_elem_t *elem = &seg->elems[seg->count];
+        char c = *p++;
+        if (c == '\\' && p < end) {
+            c = *p++;
+        } else if (c == '*') {
+            if (seg->count == 0 || seg->elems[seg->count - 1].op != GLOB_STAR) {
+                elem->op = GLOB_STAR;
+                seg->count++;
+            }
+            seg->magic = 1;
+            continue;
+        } else if (c == '?') {
+            elem->op = GLOB_ANY;
+            seg->count++;
+            seg->magic = 1;
+            continue;
+        } else if (c == '[') {
+            const char *next = compile_class(p, end, elem);
+            if (next) {
+                p = next;
+                seg->count++;
+                seg->magic = 1;
+                continue;
+            }
+        }
+        elem->op = GLOB_LITERAL;
+        elem->byte = (unsigned char)c;
+        seg->count++;
+        seg->literal[literal_len++] = c;
+    }
+    seg->literal[literal_len] = '\0';
+    return 0;
+}
+
+// Helper: match one file name against a compiled segment. A * backtracks
+// only to the last star, so matching is linear for typical patterns.
+static int match_segment(const glob_segment_t *seg, const char *name) {
+    if (name[0] == '.' && !seg->dot) {
+        return 0;  // Dotfiles only match a pattern that starts with '.'
+    }
+    const glob_elem_t *elem = seg->elems;
+    const glob_elem_t *end = elem + seg->count;
+    const glob_elem_t *star = NULL;
+    const char *star_name = NULL;
+    const unsigned char *s = (const unsigned char *)name;
+
+    while (*s) {
+        if (elem < end && elem->op == GLOB_STAR) {
+            star = ++elem;
+            star_name = (const char *)s;
+            continue;
+        }
+        if (elem < end &&
+            (elem->op == GLOB_ANY ||
+             (elem->op == GLOB_LITERAL && elem->byte == *s) ||
+             (elem->op == GLOB_CLASS && set_has(elem->set, *s)))) {
+            elem++;
+            s++;
+            continue;
+        }
+        if (!star) {
+            return 0;
+        }
+        elem = star;
+        s = (const unsigned char *)++star_name;
+    }
+    while (elem < end && elem->op == GLOB_STAR) {
+        elem++;
+    }
+    return elem == end;
+}
+
+// Helper: record walk->path[0, path_len) + @name as a match
+static void emit(glob_walk_t *walk, size_t path_len, const char *name, size_t len, int slash) {
+    if (walk->result_count == walk->result_capacity) {
+        size_t capacity = walk->result_capacity ? walk->result_capacity * 2 : GLOB_INITIAL_RESULTS;
+        char **grown = realloc(walk->results, capacity * sizeof(char *));
+        if (!grown) return;
+        walk->results = grown;
+        walk->result_capacity = capacity;
+    }
+    char *match = arena_alloc(walk->arena, path_len + len + 2);
+    if (!match) return;
+    memcpy(match, walk->path, path_len);
+    memcpy(match + path_len, name, len);
+    if (slash) match[path_len + len++] = '/';
+    match[path_len + len] = '\0';
+    walk->results[walk->result_count++] = match;
+}
+
+// Helper: check whether entry @name of @dirfd is a directory, using d_type
+// when it says so and fstatat otherwise
+static int is_directory(int dirfd, const char *name, unsigned char type, int follow) {
+    if (type == DT_DIR) return 1;
+    if (type != DT_UNKNOWN && (type != DT_LNK || !follow)) return 0;
+    struct stat st;
+    return fstatat(dirfd, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Helper: continue the walk below entry @name of @dirfd at segment @index
+static void descend(glob_walk_t *walk, int dirfd, size_t path_len, const char *name,
+                    size_t len, int index, int follow) {
+    if (path_len + len + 2 > sizeof(walk->path)) return;
+    int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW));
+    if (fd == -1) return;  // Not a directory (or unreadable): no stat needed
+    memcpy(walk->path + path_len, name, len);
+    walk->path[path_len + len] = '/';
+    walk_dir(walk, fd, path_len + len + 1, index);
+    close(fd);
+}
+
+// Helper: apply segment @index to one entry that matched it
+static void matched_entry(glob_walk_t *walk, int dirfd, size_t path_len, const char *name,
+                          size_t len, unsigned char type, int index) {
+    if (index == walk->count - 1) {
+        if (!walk->dirs_only) {
+            emit(walk, path_len, name, len, 0);
+        } else if (is_directory(dirfd, name, type, 1)) {
+            emit(walk, path_len, name, len, 1);
+        }
+    } else if (type == DT_DIR || type == DT_LNK || type == DT_UNKNOWN) {
+        descend(walk, dirfd, path_len, name, len, index + 1, 1);
+    }
+}
+
+// Helper: dirscan callback for a segment with wildcards
+static int scan_segment(const char *name, size_t len, unsigned char type, void *arg) {
+    glob_scan_t *scan = arg;
+    if (match_segment(&scan->walk->segments[scan->index], name)) {
+        matched_entry(scan->walk, scan->dirfd, scan->path_len, name, len, type, scan->index);
+    }
+    return 0;
+}
+
+// Helper: dirscan callback for **: one pass both matches the rest of the
+// pattern here and finds the subdirectories to walk into
+static int scan_globstar(const char *name, size_t len, unsigned char type, void *arg) {
+    glob_scan_t *scan = arg;
+    glob_walk_t *walk = scan->walk;
+    int rest = scan->index + 1;
+
+    if (name[0] == '.') {
+        return 0;  // ** never enters or matches hidden entries
+    }
+    if (rest == walk->count) {
+        // Trailing **: everything below
+        int dir = is_directory(scan->dirfd, name, type, 0);
+        if (!walk->dirs_only || dir) {
+            emit(walk, scan->path_len, name, len, walk->dirs_only);
+        }
+    } else if (walk->segments[rest].magic && match_segment(&walk->segments[rest], name)) {
+        matched_entry(walk, scan->dirfd, scan->path_len, name, len, type, rest);
+    }
+    if (is_directory(scan->dirfd, name, type, 0)) {
+        descend(walk, scan->dirfd, scan->path_len, name, len, scan->index, 0);
+    }
+    return 0;
+}
+
+// Helper: match segment @index and the ones after it inside @dirfd, whose
+// path is walk->path[0, path_len)
+static void walk_dir(glob_walk_t *walk, int dirfd, size_t path_len, int index) {
+    const glob_segment_t *seg = &walk->segments[index];
+    glob_scan_t scan = { walk, dirfd, path_len, index };
+
+    if (seg->globstar) {
+        // A plain name after ** is looked up here directly; the scan then
+        // only has to find subdirectories
+        int rest = index + 1;
+        if (rest < walk->count && !walk->segments[rest].magic) {
+            walk_dir(walk, dirfd, path_len, rest);
+        }
+        dirscan_fd(dirfd, scan_globstar, &scan);
+        return;
+    }
+
+    if (!seg->magic) {
+        // Plain name: no directory listing at all
+        size_t len = strlen(seg->literal);
+        struct stat st;
+        if (index == walk->count - 1) {
+            if (fstatat(dirfd, seg->literal, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+                (!walk->dirs_only || is_directory(dirfd, seg->literal, DT_UNKNOWN, 1))) {
+                emit(walk, path_len, seg->literal, len, walk->dirs_only);
+            }
+        } else {
+            descend(walk, dirfd, path_len, seg->literal, len, index + 1, 1);
+        }
+        return;
+    }
+
+    // Each directory descriptor is freshly opened and listed only once
+    dirscan_fd(dirfd, scan_segment, &scan);
+}
+
+// Helper: qsort comparison for match pointers
+static int compare_matches(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * pathglob_has_magic - Check a pattern for wildcards.
+ * @pattern: Pattern text.
+ *
+ * Returns: 1 if an unescaped *, ? or [ occurs, else 0.
+ */
+int pathglob_has_magic(const char *pattern) {
+    for (const char *p = pattern; *p; p++) {
+        if (*p == '\\' && p[1]) {
+            p++;
+        } else if (*p == '*' || *p == '?' || *p == '[') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * pathglob_expand - Expand a pattern to the matching file names.
+ * @arena: Arena for the compiled pattern, the names and the result array.
+ * @pattern: Pattern text (backslash escapes).
+ * @matches: Receives the sorted result array.
+ *
+ * The pattern is compiled once into per-segment matchers. Each directory
+ * is read with batched getdents64 calls, d_type decides what is a
+ * directory (fstatat only when the filesystem does not say), plain path
+ * segments are opened directly instead of listed, and a ** walk reads each
+ * directory once without following symlinks or entering hidden
+ * directories. Matches are gathered in a doubling array and sorted once.
+ * Returns: Number of matches.
+ */
+size_t pathglob_expand(arena_t *arena, const char *pattern, char ***matches) {
+    *matches = NULL;
+    if (!pathglob_has_magic(pattern)) {
+        return 0;
+    }
+
+    glob_walk_t *walk = calloc(1, sizeof(glob_walk_t));
+    if (!walk) {
+        return 0;
+    }
+    walk->arena = arena;
+
+    // Split into segments; empty ones (from // or a leading /) are skipped
+    size_t len = strlen(pattern);
+    walk->segments = arena_alloc(arena, (len / 2 + 2) * sizeof(glob_segment_t));
+    const char *p = pattern;
+    const char *end = pattern + len;
+    int absolute = *p == '/';
+    while (walk->segments && p < end) {
+        const char *start = p;
+        while (p < end && *p != '/') {
+            p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+        }
+        if (p > start && compile_segment(arena, start, p, &walk->segments[walk->count++]) != 0) {
+            free(walk);
+            return 0;
+        }
+        if (p < end) p++;
+    }
+    walk->dirs_only = len > 0 && pattern[len - 1] == '/';
+
+    size_t count = 0;
+    if (walk->segments && walk->count > 0) {
+        int fd = open(absolute ? "/" : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd != -1) {
+            size_t path_len = 0;
+            if (absolute) walk->path[path_len++] = '/';
+            walk_dir(walk, fd, path_len, 0);
+            close(fd);
+        }
+    }
+
+    if (walk->result_count > 0) {
+        qsort(walk->results, walk->result_count, sizeof(char *), compare_matches);
+        *matches = arena_alloc(arena, (walk->result_count + 1) * sizeof(char *));
+        if (*matches) {
+            memcpy(*matches, walk->results, walk->result_count * sizeof(char *));
+            (*matches)[walk->result_count] = NULL;
+            count = walk->result_count;
+        }
+    }
+    free(walk->results);
+    free(walk);
+    return count;
+}
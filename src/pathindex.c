@@ -0,0 +1,478 @@
+#define _GNU_SOURCE
+#include "pathindex.h"
+#include "cmdhash.h"
+#include "dirscan.h"
+#include "executor.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#define NAME_TABLE_INITIAL_CAPACITY 256
+#define DIR_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                        IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+// Open-addressing string table; deleted slots hold TOMBSTONE
+typedef struct {
+    char **keys;
+    int *values;
+    size_t capacity;    // Power of two
+    size_t count;       // Live keys
+    size_t used;        // Live keys plus tombstones
+} name_table_t;
+
+// One PATH directory
+typedef struct {
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    int wd;             // inotify watch, -1 if not watched
+    int alive;          // Set while the directory exists and is indexed
+    name_table_t names; // Candidate executables in this directory
+} index_dir_t;
+
+static char tombstone_marker;
+#define TOMBSTONE (&tombstone_marker)
+
+static index_dir_t *dirs = NULL;
+static int dir_count = 0;
+static int unwatched_count = 0;   // Directories without a watch (including missing ones)
+static name_table_t commands;     // Name -> index of first directory providing it
+static int inotify_fd = -1;
+static int index_built = 0;
+
+static char **saved_paths = NULL; // PATH as given, for rebuild after overflow
+static int saved_path_count = 0;
+
+static pathindex_watch_fn watch_hook = NULL;
+
+// Helper: FNV-1a string hash
+static size_t hash_name(const char *name) {
+    size_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Helper: find the slot holding @name, or -1
+static long table_find(const name_table_t *table, const char *name) {
+    if (table->capacity == 0) return -1;
+    size_t mask = table->capacity - 1;
+    for (size_t slot = hash_name(name) & mask;; slot = (slot + 1) & mask) {
+        char *key = table->keys[slot];
+        if (!key) return -1;
+        if (key != TOMBSTONE && strcmp(key, name) == 0) return (long)slot;
+    }
+}
+
+// Helper: rehash into a table of @capacity slots, dropping tombstones
+static int table_resize(name_table_t *table, size_t capacity) {
+    char **keys = calloc(capacity, sizeof(char *));
+    int *values = malloc(capacity * sizeof(int));
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return -1;
+    }
+
+    for (size_t i = 0; i < table->capacity; i++) {
+        char *key = table->keys[i];
+        if (!key || key == TOMBSTONE) continue;
+        size_t slot = hash_name(key) & (capacity - 1);
+        while (keys[slot]) slot = (slot + 1) & (capacity - 1);
+        keys[slot] = key;
+        values[slot] = table->values[i];
+    }
+
+    free(table->keys);
+    free(table->values);
+    table->keys = keys;
+    table->values = values;
+    table->capacity = capacity;
+    table->used = table->count;
+    return 0;
+}
+
+// Helper: insert or update @name; returns 0 on success
+static int table_set(name_table_t *table, const char *name, int value) {
+    long found = table_find(table, name);
+    if (found >= 0) {
+        table->values[found] = value;
+        return 0;
+    }
+
+    if ((table->used + 1) * 4 > table->capacity * 3) {
+        size_t capacity = table->capacity ? table->capacity : NAME_TABLE_INITIAL_CAPACITY;
+        while (table->count * 2 >= capacity) capacity *= 2;
+        if (table_resize(table, capacity) != 0) return -1;
+    }
+
+    size_t mask = table->capacity - 1;
+    size_t slot = hash_name(name) & mask;
+    while (table->keys[slot] && table->keys[slot] != TOMBSTONE) {
+        slot = (slot + 1) & mask;
+    }
+    if (!table->keys[slot]) table->used++;
+    table->keys[slot] = strdup_safe(name);
+    table->values[slot] = value;
+    table->count++;
+    return 0;
+}
+
+// Helper: remove @name if present
+static void table_remove(name_table_t *table, const char *name) {
+    long found = table_find(table, name);
+    if (found < 0) return;
+    free(table->keys[found]);
+    table->keys[found] = TOMBSTONE;
+    table->count--;
+}
+
+// Helper: free all keys and slots
+static void table_free(name_table_t *table) {
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->keys[i] && table->keys[i] != TOMBSTONE) free(table->keys[i]);
+    }
+    free(table->keys);
+    free(table->values);
+    memset(table, 0, sizeof(*table));
+}
+
+// Helper: point @name at the first live directory that still has it
+static void recompute_command(const char *name) {
+    for (int i = 0; i < dir_count; i++) {
+        if (dirs[i].alive && table_find(&dirs[i].names, name) >= 0) {
+            table_set(&commands, name, i);
+            return;
+        }
+    }
+    table_remove(&commands, name);
+    if (watch_hook) watch_hook(name, 0);
+}
+
+// Helper: record that directory @dir contains @name
+static void add_name(int dir, const char *name) {
+    table_set(&dirs[dir].names, name, 0);
+    long found = table_find(&commands, name);
+    if (found < 0) {
+        if (table_set(&commands, name, dir) == 0 && watch_hook) watch_hook(name, 1);
+    } else if (commands.values[found] > dir) {
+        commands.values[found] = dir;
+    }
+}
+
+// Helper: record that directory @dir no longer contains @name
+static void remove_name(int dir, const char *name) {
+    table_remove(&dirs[dir].names, name);
+    long found = table_find(&commands, name);
+    if (found >= 0 && commands.values[found] == dir) {
+        recompute_command(name);
+    }
+}
+
+// Context for scan_entry
+typedef struct {
+    int dir;
+} scan_ctx_t;
+
+// Helper: dirscan callback adding every entry that may be an executable
+static int scan_entry(const char *name, size_t len, unsigned char type, void *ctx) {
+    (void)len;
+    // Directories and device nodes can never be commands; anything else
+    // (including symlinks and DT_UNKNOWN) is checked when it is looked up
+    if (type == DT_DIR || type == DT_CHR || type == DT_BLK ||
+        type == DT_FIFO || type == DT_SOCK) {
+        return 0;
+    }
+    add_name(((scan_ctx_t *)ctx)->dir, name);
+    return 0;
+}
+
+// Helper: drop a directory that was deleted or moved away. It stays in
+// dirs, unwatched, so it is picked up again if it comes back.
+static void drop_dir(int dir) {
+    index_dir_t *d = &dirs[dir];
+    if (!d->alive) return;
+    d->alive = 0;
+    if (d->wd != -1) {
+        // A directory that was moved away is still watched
+        inotify_rm_watch(inotify_fd, d->wd);
+        unwatched_count++;
+    }
+    d->wd = -1;
+
+    for (size_t i = 0; i < d->names.capacity; i++) {
+        char *name = d->names.keys[i];
+        if (!name || name == TOMBSTONE) continue;
+        long found = table_find(&commands, name);
+        if (found >= 0 && commands.values[found] == dir) {
+            recompute_command(name);
+        }
+        cmdhash_remove(name);
+    }
+    table_free(&d->names);
+}
+
+// Helper: watch and read directory @dir, which exists as @st
+static void attach_dir(int dir, const struct stat *st) {
+    index_dir_t *d = &dirs[dir];
+    d->dev = st->st_dev;
+    d->ino = st->st_ino;
+    d->alive = 1;
+    // Watch before reading so no change between the two is lost
+    d->wd = inotify_fd == -1 ? -1 : inotify_add_watch(inotify_fd, d->path, DIR_WATCH_MASK);
+    if (d->wd != -1) unwatched_count--;
+
+    scan_ctx_t ctx = { dir };
+    if (dirscan_path(d->path, scan_entry, &ctx) != 0) {
+        drop_dir(dir);
+    }
+}
+
+// Helper: index directories that did not exist when last looked at
+static void revive_dirs(void) {
+    for (int i = 0; i < dir_count; i++) {
+        struct stat st;
+        if (!dirs[i].alive && stat(dirs[i].path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            attach_dir(i, &st);
+        }
+    }
+}
+
+// Helper: release everything except the saved PATH
+static void release_index(void) {
+    if (inotify_fd != -1) {
+        close(inotify_fd);  // Drops every watch
+        inotify_fd = -1;
+    }
+    for (int i = 0; i < dir_count; i++) {
+        free(dirs[i].path);
+        table_free(&dirs[i].names);
+    }
+    free(dirs);
+    dirs = NULL;
+    dir_count = 0;
+    unwatched_count = 0;
+    table_free(&commands);
+    if (watch_hook) watch_hook(NULL, 0);
+    index_built = 0;
+}
+
+// Helper: (re)build from saved_paths
+static void build_index(void) {
+    release_index();
+
+    dirs = calloc(saved_path_count > 0 ? saved_path_count : 1, sizeof(index_dir_t));
+    if (!dirs) return;
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    for (int i = 0; i < saved_path_count; i++) {
+        const char *path = saved_paths[i];
+        struct stat st;
+        int exists = stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+
+        int duplicate = 0;
+        for (int j = 0; exists && j < dir_count; j++) {
+            if (dirs[j].alive && dirs[j].dev == st.st_dev && dirs[j].ino == st.st_ino) {
+                duplicate = 1;
+                break;
+            }
+        }
+        if (duplicate) continue;
+
+        // Missing directories are kept, unwatched, until they appear
+        index_dir_t *d = &dirs[dir_count];
+        d->path = strdup_safe(path);
+        d->wd = -1;
+        unwatched_count++;
+        dir_count++;
+        if (exists) {
+            attach_dir(dir_count - 1, &st);
+        }
+    }
+    index_built = 1;
+}
+
+/**
+ * pathindex_build - Index every executable name in the PATH directories.
+ * @paths: Directories in search order.
+ * @count: Number of directories.
+ *
+ * Each directory is read once with getdents64 and then watched with
+ * inotify, so later lookups never probe the filesystem per directory.
+ */
+void pathindex_build(char **paths, int count) {
+    for (int i = 0; i < saved_path_count; i++) free(saved_paths[i]);
+    free(saved_paths);
+    saved_paths = NULL;
+    saved_path_count = 0;
+
+    if (count > 0) {
+        saved_paths = malloc(count * sizeof(char *));
+        if (!saved_paths) return;
+        for (int i = 0; i < count; i++) saved_paths[i] = strdup_safe(paths[i]);
+        saved_path_count = count;
+    }
+    build_index();
+}
+
+/**
+ * pathindex_rebuild - Read every PATH directory again.
+ *
+ * Used by `hash -r`; does nothing before the first pathindex_build.
+ */
+void pathindex_rebuild(void) {
+    if (saved_paths) {
+        build_index();
+    }
+}
+
+/**
+ * pathindex_ready - Check whether an index is available.
+ *
+ * Returns: 1 if built, 0 otherwise.
+ */
+int pathindex_ready(void) {
+    return index_built;
+}
+
+/**
+ * pathindex_sync - Apply pending directory change notifications.
+ *
+ * Costs a single non-blocking read when nothing changed. Any change to a
+ * name also drops it from the command hash table.
+ */
+void pathindex_sync(void) {
+    if (inotify_fd == -1) return;
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t len = read(inotify_fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            if (len == -1 && errno == EINTR) continue;
+            return;  // EAGAIN: caught up
+        }
+
+        for (char *p = buffer; p < buffer + len;) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost: start over
+                build_index();
+                cmdhash_clear();
+                return;
+            }
+
+            int dir = -1;
+            for (int i = 0; i < dir_count; i++) {
+                if (dirs[i].alive && dirs[i].wd == event->wd) {
+                    dir = i;
+                    break;
+                }
+            }
+            if (dir == -1) continue;
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                drop_dir(dir);
+                continue;
+            }
+            if (event->len == 0 || (event->mask & IN_ISDIR)) {
+                continue;
+            }
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                add_name(dir, event->name);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                remove_name(dir, event->name);
+            }
+            cmdhash_remove(event->name);
+        }
+    }
+}
+
+// Helper: format dir/name into buf and check it is executable
+static int check_candidate(const index_dir_t *d, const char *name, char *buf, size_t size) {
+    int len = snprintf(buf, size, "%s/%s", d->path, name);
+    if (len < 0 || (size_t)len >= size) return 0;
+    return is_executable(buf);
+}
+
+/**
+ * pathindex_lookup - Resolve a command name through the index.
+ * @name: Command name (no '/').
+ * @buf: Output buffer for the full path.
+ * @size: Size of @buf.
+ *
+ * A hit costs one hash probe plus a single stat to confirm the file is
+ * executable; a miss is answered without touching the filesystem unless
+ * some directory is unwatched. Missing directories are checked for again
+ * (and indexed once they exist), and directories that could not be
+ * watched are probed in PATH order.
+ * Returns: 1 if found, 0 if not in PATH, -1 if no index is available.
+ */
+int pathindex_lookup(const char *name, char *buf, size_t size) {
+    if (!index_built) return -1;
+    pathindex_sync();
+    if (unwatched_count > 0) {
+        revive_dirs();
+    }
+
+    long found = table_find(&commands, name);
+    int first = found >= 0 ? commands.values[found] : dir_count;
+    for (int i = unwatched_count > 0 ? 0 : first; i < dir_count; i++) {
+        const index_dir_t *d = &dirs[i];
+        if (!d->alive) continue;
+        if (d->wd == -1 || (i >= first && table_find(&d->names, name) >= 0)) {
+            if (check_candidate(d, name, buf, size)) return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * pathindex_set_watch - Follow changes to the set of command names.
+ * @hook: Called with (name, 1) when a name appears in PATH, (name, 0) when
+ *        it is gone from every directory, and (NULL, 0) when the whole
+ *        index is dropped; NULL to stop.
+ *
+ * The hook is first called for every name already indexed, so a caller
+ * can keep its own structure (such as a completion trie) in step without
+ * ever listing the directories itself.
+ */
+void pathindex_set_watch(pathindex_watch_fn hook) {
+    watch_hook = hook;
+    if (!hook) return;
+    for (size_t i = 0; i < commands.capacity; i++) {
+        char *key = commands.keys[i];
+        if (key && key != TOMBSTONE) hook(key, 1);
+    }
+}
+
+/**
+ * pathindex_fd - Get the inotify descriptor.
+ *
+ * Returns: Descriptor that becomes readable when PATH directories change,
+ *          or -1.
+ */
+int pathindex_fd(void) {
+    return inotify_fd;
+}
+
+/**
+ * pathindex_destroy - Free the index and drop all watches.
+ */
+void pathindex_destroy(void) {
+    release_index();
+    for (int i = 0; i < saved_path_count; i++) free(saved_paths[i]);
+    free(saved_paths);
+    saved_paths = NULL;
+    saved_path_count = 0;
+}
@@ -0,0 +1,321 @@
+#define _GNU_SOURCE
+#include "printfmt.h"
+#include "outbuf.h"
+#include "utils.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPEC_MAX 64     // Longest conversion spec passed on to snprintf
+#define SPEC_TAIL 4     // Room kept for "ll", the conversion and the NUL
+
+// Arguments still to be formatted, and whether output must stop (\c)
+typedef struct {
+    char *const *args;
+    int argc;
+    int next;
+    int status;
+    int stop;
+} printf_state_t;
+
+// Helper: take the next argument, or "" when they are used up
+static const char *next_arg(printf_state_t *st) {
+    return st->next < st->argc ? st->args[st->next++] : "";
+}
+
+// Helper: decode the escape after a backslash at @p into @out. In %b
+// arguments an octal escape is \0 and up to three digits, and \c stops all
+// output. Returns: Number of bytes consumed after the backslash.
+static size_t decode_escape(const char *p, char *out, int in_arg, int *stop) {
+    switch (*p) {
+    case 'a':  *out = '\a'; return 1;
+    case 'b':  *out = '\b'; return 1;
+    case 'f':  *out = '\f'; return 1;
+    case 'n':  *out = '\n'; return 1;
+    case 'r':  *out = '\r'; return 1;
+    case 't':  *out = '\t'; return 1;
+    case 'v':  *out = '\v'; return 1;
+    case 'e':  *out = '\033'; return 1;
+    case '\\': *out = '\\'; return 1;
+    case 'c':
+        if (in_arg) {
+            *stop = 1;
+            return 1;
+        }
+        break;
+    case 'x': {
+        size_t n = 0;
+        int value = 0;
+        while (n < 2 && strchr("0123456789abcdefABCDEF", p[1 + n]) && p[1 + n]) {
+            char c = p[1 + n++];
+            value = value * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+        }
+        if (n == 0) break;
+        *out = (char)value;
+        return 1 + n;
+    }
+    default:
+        if (*p >= '0' && *p <= '7') {
+            size_t skip = in_arg && *p == '0' ? 1 : 0;
+            size_t n = 0;
+            int value = 0;
+            while (n < 3 && p[skip + n] >= '0' && p[skip + n] <= '7') {
+                value = value * 8 + (p[skip + n++] - '0');
+            }
+            *out = (char)value;
+            return skip + n;
+        }
+        break;
+    }
+    // Not an escape: keep the backslash and let the byte follow as text
+    *out = '\\';
+    return 0;
+}
+
+// Helper: expand the escapes of a %b argument into a malloc'd string
+static char *expand_escapes(const char *arg, size_t *len, int *stop) {
+    char *out = malloc(strlen(arg) + 1);
+    size_t used = 0;
+    if (!out) return NULL;
+    for (const char *p = arg; *p && !*stop; p++) {
+        if (*p == '\\' && p[1]) {
+            char c;
+            size_t n = decode_escape(p + 1, &c, 1, stop);
+            if (*stop) break;
+            out[used++] = c;
+            p += n;
+        } else {
+            out[used++] = *p;
+        }
+    }
+    out[used] = '\0';
+    *len = used;
+    return out;
+}
+
+// Helper: parse a numeric argument as C does ('c gives the code of c).
+// Returns: The value; an invalid number is reported and sets the status.
+static long long number_arg(printf_state_t *st, int *is_unsigned_big, unsigned long long *uvalue) {
+    const char *arg = next_arg(st);
+    *is_unsigned_big = 0;
+    if (arg[0] == '\'' || arg[0] == '"') {
+        *uvalue = (unsigned char)arg[1];
+        return (unsigned char)arg[1];
+    }
+    if (!arg[0]) {
+        *uvalue = 0;
+        return 0;
+    }
+
+    char *end;
+    errno = 0;
+    long long value = strtoll(arg, &end, 0);
+    *uvalue = (unsigned long long)value;
+    if (errno == ERANGE && arg[0] != '-') {
+        // Too big for a signed value: still fine for %u, %x and %o
+        errno = 0;
+        *uvalue = strtoull(arg, &end, 0);
+        *is_unsigned_big = 1;
+    }
+    if (*end || errno == ERANGE) {
+        print_error("printf: %s: invalid number", arg);
+        st->status = 1;
+    }
+    return value;
+}
+
+// Helper: parse a floating-point argument
+static double float_arg(printf_state_t *st) {
+    const char *arg = next_arg(st);
+    if (arg[0] == '\'' || arg[0] == '"') {
+        return (unsigned char)arg[1];
+    }
+    if (!arg[0]) {
+        return 0;
+    }
+    char *end;
+    double value = strtod(arg, &end);
+    if (*end) {
+        print_error("printf: %s: invalid number", arg);
+        st->status = 1;
+    }
+    return value;
+}
+
+// Helper: append @count bytes of @text to the spec, keeping SPEC_TAIL
+// bytes free. Returns: 0, or -1 after printing an error if it is full.
+static int spec_append(char *spec, size_t *len, const char *text, size_t count) {
+    if (*len + count > SPEC_MAX - SPEC_TAIL) {
+        print_error("printf: format specification too long");
+        return -1;
+    }
+    memcpy(spec + *len, text, count);
+    *len += count;
+    return 0;
+}
+
+// Helper: format one conversion starting at @p (just after '%').
+// Returns: Pointer past the conversion, or NULL if it is invalid.
+static const char *format_conversion(printf_state_t *st, const char *p) {
+    char spec[SPEC_MAX];
+    size_t len = 0;
+    spec[len++] = '%';
+
+    size_t run = strspn(p, "-+ #0");
+    if (spec_append(spec, &len, p, run) != 0) {
+        return NULL;
+    }
+    p += run;
+    // Width and precision, with * taken from the arguments
+    for (int part = 0; part < 2; part++) {
+        if (part == 1) {
+            if (*p != '.') break;
+            if (spec_append(spec, &len, p++, 1) != 0) {
+                return NULL;
+            }
+        }
+        if (*p == '*') {
+            int unsigned_big;
+            unsigned long long unused;
+            char digits[16];
+            long long value = number_arg(st, &unsigned_big, &unused);
+            int n = snprintf(digits, sizeof(digits), "%d",
+                             value > 1000000 ? 1000000 : value < -1000000 ? -1000000 : (int)value);
+            if (spec_append(spec, &len, digits, (size_t)n) != 0) {
+                return NULL;
+            }
+            p++;
+        } else {
+            run = strspn(p, "0123456789");
+            if (spec_append(spec, &len, p, run) != 0) {
+                return NULL;
+            }
+            p += run;
+        }
+    }
+    // Length modifiers mean nothing here: every value is as wide as it gets
+    while (*p && strchr("hlLjzt", *p)) {
+        p++;
+    }
+
+    char conv = *p;
+    if (!conv) {
+        print_error("printf: missing format character");
+        return NULL;
+    }
+    p++;
+    switch (conv) {
+    case 'd':
+    case 'i': {
+        int unsigned_big;
+        unsigned long long uvalue;
+        long long value = number_arg(st, &unsigned_big, &uvalue);
+        memcpy(spec + len, "lld", 4);
+        outbuf_printf(spec, value);
+        break;
+    }
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X': {
+        int unsigned_big;
+        unsigned long long uvalue;
+        number_arg(st, &unsigned_big, &uvalue);
+        spec[len++] = 'l';
+        spec[len++] = 'l';
+        spec[len++] = conv;
+        spec[len] = '\0';
+        outbuf_printf(spec, uvalue);
+        break;
+    }
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A': {
+        double value = float_arg(st);
+        spec[len++] = conv;
+        spec[len] = '\0';
+        outbuf_printf(spec, value);
+        break;
+    }
+    case 'c': {
+        const char *arg = next_arg(st);
+        if (arg[0]) {
+            memcpy(spec + len, "c", 2);
+            outbuf_printf(spec, arg[0]);
+        } else {
+            memcpy(spec + len, "s", 2);
+            outbuf_printf(spec, "");
+        }
+        break;
+    }
+    case 's':
+        memcpy(spec + len, "s", 2);
+        outbuf_printf(spec, next_arg(st));
+        break;
+    case 'b': {
+        size_t expanded_len;
+        char *expanded = expand_escapes(next_arg(st), &expanded_len, &st->stop);
+        if (!expanded) {
+            print_error("printf: out of memory");
+            return NULL;
+        }
+        memcpy(spec + len, "s", 2);
+        outbuf_printf(spec, expanded);
+        free(expanded);
+        break;
+    }
+    default:
+        print_error("printf: %c: invalid format character", conv);
+        return NULL;
+    }
+    return p;
+}
+
+/**
+ * printfmt_run - Format arguments like printf(1).
+ * @args: Format followed by its arguments.
+ * @argc: Number of entries in @args (at least 1).
+ *
+ * Supports the C conversions d i o u x X e E f F g G a A c s, %b for
+ * arguments with escapes, flags, widths and precisions (including *), and
+ * the format escapes \a \b \e \f \n \r \t \v \\ \NNN and \xHH. Missing
+ * arguments count as "" or 0, and the format is applied again while
+ * arguments remain. Output goes to the builtin output buffer.
+ * Returns: 0 on success, 1 on an invalid number or format.
+ */
+int printfmt_run(char *const *args, int argc) {
+    printf_state_t st = { args, argc, 1, 0, 0 };
+    const char *format = args[0];
+
+    do {
+        int first = st.next;
+        const char *p = format;
+        while (*p && !st.stop) {
+            // Plain text up to the next % or backslash
+            size_t run = strcspn(p, "%\\");
+            outbuf_write(p, run);
+            p += run;
+
+            if (*p == '\\') {
+                char c = '\\';
+                size_t n = p[1] ? decode_escape(p + 1, &c, 0, &st.stop) : 0;
+                if (!st.stop) outbuf_write(&c, 1);
+                p += 1 + n;
+            } else if (*p == '%') {
+                if (p[1] == '%') {
+                    outbuf_write("%", 1);
+                    p += 2;
+                    continue;
+                }
+                p = format_conversion(&st, p + 1);
+                if (!p) {
+                    return 1;
+                }
+            }
+        }
+        if (st.next == first) {
+            break;  // The format takes no arguments
+        }
+    } while (st.next < st.argc && !st.stop);
+
+    return st.status;
+}
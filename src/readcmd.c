@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+#include "readcmd.h"
+#include "utils.h"
+#include "vars.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define READ_BLOCK_SIZE 4096
+#define DEFAULT_IFS " \t\n"
+
+// A line being read: its bytes and, without -r, which were escaped
+typedef struct {
+    char *text;
+    unsigned char *quoted;
+    size_t len;
+    size_t capacity;
+} read_line_t;
+
+// Helper: make room for @extra more bytes
+static int line_reserve(read_line_t *line, size_t extra) {
+    if (line->len + extra + 1 <= line->capacity) return 0;
+    size_t capacity = line->capacity ? line->capacity : READ_BLOCK_SIZE;
+    while (line->len + extra + 1 > capacity) capacity *= 2;
+    char *text = realloc(line->text, capacity);
+    if (!text) return -1;
+    line->text = text;
+    unsigned char *quoted = realloc(line->quoted, capacity);
+    if (!quoted) return -1;
+    line->quoted = quoted;
+    line->capacity = capacity;
+    return 0;
+}
+
+// Helper: read stdin up to and including @delim into @line (raw bytes).
+// Regular files and other seekable input are read in blocks and the
+// offset is moved back to just past the delimiter; a terminal returns at
+// most one line per read anyway. Pipes are read a byte at a time so that
+// nothing after the line is taken from the next command.
+// Returns: 1 if the delimiter was found, 0 at end of input, -1 on error.
+static int read_raw_line(read_line_t *line, char delim) {
+    int seekable = lseek(STDIN_FILENO, 0, SEEK_CUR) != -1;
+    int blocks = seekable || (delim == '\n' && isatty(STDIN_FILENO));
+
+    for (;;) {
+        size_t want = blocks ? READ_BLOCK_SIZE : 1;
+        if (line_reserve(line, want) != 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        ssize_t n = read(STDIN_FILENO, line->text + line->len, want);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            return 0;
+        }
+
+        char *found = memchr(line->text + line->len, delim, (size_t)n);
+        if (!found) {
+            line->len += (size_t)n;
+            continue;
+        }
+        size_t used = (size_t)(found - line->text) + 1;
+        size_t excess = line->len + (size_t)n - used;
+        if (excess > 0 && seekable) {
+            lseek(STDIN_FILENO, -(off_t)excess, SEEK_CUR);
+        }
+        line->len = used;
+        return 1;
+    }
+}
+
+// Helper: remove backslashes in place, marking the bytes they escaped.
+// Returns: 1 if the line ended in a backslash before the newline
+//          (a continuation), else 0.
+static int unescape_line(read_line_t *line, size_t from) {
+    size_t out = from;
+    for (size_t i = from; i < line->len; i++) {
+        if (line->text[i] == '\\' && i + 1 < line->len) {
+            i++;
+            if (line->text[i] == '\n') {
+                if (i + 1 == line->len) {
+                    line->len = out;
+                    return 1;
+                }
+                continue;
+            }
+            line->quoted[out] = 1;
+        } else {
+            line->quoted[out] = 0;
+        }
+        line->text[out++] = line->text[i];
+    }
+    line->len = out;
+    return 0;
+}
+
+// Helper: check for an unescaped byte of @set at @i
+static int is_sep(const read_line_t *line, size_t i, const char *set) {
+    return !line->quoted[i] && line->text[i] && strchr(set, line->text[i]);
+}
+
+// Helper: split @line on @ifs and assign the fields.
+// Returns: 0, or 2 if a variable could not be set.
+static int assign_fields(read_line_t *line, char *const *names, int count, const char *ifs) {
+    // IFS whitespace runs count as one separator and are trimmed at the ends
+    char white[4];
+    size_t white_len = 0;
+    for (const char *c = DEFAULT_IFS; *c; c++) {
+        if (strchr(ifs, *c)) white[white_len++] = *c;
+    }
+    white[white_len] = '\0';
+
+    size_t pos = 0, end = line->len;
+    while (pos < end && is_sep(line, pos, white)) pos++;
+
+    for (int n = 0; n < count; n++) {
+        size_t start = pos, stop;
+        if (n == count - 1) {
+            // The last variable takes the rest, less trailing IFS whitespace
+            stop = end;
+            while (stop > start && is_sep(line, stop - 1, white)) stop--;
+            pos = end;
+        } else {
+            while (pos < end && !is_sep(line, pos, ifs)) pos++;
+            stop = pos;
+            // One separator: whitespace around at most one other IFS byte
+            while (pos < end && is_sep(line, pos, white)) pos++;
+            if (pos < end && is_sep(line, pos, ifs) && !is_sep(line, pos, white)) {
+                pos++;
+                while (pos < end && is_sep(line, pos, white)) pos++;
+            }
+        }
+
+        char saved = line->text[stop];
+        line->text[stop] = '\0';
+        int failed = vars_set(names[n], line->text + start, 0) != 0;
+        line->text[stop] = saved;
+        if (failed) {
+            print_error("read: %s: cannot set variable", names[n]);
+            return 2;
+        }
+    }
+    return 0;
+}
+
+/**
+ * readcmd_run - Read a line into shell variables (the read builtin).
+ * @names: Variables to assign.
+ * @count: Number of variables (0 assigns the whole line to REPLY).
+ * @opts: Options.
+ *
+ * Without -r a backslash escapes the next byte, protecting it from
+ * splitting, and a backslash before the newline continues the line.
+ * Returns: 0 if a whole line was read, 1 at end of input (the variables
+ *          still get any partial line), 2 on an error.
+ */
+int readcmd_run(char *const *names, int count, const read_opts_t *opts) {
+    static char *const reply[] = { "REPLY" };
+    for (int i = 0; i < count; i++) {
+        if (!vars_valid_name(names[i], strlen(names[i]))) {
+            print_error("read: `%s': not a valid identifier", names[i]);
+            return 2;
+        }
+    }
+    if (count == 0) {
+        names = reply;
+        count = 1;
+    }
+    if (opts->prompt && isatty(STDIN_FILENO)) {
+        fputs(opts->prompt, stderr);
+    }
+
+    read_line_t line = { NULL, NULL, 0, 0 };
+    int found;
+    size_t from = 0;
+    for (;;) {
+        found = read_raw_line(&line, opts->delim);
+        if (found < 0) {
+            print_system_error("read");
+            free(line.text);
+            free(line.quoted);
+            return 2;
+        }
+        if (opts->raw) {
+            if (line.len > from) memset(line.quoted + from, 0, line.len - from);
+        } else if (unescape_line(&line, from) && found) {
+            from = line.len;
+            continue;  // Backslash-newline: the line goes on
+        }
+        break;
+    }
+    if (found) {
+        line.len--;  // Drop the delimiter
+    }
+    int status = 2;
+    if (line_reserve(&line, 0) == 0) {
+        line.text[line.len] = '\0';
+        line.quoted[line.len] = 0;
+        const char *ifs = vars_get("IFS");
+        status = assign_fields(&line, names, count, ifs ? ifs : DEFAULT_IFS);
+    } else {
+        print_error("read: out of memory");
+    }
+    free(line.text);
+    free(line.quoted);
+    if (status != 0) {
+        return status;
+    }
+    return found ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+#define _GNU_SOURCE
+#include "testexpr.h"
+#include "utils.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_ERROR 2
+
+// Parser state for expressions longer than four words
+typedef struct {
+    char *const *args;
+    int count;
+    int pos;
+    int error;
+} test_parser_t;
+
+// Command name for error messages (test or [)
+static const char *test_name = "test";
+
+// Helper: check for a unary operator word (-f, -z, ...)
+static int is_unary_op(const char *op) {
+    return op[0] == '-' && op[1] && !op[2] && strchr("bcdefghkLnOprsStuwxzGN", op[1]);
+}
+
+// Helper: check for a binary operator word
+static int is_binary_op(const char *op) {
+    static const char *ops[] = {
+        "=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le", "-gt", "-ge",
+        "-nt", "-ot", "-ef", NULL
+    };
+    for (int i = 0; ops[i]; i++) {
+        if (strcmp(op, ops[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Helper: parse an integer operand (blanks around it are allowed)
+static int parse_integer(const char *text, long long *value, int *error) {
+    char *end;
+    errno = 0;
+    *value = strtoll(text, &end, 10);
+    while (isspace((unsigned char)*end)) end++;
+    if (end == text || *end || errno == ERANGE) {
+        print_error("%s: %s: integer expression expected", test_name, text);
+        *error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+// Helper: evaluate a unary operator
+static int eval_unary(const char *op, const char *arg, int *error) {
+    struct stat st;
+
+    switch (op[1]) {
+    case 'n': return arg[0] != '\0';
+    case 'z': return arg[0] == '\0';
+    case 't': {
+        long long fd;
+        if (parse_integer(arg, &fd, error) != 0) return 0;
+        return fd >= 0 && fd <= INT_MAX && isatty((int)fd);
+    }
+    case 'h':
+    case 'L': return lstat(arg, &st) == 0 && S_ISLNK(st.st_mode);
+    case 'r': return faccessat(AT_FDCWD, arg, R_OK, AT_EACCESS) == 0;
+    case 'w': return faccessat(AT_FDCWD, arg, W_OK, AT_EACCESS) == 0;
+    case 'x': return faccessat(AT_FDCWD, arg, X_OK, AT_EACCESS) == 0;
+    }
+
+    if (stat(arg, &st) != 0) {
+        return 0;
+    }
+    switch (op[1]) {
+    case 'b': return S_ISBLK(st.st_mode);
+    case 'c': return S_ISCHR(st.st_mode);
+    case 'd': return S_ISDIR(st.st_mode);
+    case 'e': return 1;
+    case 'f': return S_ISREG(st.st_mode);
+    case 'g': return (st.st_mode & S_ISGID) != 0;
+    case 'k': return (st.st_mode & S_ISVTX) != 0;
+    case 'p': return S_ISFIFO(st.st_mode);
+    case 's': return st.st_size > 0;
+    case 'S': return S_ISSOCK(st.st_mode);
+    case 'u': return (st.st_mode & S_ISUID) != 0;
+    case 'O': return st.st_uid == geteuid();
+    case 'G': return st.st_gid == getegid();
+    case 'N': return st.st_mtim.tv_sec > st.st_atim.tv_sec ||
+                     (st.st_mtim.tv_sec == st.st_atim.tv_sec &&
+                      st.st_mtim.tv_nsec > st.st_atim.tv_nsec);
+    }
+    return 0;
+}
+
+// Helper: compare modification times (-1, 0 or 1); a missing file is oldest
+static int compare_mtime(const char *a, const char *b) {
+    struct stat sa, sb;
+    int has_a = stat(a, &sa) == 0, has_b = stat(b, &sb) == 0;
+    if (!has_a || !has_b) return has_a - has_b;
+    if (sa.st_mtim.tv_sec != sb.st_mtim.tv_sec) {
+        return sa.st_mtim.tv_sec < sb.st_mtim.tv_sec ? -1 : 1;
+    }
+    return (sa.st_mtim.tv_nsec > sb.st_mtim.tv_nsec) - (sa.st_mtim.tv_nsec < sb.st_mtim.tv_nsec);
+}
+
+// Helper: evaluate a binary operator
+static int eval_binary(const char *left, const char *op, const char *right, int *error) {
+    if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0) return strcmp(left, right) == 0;
+    if (strcmp(op, "!=") == 0) return strcmp(left, right) != 0;
+    if (strcmp(op, "<") == 0) return strcmp(left, right) < 0;
+    if (strcmp(op, ">") == 0) return strcmp(left, right) > 0;
+    if (strcmp(op, "-nt") == 0) return compare_mtime(left, right) > 0;
+    if (strcmp(op, "-ot") == 0) return compare_mtime(left, right) < 0;
+    if (strcmp(op, "-ef") == 0) {
+        struct stat sa, sb;
+        return stat(left, &sa) == 0 && stat(right, &sb) == 0 &&
+               sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    }
+
+    long long a, b;
+    if (parse_integer(left, &a, error) != 0 || parse_integer(right, &b, error) != 0) {
+        return 0;
+    }
+    switch (op[1] << 8 | op[2]) {
+    case 'e' << 8 | 'q': return a == b;
+    case 'n' << 8 | 'e': return a != b;
+    case 'l' << 8 | 't': return a < b;
+    case 'l' << 8 | 'e': return a <= b;
+    case 'g' << 8 | 't': return a > b;
+    default:             return a >= b;
+    }
+}
+
+// Helper: next word, or NULL at the end
+static const char *peek(const test_parser_t *p, int offset) {
+    return p->pos + offset < p->count ? p->args[p->pos + offset] : NULL;
+}
+
+static int parse_or(test_parser_t *p);
+
+// Helper: primary := ( expr ) | unary-op word | word binary-op word | word
+static int parse_primary(test_parser_t *p) {
+    const char *word = peek(p, 0);
+    if (!word) {
+        print_error("%s: argument expected", test_name);
+        p->error = 1;
+        return 0;
+    }
+    const char *next = peek(p, 1);
+
+    if (next && peek(p, 2) && is_binary_op(next)) {
+        p->pos += 3;
+        return eval_binary(word, next, p->args[p->pos - 1], &p->error);
+    }
+    if (strcmp(word, "(") == 0 && next) {
+        p->pos++;
+        int value = parse_or(p);
+        const char *close = peek(p, 0);
+        if (!close || strcmp(close, ")") != 0) {
+            if (!p->error) print_error("%s: ')' expected", test_name);
+            p->error = 1;
+            return 0;
+        }
+        p->pos++;
+        return value;
+    }
+    if (is_unary_op(word) && next) {
+        p->pos += 2;
+        return eval_unary(word, next, &p->error);
+    }
+    p->pos++;
+    return word[0] != '\0';
+}
+
+// Helper: not := ! not | primary
+static int parse_not(test_parser_t *p) {
+    const char *word = peek(p, 0);
+    if (word && strcmp(word, "!") == 0 && peek(p, 1)) {
+        p->pos++;
+        return !parse_not(p);
+    }
+    return parse_primary(p);
+}
+
+// Helper: and := not ( -a not )*
+static int parse_and(test_parser_t *p) {
+    int value = parse_not(p);
+    while (!p->error && peek(p, 0) && strcmp(peek(p, 0), "-a") == 0 && peek(p, 1)) {
+        p->pos++;
+        int right = parse_not(p);
+        value = value && right;
+    }
+    return value;
+}
+
+// Helper: or := and ( -o and )*
+static int parse_or(test_parser_t *p) {
+    int value = parse_and(p);
+    while (!p->error && peek(p, 0) && strcmp(peek(p, 0), "-o") == 0 && peek(p, 1)) {
+        p->pos++;
+        int right = parse_and(p);
+        value = value || right;
+    }
+    return value;
+}
+
+// Helper: evaluate @count words, using POSIX's rules by word count for up
+// to four words and the full grammar beyond
+static int eval_words(char *const *args, int count, int *error) {
+    switch (count) {
+    case 0:
+        return 0;
+    case 1:
+        return args[0][0] != '\0';
+    case 2:
+        if (strcmp(args[0], "!") == 0) return !eval_words(args + 1, 1, error);
+        if (is_unary_op(args[0])) return eval_unary(args[0], args[1], error);
+        print_error("%s: %s: unary operator expected", test_name, args[0]);
+        *error = 1;
+        return 0;
+    case 3:
+        if (is_binary_op(args[1])) return eval_binary(args[0], args[1], args[2], error);
+        if (strcmp(args[0], "!") == 0) return !eval_words(args + 1, 2, error);
+        if (strcmp(args[0], "(") == 0 && strcmp(args[2], ")") == 0) {
+            return eval_words(args + 1, 1, error);
+        }
+        if (strcmp(args[1], "-a") == 0) return args[0][0] && args[2][0];
+        if (strcmp(args[1], "-o") == 0) return args[0][0] || args[2][0];
+        print_error("%s: %s: binary operator expected", test_name, args[1]);
+        *error = 1;
+        return 0;
+    case 4:
+        if (strcmp(args[0], "!") == 0) return !eval_words(args + 1, 3, error);
+        if (strcmp(args[0], "(") == 0 && strcmp(args[3], ")") == 0) {
+            return eval_words(args + 1, 2, error);
+        }
+        break;
+    }
+
+    test_parser_t parser = { args, count, 0, 0 };
+    int value = parse_or(&parser);
+    if (!parser.error && parser.pos < count) {
+        print_error("%s: %s: unexpected argument", test_name, args[parser.pos]);
+        parser.error = 1;
+    }
+    *error = parser.error;
+    return value;
+}
+
+/**
+ * testexpr_eval - Evaluate a test expression.
+ * @name: Command name for error messages.
+ * @args: Expression words.
+ * @argc: Number of words.
+ *
+ * Up to four words follow POSIX's rules by argument count, so `[ -n = ]`
+ * or `[ ! -f ]` mean what POSIX says; longer expressions are parsed with
+ * ! binding tighter than -a, and -a tighter than -o.
+ * Returns: 0 if the expression is true, 1 if false, 2 on a syntax error.
+ */
+int testexpr_eval(const char *name, char *const *args, int argc) {
+    int error = 0;
+    test_name = name;
+    int value = eval_words(args, argc, &error);
+    if (error) {
+        return TEST_ERROR;
+    }
+    return value ? 0 : 1;
+}
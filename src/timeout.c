@@ -0,0 +1,113 @@
+#define _GNU_SOURCE
+#include "timeout.h"
+#include "executor.h"
+#include "jobs.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+
+#define TIMEOUT_STATUS 124
+
+/**
+ * timeout_parse_duration - Parse a timeout duration.
+ * @text: Non-negative number, optionally fractional, with an optional
+ *        s, m, h or d suffix (seconds by default).
+ * @out: Receives the duration.
+ *
+ * Returns: 0 on success, -1 if @text is not a valid duration.
+ */
+int timeout_parse_duration(const char *text, struct timespec *out) {
+    char *end;
+    double seconds = strtod(text, &end);
+
+    if (end == text || seconds < 0) {
+        return -1;
+    }
+    switch (*end) {
+    case '\0':
+    case 's': break;
+    case 'm': seconds *= 60; break;
+    case 'h': seconds *= 60 * 60; break;
+    case 'd': seconds *= 60 * 60 * 24; break;
+    default:  return -1;
+    }
+    if (*end && end[1]) {
+        return -1;
+    }
+    if (seconds > 1e9) {
+        seconds = 1e9;  // Far enough to mean "no limit"
+    }
+
+    out->tv_sec = (time_t)seconds;
+    out->tv_nsec = (long)((seconds - (double)out->tv_sec) * 1e9);
+    return 0;
+}
+
+// Helper: check for a zero duration
+static int is_zero(const struct timespec *ts) {
+    return ts->tv_sec == 0 && ts->tv_nsec == 0;
+}
+
+// Helper: signal the job's process group; a stopped group is continued
+// so it can act on the signal
+static void signal_job(job_t *job, int sig) {
+    kill(-job->pgid, sig);
+    if (sig != SIGKILL && sig != SIGCONT) {
+        kill(-job->pgid, SIGCONT);
+    }
+}
+
+/**
+ * timeout_run - Run a command with a time limit.
+ * @cmd: Command to run (already expanded).
+ * @opts: Limit, signal and kill-after delay.
+ *
+ * The command gets a process group of its own (and the terminal, when the
+ * shell has it), so the signal reaches everything it started. The shell
+ * waits in poll() on the child's pidfd and a timerfd instead of starting
+ * a separate timeout process.
+ * Returns: Command status; 124 if the limit passed, 128+SIGKILL if the
+ *          command was sent SIGKILL (as the signal, or after the
+ *          kill-after delay).
+ */
+int timeout_run(command_t *cmd, const timeout_opts_t *opts) {
+    int status = 0;
+
+    job_t *job = execute_async(cmd, -1, 0, &status);
+    if (!job) {
+        return status;
+    }
+
+    int owns_terminal = isatty(STDIN_FILENO) && tcgetpgrp(STDIN_FILENO) == getpgrp();
+    if (owns_terminal) {
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    }
+
+    int timed_out = 0;
+    int killed = 0;
+    if (!is_zero(&opts->duration) && !jobs_wait_until(job, &opts->duration)) {
+        timed_out = 1;
+        signal_job(job, opts->signal);
+        killed = opts->signal == SIGKILL;
+        if (!is_zero(&opts->kill_after) && !jobs_wait_until(job, &opts->kill_after)) {
+            signal_job(job, SIGKILL);
+            killed = 1;
+        }
+    }
+    status = jobs_wait(job, NULL);
+
+    if (owns_terminal) {
+        tcsetpgrp(STDIN_FILENO, getpgrp());
+    }
+
+    if (killed) {
+        return 128 + SIGKILL;
+    }
+    if (timed_out && !opts->preserve_status) {
+        return TIMEOUT_STATUS;
+    }
+    return status;
+}
@@ -1,5 +1,12 @@
 #define _GNU_SOURCE
 #include "utils.h"
+#include "arena.h"
+#include "cmdsubst.h"
+#include "lexer.h"
+#include "vars.h"
+#include "executor.h"
+#include "jobs.h"
+#include "pathglob.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <errno.h>
@@ -69,49 +76,36 @@ char *trim(char *str) {
 }
 
 /**
- * split_string - Split a string into tokens by delimiter (in-place, efficient).
- * @str: Input string (will be copied and modified).
+ * split_string - Split a string into tokens by delimiter.
+ * @str: Input string (copied, not modified).
  * @delim: Delimiter characters.
  * @count: Output pointer for number of tokens.
  *
- * Returns: NULL-terminated array of pointers to tokens (in a single buffer).
- *          Caller must free the returned array and the buffer (tokens[0]).
+ * The pointer array and a copy of @str share one allocation, so the tokens
+ * are not separately owned: release everything with a single free().
+ * Returns: NULL-terminated array of tokens, or NULL on error.
  */
 char **split_string(const char *str, const char *delim, int *count) {
     if (!str || !delim || !count) return NULL;
-    char *buffer = strdup_safe(str);
-    int capacity = 16;
-    int size = 0;
-    char **tokens = malloc(capacity * sizeof(char *));
-    if (!tokens) {
-        free(buffer);
-        return NULL;
+
+    // At most one token per delimiter run plus one
+    size_t len = strlen(str);
+    size_t max_tokens = 1;
+    for (const char *p = str; *p; p++) {
+        if (strchr(delim, *p)) max_tokens++;
     }
+
+    size_t array_size = (max_tokens + 1) * sizeof(char *);
+    char **tokens = malloc(array_size + len + 1);
+    if (!tokens) return NULL;
+    char *buffer = (char *)tokens + array_size;
+    memcpy(buffer, str, len + 1);
+
+    int size = 0;
     char *saveptr = NULL;
-    char *token = strtok_r(buffer, delim, &saveptr);
-    while (token) {
-        if (size >= capacity) {
-            capacity *= 2;
-            char **new_tokens = realloc(tokens, capacity * sizeof(char *));
-            if (!new_tokens) {
-                free(tokens);
-                free(buffer);
-                return NULL;
-            }
-            tokens = new_tokens;
-        }
+    for (char *token = strtok_r(buffer, delim, &saveptr); token;
+         token = strtok_r(NULL, delim, &saveptr)) {
         tokens[size++] = token;
-        token = strtok_r(NULL, delim, &saveptr);
-    }
-    if (size >= capacity) {
-        capacity++;
-        char **new_tokens = realloc(tokens, capacity * sizeof(char *));
-        if (!new_tokens) {
-            free(tokens);
-            free(buffer);
-            return NULL;
-        }
-        tokens = new_tokens;
     }
     tokens[size] = NULL;
     *count = size;
@@ -119,51 +113,27 @@ char **split_string(const char *str, const char *delim, int *count) {
 }
 
 /**
- * free_string_array - Free a NULL-terminated array of strings.
- * @array: Array to free.
- */
-void free_string_array(char **array) {
-    if (!array) return;
-    
-    for (int i = 0; array[i] != NULL; i++) {
-        free(array[i]);
-    }
-    free(array);
-}
-
-/**
- * free_split_string - Free the array and buffer returned by split_string.
- * @tokens: Array to free.
- */
-void free_split_string(char **tokens) {
-    if (!tokens) return;
-    free(tokens[0]); // buffer
-    free(tokens);
-}
-
-/**
- * get_env_var - Get the value of an environment variable.
+ * get_env_var - Get the value of a shell variable.
  * @name: Variable name.
  *
- * Returns: Value string or NULL if not found.
+ * Returns: Value string or NULL if not set.
  */
-char *get_env_var(const char *name) {
-    if (!name) return NULL;
-    return getenv(name);
+const char *get_env_var(const char *name) {
+    return vars_get(name);
 }
 
 /**
- * set_env_var - Set or unset an environment variable.
+ * set_env_var - Set and export, or unset, a shell variable.
  * @name: Variable name.
  * @value: Value to set, or NULL to unset.
  */
 void set_env_var(const char *name, const char *value) {
     if (!name) return;
-    
+
     if (value) {
-        setenv(name, value, 1);
+        vars_set(name, value, VAR_EXPORT);
     } else {
-        unsetenv(name);
+        vars_unset(name);
     }
 }
 
@@ -180,7 +150,7 @@ char *expand_tilde(const char *path) {
     
     if (path[1] == '\0' || path[1] == '/') {
         // Expand ~ to home directory
-        const char *home = getenv("HOME");
+        const char *home = vars_get("HOME");
         if (!home) {
             struct passwd *pw = getpwuid(getuid());
             home = pw ? pw->pw_dir : "/";
@@ -235,127 +205,280 @@ void print_system_error(const char *message) {
     print_error("%s: %s", message, strerror(errno));
 }
 
-/**
- * expand_env_var_in_string - Expand environment variables in a string.
- * @str: Input string (may contain $VAR or ${VAR}).
- *
- * Returns: Newly allocated string with variables expanded.
- */
-char *expand_env_var_in_string(const char *str) {
-    if (!str) return NULL;
-    
-    size_t bufsize = 64;
-    char *result = malloc(bufsize);
-    if (!result) return NULL;
-    result[0] = '\0';
-    size_t result_len = 0;
-    
+// Helper: look up a variable named by [name, name + len), including the
+// special parameters $?, $! and $PIPESTATUS (space-separated stage statuses)
+static const char *lookup_var(const char *name, size_t len) {
+    static char special[256];
+
+    if (len == 1 && name[0] == '?') {
+        snprintf(special, sizeof(special), "%d", get_last_status());
+        return special;
+    }
+    if (len == 1 && name[0] == '!') {
+        pid_t pid = jobs_last_background_pid();
+        if (pid <= 0) return NULL;
+        snprintf(special, sizeof(special), "%d", (int)pid);
+        return special;
+    }
+    if (len == 10 && memcmp(name, "PIPESTATUS", 10) == 0) {
+        int count;
+        const int *statuses = get_pipestatus(&count);
+        size_t used = 0;
+        special[0] = '\0';
+        for (int i = 0; i < count && used < sizeof(special); i++) {
+            used += snprintf(special + used, sizeof(special) - used, "%s%d",
+                             i > 0 ? " " : "", statuses[i]);
+        }
+        return special;
+    }
+    return vars_get_n(name, len);
+}
+
+// Helper: append @len bytes of @s, escaping glob bytes and backslashes
+// with a backslash when @pattern is set
+static void expand_append(arena_str_t *out, const char *s, size_t len, int pattern) {
+    if (!pattern) {
+        arena_str_append(out, s, len);
+        return;
+    }
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '*' || s[i] == '?' || s[i] == '[' || s[i] == '\\') {
+            arena_str_append(out, s + start, i - start);
+            arena_str_putc(out, '\\');
+            start = i;
+        }
+    }
+    arena_str_append(out, s + start, len - start);
+}
+
+// Helper: append the value of the variable named by [name, name + len)
+static void expand_append_var(arena_str_t *out, const char *name, size_t len, int pattern) {
+    const char *value = lookup_var(name, len);
+    if (value) {
+        expand_append(out, value, strlen(value), pattern);
+    }
+}
+
+// Helper: expand variables in @str and drop quote markers. With @pattern
+// the result is a pathglob pattern: quoted bytes, variable values and
+// backslashes are escaped, and only unquoted *, ? and [ stay active.
+static char *expand_word(arena_t *arena, const char *str, int pattern) {
+    arena_str_t out;
+    arena_str_init(&out, arena);
+
     const char *p = str;
     while (*p) {
-        if (*p == '$' && (p == str || *(p-1) != '\\')) {
-            p++;
-            if (*p == '{') {
+        if (*p == LEX_CTLESC) {
+            if (p[1]) {
+                if (pattern) arena_str_putc(&out, '\\');
+                arena_str_putc(&out, p[1]);
+                p += 2;
+            } else {
                 p++;
-                const char *var_start = p;
-                while (*p && *p != '}') p++;
-                if (*p == '}') {
-                    int var_len = p - var_start;
-                    char *var_name = malloc(var_len + 1);
-                    if (var_name) {
-                        strncpy(var_name, var_start, var_len);
-                        var_name[var_len] = '\0';
-                        const char *var_value = getenv(var_name);
-                        if (var_value) {
-                            size_t value_len = strlen(var_value);
-                            if (result_len + value_len + 1 > bufsize) {
-                                while (result_len + value_len + 1 > bufsize) bufsize *= 2;
-                                char *new_result = realloc(result, bufsize);
-                                if (!new_result) { free(result); free(var_name); return NULL; }
-                                result = new_result;
-                            }
-                            strcpy(result + result_len, var_value);
-                            result_len += value_len;
-                        }
-                        free(var_name);
-                    }
-                    p++; // Skip }
-                    continue;
-                }
-                // Invalid ${ format, treat as literal
-                if (result_len + 2 > bufsize) {
-                    bufsize *= 2;
-                    char *new_result = realloc(result, bufsize);
-                    if (!new_result) { free(result); return NULL; }
-                    result = new_result;
-                }
-                result[result_len++] = '$';
-                result[result_len++] = '{';
-                result[result_len] = '\0';
-                p = var_start - 1;
-            } else if (isalnum(*p) || *p == '_') {
-                const char *var_start = p;
-                while (*p && (isalnum(*p) || *p == '_')) p++;
-                int var_len = p - var_start;
-                char *var_name = malloc(var_len + 1);
-                if (var_name) {
-                    strncpy(var_name, var_start, var_len);
-                    var_name[var_len] = '\0';
-                    const char *var_value = getenv(var_name);
-                    if (var_value) {
-                        size_t value_len = strlen(var_value);
-                        if (result_len + value_len + 1 > bufsize) {
-                            while (result_len + value_len + 1 > bufsize) bufsize *= 2;
-                            char *new_result = realloc(result, bufsize);
-                            if (!new_result) { free(result); free(var_name); return NULL; }
-                            result = new_result;
-                        }
-                        strcpy(result + result_len, var_value);
-                        result_len += value_len;
-                    }
-                    free(var_name);
+            }
+            continue;
+        }
+        if (*p != '$') {
+            // Copy the run of regular characters up to the next $ or marker
+            const char *run = p++;
+            while (*p && *p != '$' && *p != LEX_CTLESC) p++;
+            if (pattern) {
+                // Glob bytes in the run are the active ones; only a
+                // backslash needs escaping
+                for (const char *q = run; q < p; q++) {
+                    if (*q == '\\') arena_str_putc(&out, '\\');
+                    arena_str_putc(&out, *q);
                 }
-                continue;
             } else {
-                // Just a $, keep it
-                if (result_len + 1 + 1 > bufsize) {
-                    bufsize *= 2;
-                    char *new_result = realloc(result, bufsize);
-                    if (!new_result) { free(result); return NULL; }
-                    result = new_result;
-                }
-                result[result_len++] = '$';
-                result[result_len] = '\0';
+                arena_str_append(&out, run, p - run);
+            }
+            continue;
+        }
+
+        p++;
+        if (*p == '{') {
+            const char *close = strchr(p + 1, '}');
+            if (!close) {
+                // Invalid ${ format, treat as literal
+                arena_str_append(&out, "${", 2);
+                p++;
                 continue;
             }
+            expand_append_var(&out, p + 1, close - (p + 1), pattern);
+            p = close + 1;
+        } else if (*p == '?' || *p == '!') {
+            expand_append_var(&out, p, 1, pattern);
+            p++;
+        } else if (p[0] == LEX_CTLESC && p[1] == '?') {
+            // "$?": the lexer marks a quoted ? so it is not globbed
+            expand_append_var(&out, p + 1, 1, pattern);
+            p += 2;
+        } else if (isalnum((unsigned char)*p) || *p == '_') {
+            const char *name = p;
+            while (*p && (isalnum((unsigned char)*p) || *p == '_')) p++;
+            expand_append_var(&out, name, p - name, pattern);
         } else {
-            // Regular character
-            if (result_len + 1 + 1 > bufsize) {
-                bufsize *= 2;
-                char *new_result = realloc(result, bufsize);
-                if (!new_result) { free(result); return NULL; }
-                result = new_result;
+            // Just a $, keep it
+            arena_str_putc(&out, '$');
+        }
+    }
+    return out.data;
+}
+
+// Helper: find the next LEX_CTLESC LEX_CMDSUB_OPEN marker in a lexer word
+static const char *find_cmdsub(const char *p) {
+    while ((p = strchr(p, LEX_CTLESC)) != NULL) {
+        if (p[1] == LEX_CMDSUB_OPEN) return p;
+        if (!p[1]) break;
+        p += 2;
+    }
+    return NULL;
+}
+
+// Helper: run the $(...) in lexer word @str and splice in their output,
+// marked as quoted so it is neither expanded again nor globbed.
+// Returns: @str itself when it has no substitution.
+static char *substitute_commands(arena_t *arena, char *str) {
+    const char *open = find_cmdsub(str);
+    if (!open) return str;
+
+    arena_str_t out;
+    arena_str_init(&out, arena);
+    const char *p = str;
+    while (open) {
+        arena_str_append(&out, p, open - p);
+
+        // Undo the lexer's doubling of markers in the command text
+        const char *q = open + 2;
+        const char *end = q;
+        while (*end && !(end[0] == LEX_CTLESC && end[1] == LEX_CMDSUB_CLOSE)) {
+            end += (end[0] == LEX_CTLESC && end[1]) ? 2 : 1;
+        }
+        char *text = arena_alloc(arena, end - q + 1);
+        size_t text_len = 0;
+        for (; q < end; q++) {
+            if (*q == LEX_CTLESC && q + 1 < end) q++;
+            text[text_len++] = *q;
+        }
+        text[text_len] = '\0';
+
+        size_t len;
+        const char *output = cmdsubst_run(arena, text, &len);
+        for (size_t i = 0; i < len; i++) {
+            char c = output[i];
+            if (c == '$' || c == LEX_CTLESC || c == '*' || c == '?' || c == '[') {
+                arena_str_putc(&out, LEX_CTLESC);
             }
-            result[result_len++] = *p;
-            result[result_len] = '\0';
+            arena_str_putc(&out, c);
         }
-        p++;
+
+        p = *end ? end + 2 : end;
+        open = find_cmdsub(p);
     }
-    return result;
+    arena_str_append(&out, p, strlen(p));
+    return out.data;
 }
 
 /**
- * expand_env_vars - Expand environment variables in all command arguments.
+ * expand_env_var_in_string - Expand environment variables in a string.
+ * @arena: Arena that receives the result.
+ * @str: Word from the lexer (may contain $VAR, ${VAR} and quote markers).
+ *
+ * A byte after LEX_CTLESC was quoted in the source: it is copied literally
+ * and the marker is dropped, so '$HOME' and \$HOME are not expanded.
+ * Command substitutions run first, left to right.
+ * Returns: Expanded string allocated from @arena, or NULL if @str is NULL.
+ */
+char *expand_env_var_in_string(arena_t *arena, const char *str) {
+    if (!str) return NULL;
+    return expand_word(arena, substitute_commands(arena, (char *)str), 0);
+}
+
+// Helper: check a lexer word for a *, ? or [ that was not quoted
+static int has_unquoted_glob(const char *str) {
+    for (const char *p = str; *p; p++) {
+        if (*p == LEX_CTLESC) {
+            if (!p[1]) break;
+            p++;
+        } else if (*p == '*' || *p == '?' || *p == '[') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Helper: replace argument @index of @cmd by the names matching it.
+// Returns: Number of arguments now in its place (1 when nothing matched).
+static int expand_glob_arg(arena_t *arena, command_t *cmd, int index) {
+    char **matches;
+    char *pattern = expand_word(arena, cmd->args[index], 1);
+    size_t count = pathglob_expand(arena, pattern, &matches);
+    if (count == 0) {
+        // No match: the word stays, with its quoting removed
+        cmd->args[index] = expand_word(arena, cmd->args[index], 0);
+        return 1;
+    }
+
+    int argc = cmd->argc - 1 + (int)count;
+    char **args = arena_alloc(arena, (argc + 1) * sizeof(char *));
+    if (!args) {
+        cmd->args[index] = expand_word(arena, cmd->args[index], 0);
+        return 1;
+    }
+    memcpy(args, cmd->args, index * sizeof(char *));
+    memcpy(args + index, matches, count * sizeof(char *));
+    memcpy(args + index + count, cmd->args + index + 1,
+           (cmd->argc - index - 1) * sizeof(char *));
+    args[argc] = NULL;
+    cmd->args = args;
+    cmd->argc = argc;
+    return (int)count;
+}
+
+/**
+ * expand_env_vars - Expand variables in command arguments, assignments and
+ * redirection targets.
+ * @arena: Arena that receives the expanded strings.
  * @cmd: Command structure to process.
+ *
+ * Words without a $ or a quote marker are left as they are. Command
+ * substitutions run first; their output is not expanded again. An argument
+ * with an unquoted *, ? or [ is then replaced by the sorted names that
+ * match it, if any; assignments and redirection targets are not globbed.
+ * Returns: 0, or -1 if an expansion failed (an arithmetic error was
+ *          printed) and the command must not run.
  */
-void expand_env_vars(command_t *cmd) {
-    if (!cmd || !cmd->args) return;
-    for (int i = 0; i < cmd->argc; i++) {
-        if (cmd->args[i] && strchr(cmd->args[i], '$')) { // Only expand if '$' present
-            char *expanded = expand_env_var_in_string(cmd->args[i]);
-            if (expanded) {
-                free(cmd->args[i]);
-                cmd->args[i] = expanded;
+int expand_env_vars(arena_t *arena, command_t *cmd) {
+    if (!cmd) return 0;
+    for (int i = 0; cmd->args && i < cmd->argc;) {
+        if (!cmd->args[i]) {
+            i++;
+            continue;
+        }
+        // Once, before globbing, which may expand the word twice
+        cmd->args[i] = substitute_commands(arena, cmd->args[i]);
+        if (has_unquoted_glob(cmd->args[i])) {
+            i += expand_glob_arg(arena, cmd, i);
+        } else {
+            if (strpbrk(cmd->args[i], LEX_SPECIAL_BYTES)) {
+                cmd->args[i] = expand_env_var_in_string(arena, cmd->args[i]);
             }
+            i++;
+        }
+    }
+    for (int i = 0; i < cmd->assign_count; i++) {
+        if (strpbrk(cmd->assigns[i], LEX_SPECIAL_BYTES)) {
+            cmd->assigns[i] = expand_env_var_in_string(arena, cmd->assigns[i]);
+        }
+    }
+    for (redirect_t *r = cmd->redirects; r; r = r->next) {
+        if (r->type == REDIR_HEREDOC && !(r->flags & HEREDOC_EXPAND)) {
+            continue;  // Quoted delimiter: the body is used as written
+        }
+        if (strpbrk(r->target, LEX_SPECIAL_BYTES)) {
+            r->target = expand_env_var_in_string(arena, r->target);
         }
     }
+    return cmdsubst_take_error() ? -1 : 0;
 }
@@ -0,0 +1,435 @@
+#include "vars.h"
+#include "cmdhash.h"
+#include "outbuf.h"
+#include "utils.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VARS_INITIAL_BUCKETS 128
+
+extern char **environ;
+
+// One variable; the value lives in the same "NAME=value" string handed to
+// exec, so exporting never copies
+typedef struct var {
+    char *assignment;           // "NAME=value", or just "NAME" when unset
+    size_t name_len;
+    int has_value;
+    unsigned flags;
+    struct var *next;           // Next variable in the same bucket
+} var_t;
+
+static var_t **buckets = NULL;
+static size_t bucket_count = 0;
+static size_t var_count = 0;
+static int initialized = 0;
+
+// Exported environment cache
+static unsigned long generation = 1;
+static unsigned long envp_generation = 0;
+static char **envp_cache = NULL;
+static size_t envp_capacity = 0;
+
+// Helper: FNV-1a hash of a name of known length
+static size_t hash_name(const char *name, size_t len) {
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Helper: double the bucket array once the load factor passes 3/4
+static void grow_buckets(void) {
+    size_t new_count = bucket_count ? bucket_count * 2 : VARS_INITIAL_BUCKETS;
+    var_t **new_buckets = calloc(new_count, sizeof(var_t *));
+    if (!new_buckets) return;  // Keep the old, fuller table
+
+    for (size_t i = 0; i < bucket_count; i++) {
+        var_t *var = buckets[i];
+        while (var) {
+            var_t *next = var->next;
+            size_t slot = hash_name(var->assignment, var->name_len) & (new_count - 1);
+            var->next = new_buckets[slot];
+            new_buckets[slot] = var;
+            var = next;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+}
+
+// Helper: import environ on first use
+static void ensure_init(void) {
+    if (!initialized) {
+        vars_init(environ);
+    }
+}
+
+// Helper: find the variable for a name of known length
+static var_t *find_var(const char *name, size_t len) {
+    ensure_init();
+    if (!buckets) return NULL;
+    var_t *var = buckets[hash_name(name, len) & (bucket_count - 1)];
+    while (var && (var->name_len != len || memcmp(var->assignment, name, len) != 0)) {
+        var = var->next;
+    }
+    return var;
+}
+
+// Helper: store "NAME=value" (or "NAME") for a variable
+static void store_value(var_t *var, const char *name, size_t len, const char *value) {
+    size_t value_len = value ? strlen(value) : 0;
+    char *assignment = malloc(len + 1 + value_len + 1);
+    if (!assignment) {
+        print_error("out of memory");
+        exit(1);
+    }
+    memcpy(assignment, name, len);
+    if (value) {
+        assignment[len] = '=';
+        memcpy(assignment + len + 1, value, value_len + 1);
+    } else {
+        assignment[len] = '\0';
+    }
+    free(var->assignment);
+    var->assignment = assignment;
+    var->has_value = value != NULL;
+}
+
+// Helper: find or create a variable; @value NULL keeps an existing value
+static var_t *set_var(const char *name, size_t len, const char *value, unsigned flags) {
+    var_t *var = find_var(name, len);
+    if (!var) {
+        if (var_count + 1 > bucket_count / 4 * 3) {
+            grow_buckets();
+            if (!buckets) return NULL;
+        }
+        var = calloc(1, sizeof(var_t));
+        if (!var) return NULL;
+        var->name_len = len;
+        store_value(var, name, len, value);
+
+        size_t slot = hash_name(name, len) & (bucket_count - 1);
+        var->next = buckets[slot];
+        buckets[slot] = var;
+        var_count++;
+    } else if (value) {
+        store_value(var, name, len, value);
+    }
+
+    unsigned old_flags = var->flags;
+    var->flags |= flags;
+    if ((var->flags & VAR_EXPORT) && (value || !(old_flags & VAR_EXPORT))) {
+        generation++;
+    }
+
+    // Remembered command locations depend on the search path
+    if (value && len == 4 && memcmp(name, "PATH", 4) == 0) {
+        cmdhash_clear();
+    }
+    return var;
+}
+
+/**
+ * vars_init - Load the process environment into the variable table.
+ * @envp: NULL-terminated "NAME=value" array (usually environ).
+ *
+ * Every entry becomes an exported variable. Entries without '=' or with an
+ * invalid name are skipped.
+ */
+void vars_init(char **envp) {
+    initialized = 1;
+    if (!buckets) {
+        grow_buckets();
+    }
+    for (char **entry = envp; entry && *entry; entry++) {
+        const char *equals = strchr(*entry, '=');
+        if (!equals || !vars_valid_name(*entry, equals - *entry)) continue;
+        set_var(*entry, equals - *entry, equals + 1, VAR_EXPORT);
+    }
+}
+
+/**
+ * vars_get - Get the value of a variable.
+ * @name: Variable name.
+ *
+ * Returns: Value owned by the table, or NULL if unset.
+ */
+const char *vars_get(const char *name) {
+    if (!name) return NULL;
+    return vars_get_n(name, strlen(name));
+}
+
+/**
+ * vars_get_n - Get the value of a variable named by a substring.
+ * @name: Start of the name.
+ * @len: Length of the name.
+ *
+ * Lets expansion look up $NAME in place without copying the name.
+ * Returns: Value owned by the table, or NULL if unset.
+ */
+const char *vars_get_n(const char *name, size_t len) {
+    var_t *var = find_var(name, len);
+    if (!var || !var->has_value) return NULL;
+    return var->assignment + len + 1;
+}
+
+/**
+ * vars_set - Set a variable.
+ * @name: Variable name.
+ * @value: New value.
+ * @flags: Flags to add (VAR_EXPORT).
+ *
+ * Returns: 0 on success, -1 if @name is not a valid name.
+ */
+int vars_set(const char *name, const char *value, unsigned flags) {
+    if (!name || !value) return -1;
+    size_t len = strlen(name);
+    if (!vars_valid_name(name, len)) return -1;
+    return set_var(name, len, value, flags) ? 0 : -1;
+}
+
+/**
+ * vars_assign - Apply an assignment word.
+ * @assignment: "NAME=value".
+ * @flags: Flags to add (VAR_EXPORT).
+ *
+ * Returns: 0 on success, -1 if the word is not a valid assignment.
+ */
+int vars_assign(const char *assignment, unsigned flags) {
+    const char *equals = assignment ? strchr(assignment, '=') : NULL;
+    if (!equals || !vars_valid_name(assignment, equals - assignment)) return -1;
+    return set_var(assignment, equals - assignment, equals + 1, flags) ? 0 : -1;
+}
+
+/**
+ * vars_export - Mark a variable for export.
+ * @name: Variable name.
+ *
+ * A variable without a value is remembered as exported and reaches the
+ * environment once it is given one.
+ * Returns: 0 on success, -1 if @name is not a valid name.
+ */
+int vars_export(const char *name) {
+    if (!name) return -1;
+    size_t len = strlen(name);
+    if (!vars_valid_name(name, len)) return -1;
+    return set_var(name, len, NULL, VAR_EXPORT) ? 0 : -1;
+}
+
+/**
+ * vars_unset - Remove a variable.
+ * @name: Variable name.
+ */
+void vars_unset(const char *name) {
+    if (!name) return;
+    size_t len = strlen(name);
+    ensure_init();
+    if (!buckets) return;
+
+    var_t **link = &buckets[hash_name(name, len) & (bucket_count - 1)];
+    while (*link) {
+        var_t *var = *link;
+        if (var->name_len == len && memcmp(var->assignment, name, len) == 0) {
+            *link = var->next;
+            if (var->flags & VAR_EXPORT) {
+                generation++;
+            }
+            free(var->assignment);
+            free(var);
+            var_count--;
+            return;
+        }
+        link = &var->next;
+    }
+}
+
+/**
+ * vars_valid_name - Check a variable name.
+ * @name: Start of the name.
+ * @len: Length of the name.
+ *
+ * Returns: 1 for [A-Za-z_][A-Za-z0-9_]*, 0 otherwise.
+ */
+int vars_valid_name(const char *name, size_t len) {
+    if (len == 0 || (!isalpha((unsigned char)name[0]) && name[0] != '_')) return 0;
+    for (size_t i = 1; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') return 0;
+    }
+    return 1;
+}
+
+/**
+ * vars_generation - Get the export generation counter.
+ *
+ * Returns: Value that changes whenever the exported environment does.
+ */
+unsigned long vars_generation(void) {
+    return generation;
+}
+
+/**
+ * vars_envp - Get the exported environment for exec.
+ *
+ * The array points at the variables' own "NAME=value" strings. It is only
+ * rebuilt when an export changed since the previous call, so launching a
+ * command normally costs nothing here.
+ * Returns: NULL-terminated array owned by the table.
+ */
+char *const *vars_envp(void) {
+    ensure_init();
+    if (envp_cache && envp_generation == generation) {
+        return envp_cache;
+    }
+
+    if (var_count + 1 > envp_capacity) {
+        size_t new_capacity = envp_capacity ? envp_capacity : 64;
+        while (var_count + 1 > new_capacity) new_capacity *= 2;
+        char **grown = realloc(envp_cache, new_capacity * sizeof(char *));
+        if (!grown) {
+            print_error("out of memory");
+            exit(1);
+        }
+        envp_cache = grown;
+        envp_capacity = new_capacity;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < bucket_count; i++) {
+        for (var_t *var = buckets[i]; var; var = var->next) {
+            if ((var->flags & VAR_EXPORT) && var->has_value) {
+                envp_cache[count++] = var->assignment;
+            }
+        }
+    }
+    envp_cache[count] = NULL;
+    envp_generation = generation;
+    return envp_cache;
+}
+
+/**
+ * vars_envp_overlay - Build an environment with extra assignments.
+ * @assignments: "NAME=value" words (e.g. FOO=1 in `FOO=1 cmd`).
+ * @count: Number of words.
+ *
+ * Exported variables named by an assignment are replaced; the rest are
+ * appended. Later assignments to the same name win.
+ * Returns: malloc'd NULL-terminated array (free() it; strings are borrowed).
+ */
+char **vars_envp_overlay(char *const *assignments, int count) {
+    char *const *base = vars_envp();
+    size_t base_count = 0;
+    while (base[base_count]) base_count++;
+
+    char **envp = malloc((base_count + count + 1) * sizeof(char *));
+    if (!envp) return NULL;
+
+    size_t n = 0;
+    for (size_t i = 0; i < base_count; i++) {
+        size_t len = strcspn(base[i], "=");
+        int replaced = 0;
+        for (int j = 0; j < count && !replaced; j++) {
+            replaced = strncmp(assignments[j], base[i], len) == 0 && assignments[j][len] == '=';
+        }
+        if (!replaced) envp[n++] = base[i];
+    }
+    for (int j = 0; j < count; j++) {
+        size_t len = strcspn(assignments[j], "=");
+        int shadowed = 0;
+        for (int k = j + 1; k < count && !shadowed; k++) {
+            shadowed = strncmp(assignments[k], assignments[j], len + 1) == 0;
+        }
+        if (!shadowed) envp[n++] = assignments[j];
+    }
+    envp[n] = NULL;
+    return envp;
+}
+
+// Helper: compare variables by name for sorted listing
+static int compare_vars(const void *a, const void *b) {
+    const var_t *x = *(var_t *const *)a, *y = *(var_t *const *)b;
+    size_t len = x->name_len < y->name_len ? x->name_len : y->name_len;
+    int diff = memcmp(x->assignment, y->assignment, len);
+    return diff ? diff : (x->name_len > y->name_len) - (x->name_len < y->name_len);
+}
+
+/**
+ * vars_each - Visit every variable name.
+ * @func: Called with each name (not NUL-terminated) and its length.
+ * @ctx: Passed through to @func.
+ *
+ * Names come in hash order; a non-zero return from @func stops the walk.
+ */
+void vars_each(vars_each_fn func, void *ctx) {
+    ensure_init();
+    for (size_t i = 0; i < bucket_count; i++) {
+        for (var_t *var = buckets[i]; var; var = var->next) {
+            if (func(var->assignment, var->name_len, ctx) != 0) return;
+        }
+    }
+}
+
+/**
+ * vars_print_exported - Print exported variables, sorted, in a form that
+ * can be read back.
+ */
+void vars_print_exported(void) {
+    ensure_init();
+    var_t **list = malloc((var_count + 1) * sizeof(var_t *));
+    if (!list) return;
+
+    size_t count = 0;
+    for (size_t i = 0; i < bucket_count; i++) {
+        for (var_t *var = buckets[i]; var; var = var->next) {
+            if (var->flags & VAR_EXPORT) list[count++] = var;
+        }
+    }
+    qsort(list, count, sizeof(var_t *), compare_vars);
+
+    for (size_t i = 0; i < count; i++) {
+        var_t *var = list[i];
+        if (!var->has_value) {
+            outbuf_printf("export %s\n", var->assignment);
+            continue;
+        }
+        outbuf_printf("export %.*s=\"", (int)var->name_len, var->assignment);
+        for (const char *p = var->assignment + var->name_len + 1; *p; ) {
+            size_t run = strcspn(p, "\"\\$`");
+            outbuf_write(p, run);
+            p += run;
+            if (*p) {
+                outbuf_write("\\", 1);
+                outbuf_write(p++, 1);
+            }
+        }
+        outbuf_puts("\"\n");
+    }
+    free(list);
+}
+
+/**
+ * vars_destroy - Free every variable and the environment cache.
+ */
+void vars_destroy(void) {
+    for (size_t i = 0; i < bucket_count; i++) {
+        var_t *var = buckets[i];
+        while (var) {
+            var_t *next = var->next;
+            free(var->assignment);
+            free(var);
+            var = next;
+        }
+    }
+    free(buckets);
+    free(envp_cache);
+    buckets = NULL;
+    envp_cache = NULL;
+    bucket_count = var_count = envp_capacity = 0;
+    initialized = 0;
+    generation++;
+}